@@ -0,0 +1,120 @@
+// Round trip latency of small ping-pongs over loopback, first through the plain reactor loop and then through a
+// busy-polling one. The echo peer runs on its own thread with blocking sockets so only the client side differs
+// between runs. Busy polling only pays off when the polling thread and the peer have cores of their own.
+//
+// usage: bench_latency [round trips] [busy poll budget in us]
+#include <Async/BusyPoll.hpp>
+#include <Async/Detached.hpp>
+#include <Async/Executor.hpp>
+#include <Async/Reactor.hpp>
+#include <Async/TcpListener.hpp>
+#include <Async/TcpStream.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <thread>
+#include <vector>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t MessageSize = 64;
+
+auto Echo(int listenFd, int connections) -> void
+{
+  for (int i = 0; i < connections; i++) {
+    auto fd = ::accept(listenFd, nullptr, nullptr);
+    auto one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    char buf[MessageSize];
+    while (true) {
+      auto n = ::recv(fd, buf, sizeof(buf), MSG_WAITALL);
+      if (n <= 0 || ::send(fd, buf, n, MSG_NOSIGNAL) != n) {
+        break;
+      }
+    }
+    ::close(fd);
+  }
+}
+
+auto PingPong(async::SocketAddr addr, int iterations, std::vector<Clock::duration>& samples) -> async::Task<>
+{
+  auto stream = co_await async::TcpStream::Connect(RT::GetReactor(), addr);
+  if (!stream) {
+    std::cerr << "connect: " << std::make_error_code(stream.error()).message() << std::endl;
+    co_return;
+  }
+  stream->setOptions(async::SocketOptions::LowLatency());
+  auto buf = std::array<std::byte, MessageSize> {};
+  for (int i = 0; i < iterations; i++) {
+    auto start = Clock::now();
+    if (auto n = co_await stream->send(buf); !n || std::size_t(*n) != buf.size()) {
+      co_return;
+    }
+    for (std::size_t received = 0; received < buf.size();) {
+      auto n = co_await stream->recv(std::span(buf).subspan(received));
+      if (!n || *n == 0) {
+        co_return;
+      }
+      received += std::size_t(*n);
+    }
+    samples.push_back(Clock::now() - start);
+  }
+}
+
+// Runs the ping-pongs on the runtime's reactor, polled by a BusyPoll loop with `budget`.
+auto Run(async::SocketAddr addr, int iterations, std::chrono::nanoseconds budget) -> std::vector<Clock::duration>
+{
+  auto samples = std::vector<Clock::duration> {};
+  samples.reserve(iterations);
+  auto done = false;
+  async::detail::Detach([](async::SocketAddr addr, int iterations, std::vector<Clock::duration>& samples,
+                           bool& done) -> async::Task<> {
+    co_await PingPong(addr, iterations, samples);
+    done = true;
+  }(addr, iterations, samples, done))
+      .handle.resume();
+  async::BusyPoll(RT::GetReactor(), budget).run([&] { return done; });
+  return samples;
+}
+
+auto Report(char const* name, std::vector<Clock::duration>& samples) -> void
+{
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) {
+    auto index = std::min(samples.size() - 1, std::size_t(q * double(samples.size())));
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(samples[index]).count() / 1000.0;
+  };
+  std::cout << name << ": p50 " << at(0.5) << "us p99 " << at(0.99) << "us p99.9 " << at(0.999) << "us max "
+            << at(1.0) << "us (" << samples.size() << " round trips)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  auto iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  auto budget = std::chrono::microseconds(argc > 2 ? std::atoi(argv[2]) : 50);
+  RT::Init();
+
+  auto listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+  auto sin = sockaddr_in {};
+  sin.sin_family = AF_INET;
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto len = socklen_t(sizeof(sin));
+  if (::bind(listenFd, (sockaddr*)&sin, len) != 0 || ::listen(listenFd, 16) != 0 ||
+      ::getsockname(listenFd, (sockaddr*)&sin, &len) != 0) {
+    std::cerr << "cannot listen on loopback" << std::endl;
+    return 1;
+  }
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(ntohs(sin.sin_port)));
+  auto echo = std::thread(Echo, listenFd, 2);
+
+  auto samples = Run(addr, iterations, std::chrono::nanoseconds(0));
+  Report("reactor", samples);
+  samples = Run(addr, iterations, budget);
+  Report("busy poll", samples);
+
+  echo.join();
+  ::close(listenFd);
+}
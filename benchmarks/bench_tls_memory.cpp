@@ -0,0 +1,108 @@
+// Heap held by idle TLS connections, with and without TlsContext::setLeanIdle. Every connection completes a handshake
+// and one request/response exchange, then both ends sit in recv. Each mode runs in a child process so the heap of one
+// run does not skew the other. Numbers cover both endpoints of a connection.
+//
+// usage: bench_tls_memory [connections]
+#include <Async/Executor.hpp>
+#include <Async/SslListener.hpp>
+#include <Async/SslStream.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "TlsTestUtil.hpp"
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+constexpr std::uint16_t Port = 39453;
+
+auto HeapInUse() -> std::size_t { return mallinfo2().uordblks; }
+
+auto Serve(async::SslSocket stream) -> async::Task<>
+{
+  auto buf = std::array<std::byte, 64> {};
+  while (true) {
+    auto n = co_await stream.recv(buf);
+    if (!n && n.error().wait()) {
+      continue;
+    } else if (!n || *n == 0 || !co_await stream.sendAll(std::span(buf).first(*n))) {
+      co_return;
+    }
+  }
+}
+
+auto Accept(async::SslListener& listener, async::TlsContext& ctx, int connections) -> async::Task<>
+{
+  for (int i = 0; i < connections; i++) {
+    if (auto stream = co_await listener.accept(ctx, nullptr); stream) {
+      RT::SpawnDetach(Serve(std::move(stream).value()));
+    }
+  }
+}
+
+auto Measure(bool lean, int connections) -> void
+{
+  RT::Init();
+  auto serverCtx = async::TlsContext::Create().value();
+  auto clientCtx = async::TlsContext::Create().value();
+  if (!UseSelfSigned(serverCtx)) {
+    std::cerr << "cannot create certificate: " << async::OpenSSLError::GetLastErrMsg() << std::endl;
+    return;
+  }
+  SSL_CTX_set_verify(clientCtx.raw(), SSL_VERIFY_NONE, nullptr);
+  serverCtx.setLeanIdle(lean);
+  clientCtx.setLeanIdle(lean);
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(Port));
+  auto listener = async::SslListener::Bind(serverCtx, RT::GetReactor(), addr);
+  if (!listener) {
+    std::cerr << "bind: " << listener.error() << std::endl;
+    return;
+  }
+  RT::SpawnDetach(Accept(*listener, serverCtx, connections));
+  RT::Block([](async::TlsContext& ctx, async::SocketAddr addr, bool lean, int connections) -> async::Task<> {
+    auto before = HeapInUse();
+    auto streams = std::vector<async::SslStream> {};
+    streams.reserve(connections);
+    auto request = std::array<std::byte, 16> {};
+    auto buf = std::array<std::byte, 64> {};
+    for (int i = 0; i < connections; i++) {
+      auto stream = co_await async::SslStream::Connect(ctx, RT::GetReactor(), addr);
+      if (!stream || !co_await stream->sendAll(request)) {
+        std::cerr << "connection " << i << " failed" << std::endl;
+        co_return;
+      }
+      while (true) {
+        if (auto n = co_await stream->recv(buf); n || !n.error().wait()) {
+          break;
+        }
+      }
+      streams.push_back(std::move(stream).value());
+    }
+    // every server already went back to recv before its response reached the client
+    auto perConnection = (HeapInUse() - before) / std::size_t(connections);
+    std::cout << (lean ? "lean idle" : "default") << ": " << perConnection << " bytes per idle connection ("
+              << connections << " connections)" << std::endl;
+  }(clientCtx, addr, lean, connections));
+}
+
+int main(int argc, char** argv)
+{
+  auto connections = argc > 1 ? std::atoi(argv[1]) : 500;
+  auto limit = rlimit {};
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &limit);
+  connections = std::min<int>(connections, int(limit.rlim_cur / 2) - 16);
+  for (auto lean : {false, true}) {
+    if (auto pid = ::fork(); pid == 0) {
+      Measure(lean, connections);
+      std::cout.flush();
+      ::_exit(0);
+    } else if (pid > 0) {
+      ::waitpid(pid, nullptr, 0);
+    }
+  }
+}
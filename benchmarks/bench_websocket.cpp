@@ -0,0 +1,93 @@
+// WebSocket throughput over loopback for small and large messages. The client sends masked frames, so the server
+// side measures frame parsing plus unmasking; the server answers the last message to mark the end of a run. A second
+// section times ApplyMask alone on a large buffer.
+//
+// usage: bench_websocket [megabytes per run]
+#include <Async/Executor.hpp>
+#include <Async/TcpListener.hpp>
+#include <Async/TcpStream.hpp>
+#include <Async/http/WebSocket.hpp>
+#include <cstdlib>
+#include <iostream>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using Clock = std::chrono::steady_clock;
+namespace ws = async::http::ws;
+
+constexpr std::uint16_t Port = 39455;
+
+auto Sink(async::TcpListener& listener, int runs) -> async::Task<>
+{
+  for (int i = 0; i < runs; i++) {
+    auto stream = co_await listener.accept(nullptr);
+    if (!stream) {
+      co_return;
+    }
+    auto socket = co_await async::http::AcceptWebSocket(std::move(stream).value());
+    if (!socket) {
+      co_return;
+    }
+    while (true) {
+      auto message = co_await socket->receive();
+      if (!message || message->opcode == ws::Opcode::Close) {
+        break;
+      } else if (message->opcode == ws::Opcode::Text) { // end of run
+        co_await socket->sendText("done");
+      }
+    }
+  }
+}
+
+auto Source(async::SocketAddr addr, std::size_t messageSize, std::size_t total) -> async::Task<>
+{
+  auto stream = co_await async::TcpStream::Connect(RT::GetReactor(), addr);
+  if (!stream) {
+    co_return;
+  }
+  auto socket = co_await async::http::ConnectWebSocket(std::move(stream).value(), "localhost", "/");
+  if (!socket) {
+    std::cerr << "handshake failed" << std::endl;
+    co_return;
+  }
+  auto payload = std::vector<std::byte>(messageSize, std::byte('a'));
+  auto count = total / messageSize;
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < count; i++) {
+    if (!co_await socket->send(payload)) {
+      co_return;
+    }
+  }
+  co_await socket->sendText("end");
+  co_await socket->receive();
+  auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << messageSize << " byte messages: " << count / seconds / 1e3 << "k msg/s, "
+            << double(count * messageSize) / seconds / (1 << 20) << " MB/s" << std::endl;
+  co_await socket->close();
+  co_await socket->receive();
+}
+
+int main(int argc, char** argv)
+{
+  auto total = std::size_t(argc > 1 ? std::atoi(argv[1]) : 256) << 20;
+  RT::Init();
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(Port));
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), addr);
+  if (!listener) {
+    std::cerr << "bind: " << std::make_error_code(listener.error()).message() << std::endl;
+    return 1;
+  }
+  auto const sizes = {std::size_t(64), std::size_t(1024), std::size_t(64) << 10, std::size_t(1) << 20};
+  RT::SpawnDetach(Sink(*listener, int(sizes.size())));
+  for (auto size : sizes) {
+    RT::Block(Source(addr, size, std::max(total / (size < 4096 ? 16 : 1), size)));
+  }
+
+  auto buffer = std::vector<std::byte>(64 << 20);
+  auto mask = ws::NewMask();
+  auto start = Clock::now();
+  for (int i = 0; i < 16; i++) {
+    ws::ApplyMask(buffer, mask, std::size_t(i));
+  }
+  auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "ApplyMask: " << 16.0 * double(buffer.size()) / seconds / (1 << 30) << " GB/s" << std::endl;
+}
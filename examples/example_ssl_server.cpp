@@ -1,3 +1,4 @@
+#include <Async/BufferPool.hpp>
 #include <Async/Executor.hpp>
 #include <Async/Reactor.hpp>
 #include <Async/SslListener.hpp>
@@ -25,9 +26,9 @@ int main()
         continue;
       }
       auto stream = std::move(conn).value();
-      auto buf = std::array<uint8_t, 1024> {};
-      auto span = std::as_writable_bytes(std::span(buf));
-      auto recv = co_await stream.recv(span);
+      co_await stream.readable(); // borrow a buffer only once the request is there
+      auto buf = async::BufferPool::Local().acquire();
+      auto recv = co_await stream.recv(buf.span());
       if (!recv) {
         std::cout << "recv error: " << recv.error().message() << '\n';
         co_return;
@@ -0,0 +1,31 @@
+#include <Async/Executor.hpp>
+#include <Async/Reactor.hpp>
+#include <Async/TcpListener.hpp>
+#include <Async/http/FileCache.hpp>
+#include <cstring>
+#include <iostream>
+int main(int argc, char** argv)
+{
+  using RT = async::Runtime<async::MultiThreadExecutor>;
+  RT::Init(4);
+  auto cache = async::http::FileCache(argc > 1 ? argv[1] : ".");
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Any(8080));
+  if (!listener) {
+    std::cout << "bind error: " << strerror(int(listener.error())) << std::endl;
+    return 1;
+  }
+  RT::Block([](async::TcpListener listener, async::http::FileCache& cache) -> async::Task<> {
+    while (true) {
+      auto stream = co_await listener.accept(nullptr);
+      if (!stream) {
+        std::cout << "accept error: " << strerror(int(stream.error())) << std::endl;
+        continue;
+      }
+      RT::SpawnDetach(async::http::Serve(
+          async::TcpStream(std::move(stream).value()),
+          [&cache](async::http::Request const& req, async::http::ResponseWriter& res) {
+            async::http::ServeFile(cache, req, res);
+          }));
+    }
+  }(std::move(listener).value(), cache));
+}
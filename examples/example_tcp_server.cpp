@@ -1,6 +1,8 @@
 #include <Async/Executor.hpp>
 #include <Async/Reactor.hpp>
 #include <Async/TcpListener.hpp>
+#include <Async/TimerFd.hpp>
+#include <Async/http/HttpServer.hpp>
 #include <cstring>
 #include <iostream>
 using namespace std::literals;
@@ -8,29 +10,38 @@ int main()
 {
   using RT = async::Runtime<async::InlineExecutor>;
   RT::Init();
-  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(8080));
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(8080),
+                                           async::SocketOptions::LowLatency());
   if (!listener) {
     return 1;
   } else {
     RT::Block([](async::TcpListener listener) -> async::Task<> {
+      // pause accepting near the descriptor limit and shed new connections once requests queue up for too long
+      if (auto r = listener.setAdmission({.codel = async::CoDelOptions {}}); !r) {
+        std::cout << strerror(int(r.error())) << std::endl;
+        co_return;
+      }
+      auto backoff = async::TimerFd::Create(RT::GetReactor());
+      if (!backoff) {
+        std::cout << strerror(int(backoff.error())) << std::endl;
+        co_return;
+      }
       while (true) {
-        auto stream = co_await listener.accept(nullptr);
-        if (!stream) {
-          std::cout << strerror(int(stream.error())) << std::endl;
-          co_return;
-        } else {
-          RT::SpawnDetach([](async::TcpStream stream) -> async::Task<> {
-            auto writableBuf = std::array<uint8_t, 1024> {};
-            auto readn = co_await stream.recv(std::as_writable_bytes(std::span(writableBuf)));
-            assert(readn);
-            auto buf = "HTTP/1.1 200 OK\r\nContent-Length: 12\r\n\r\nHello World\n"sv;
-            auto writen = co_await stream.send(std::as_bytes(std::span(buf)));
-            assert(writen);
-            co_return;
-          }(std::move(stream.value())));
+        auto admitted = co_await listener.admit(nullptr);
+        if (!admitted) {
+          // an error that persists would otherwise spin the loop and flood the output
+          std::cout << strerror(int(admitted.error())) << std::endl;
+          co_await backoff->sleepFor(100ms);
+          continue;
         }
+        RT::SpawnDetach([](async::TcpStream stream, async::AdmissionPermit permit) -> async::Task<> {
+          co_await async::http::Serve(std::move(stream),
+                                      [&permit](async::http::Request const& req, async::http::ResponseWriter& res) {
+                                        permit.firstByte();
+                                        res.header("Content-Type", "text/plain").body("Hello World\n");
+                                      });
+        }(std::move(admitted->stream), std::move(admitted->permit)));
       }
-      co_return;
     }(std::move(listener.value())));
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "EventFd.hpp"
+#include "TimerFd.hpp"
+#include "sys/Socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace async {
+// CoDel applied to connections: the sojourn time is how long an accepted connection waited before its first request
+// was handled. Once it stayed above `target` for a whole `interval`, new connections are shed, increasingly often
+// while it stays there (the next shed follows interval / sqrt(count) after the last).
+struct CoDelOptions {
+  std::chrono::microseconds target {std::chrono::milliseconds(5)};
+  std::chrono::microseconds interval {std::chrono::milliseconds(100)};
+};
+
+struct AdmissionOptions {
+  std::size_t maxConnections = 0; // 0 leaves only the descriptor limit
+  // descriptors kept free below RLIMIT_NOFILE: accepting pauses while the process as a whole, every listener and
+  // whatever else it opened included, leaves fewer free
+  std::size_t fdHeadroom = 64;
+  // how long accepting pauses before it checks the descriptors again, or after accept failed with EMFILE or ENFILE
+  std::chrono::milliseconds fdRetryDelay {100};
+  std::optional<CoDelOptions> codel;
+};
+
+class AdmissionControl;
+
+// Held by an admitted connection for as long as it is open; destroying it frees the connection's slot.
+class AdmissionPermit {
+public:
+  AdmissionPermit() = default;
+  AdmissionPermit(AdmissionPermit const&) = delete;
+  AdmissionPermit(AdmissionPermit&& other) noexcept
+      : mControl(std::move(other.mControl)), mAccepted(other.mAccepted), mSampled(other.mSampled)
+  {
+  }
+  AdmissionPermit& operator=(AdmissionPermit&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      mControl = std::move(other.mControl);
+      mAccepted = other.mAccepted;
+      mSampled = other.mSampled;
+    }
+    return *this;
+  }
+  ~AdmissionPermit() { reset(); }
+
+  // Reports that the connection's first request is being handled. The time since accept is the sample the CoDel
+  // policy works on; only the first call counts.
+  auto firstByte() -> void;
+  auto reset() -> void;
+
+private:
+  friend class AdmissionControl;
+  AdmissionPermit(std::shared_ptr<AdmissionControl> control, std::chrono::steady_clock::time_point accepted)
+      : mControl(std::move(control)), mAccepted(accepted)
+  {
+  }
+
+  std::shared_ptr<AdmissionControl> mControl;
+  std::chrono::steady_clock::time_point mAccepted;
+  bool mSampled = false;
+};
+
+template <typename Stream>
+struct Admitted {
+  Stream stream;
+  AdmissionPermit permit;
+};
+
+// Admission control for a listener. Accepting pauses while the connection limit is reached and the listener is not
+// armed in the reactor meanwhile, so the kernel backlog absorbs the burst and then refuses connections instead of the
+// process running out of descriptors. Should accept fail with EMFILE regardless, a reserved descriptor is freed to
+// accept the first pending connection and close it right away, so the peer gets an answer instead of hanging in the
+// backlog, and accepting pauses for fdRetryDelay.
+//
+// The descriptor headroom is checked against the descriptors the process really holds, not the connections this
+// control admitted. The kernel hands out the lowest free descriptor, so every one below an accepted connection's is
+// open; while those reach into the headroom, each accept first probes the lowest free descriptor and pauses for
+// fdRetryDelay until it is below the headroom again. Far from it, the check costs nothing.
+//
+// Permits may be released on any thread; the accepting task is woken on the listener's reactor.
+class AdmissionControl : public std::enable_shared_from_this<AdmissionControl> {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static auto Create(Reactor& reactor, AdmissionOptions options = {}) -> StdResult<std::shared_ptr<AdmissionControl>>;
+  AdmissionControl(AdmissionControl const&) = delete;
+  ~AdmissionControl();
+
+  // Accepts the next connection on `listener` the policy admits.
+  auto accept(Socket& listener, SocketAddr* addr, SocketOptions const* options = nullptr)
+      -> Task<StdResult<Admitted<Socket>>>;
+  // Connections admitted and not released yet.
+  auto active() const -> std::size_t { return mActive.load(std::memory_order_relaxed); }
+  // The connection limit, unbounded without maxConnections.
+  auto limit() const -> std::size_t { return mLimit; }
+  // Connections accepted and closed right away by the policy.
+  auto shed() const -> std::uint64_t { return mShed.load(std::memory_order_relaxed); }
+
+private:
+  friend class AdmissionPermit;
+  AdmissionControl(AdmissionOptions options, std::size_t limit, std::size_t fdLimit, EventFd wake, TimerFd timer,
+                   impl::fd_t reserve);
+  auto release() -> void;
+  auto sample(Clock::duration sojourn, Clock::time_point now) -> void;
+  auto shouldShed(Clock::time_point now) -> bool;
+  auto shedOne(Socket& listener) -> void;
+
+  AdmissionOptions mOptions;
+  std::size_t mLimit;
+  std::size_t mFdLimit; // descriptors the process may hold before the headroom
+  bool mProbeFds = true; // the last accepted descriptor was close to mFdLimit, or none was accepted yet
+  std::atomic<std::size_t> mActive {0};
+  std::atomic<std::uint64_t> mShed {0};
+  std::atomic<bool> mWaiting {false};
+  EventFd mWake;
+  TimerFd mTimer;
+  impl::fd_t mReserve;
+
+  // CoDel state
+  std::mutex mMutex;
+  Clock::time_point mLastSample {};
+  Clock::time_point mFirstAbove {};
+  Clock::time_point mDropNext {};
+  std::uint32_t mDropCount = 0;
+  bool mOverloaded = false;
+  bool mDropping = false;
+};
+} // namespace async
@@ -0,0 +1,125 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "sys/Socket.hpp"
+
+#include <fcntl.h>
+#include <type_traits>
+
+namespace async {
+enum class Interest { Read, Write };
+
+// Any pollable descriptor (eventfd, timerfd, signalfd, pipe, tty, inotify, ...) registered with a reactor. It owns the
+// descriptor and switches it to non-blocking mode. Only one task may wait per direction at a time.
+//
+// O_NONBLOCK is a flag of the open file description, so it is never restored and also applies to every duplicate of
+// the descriptor, including one inherited by another process (a shared tty or pipe, say).
+class AsyncFd {
+public:
+  inline static auto Create(Reactor& reactor, impl::fd_t fd) -> StdResult<AsyncFd>
+  {
+    if (auto flags = SysCall(::fcntl, fd, F_GETFL); !flags) {
+      ::close(fd);
+      return make_unexpected(flags.error());
+    } else if (auto r = SysCall(::fcntl, fd, F_SETFL, flags.value() | O_NONBLOCK); !r) {
+      ::close(fd);
+      return make_unexpected(r.error());
+    }
+    return Socket::Register(&reactor, impl::Socket(fd)).map([](Socket source) { return AsyncFd(std::move(source)); });
+  }
+
+  AsyncFd() = default;
+  AsyncFd(AsyncFd const&) = delete;
+  AsyncFd(AsyncFd&&) = default;
+  AsyncFd& operator=(AsyncFd&&) = default;
+  ~AsyncFd() = default;
+
+  // Runs `op`, a non-blocking call returning a StdResult, and when it would block waits for `interest` and runs it
+  // once more. Returns the result of the last run.
+  template <typename Op>
+  auto io(Op op, Interest interest)
+  {
+    using Result = std::invoke_result_t<Op&>;
+    struct IoAwaiter {
+      AsyncFd& fd;
+      Op op;
+      Interest interest;
+      Result result {};
+      bool suspendedBefore = false;
+      auto await_ready() noexcept -> bool
+      {
+        result = op();
+        if (!result && detail::WouldBlock(result.error())) {
+          suspendedBefore = true;
+          return false;
+        }
+        return true;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+      {
+        auto r = interest == Interest::Read ? fd.mSource.regR(handle) : fd.mSource.regW(handle);
+        assert(r);
+      }
+      auto await_resume() -> Result { return suspendedBefore ? op() : std::move(result); }
+    };
+    return IoAwaiter {*this, std::move(op), interest};
+  }
+  // Waits until the descriptor is reported ready for `interest`, without performing any I/O.
+  auto ready(Interest interest)
+  {
+    struct ReadyAwaiter {
+      AsyncFd& fd;
+      Interest interest;
+      auto await_ready() noexcept -> bool { return false; }
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+      {
+        auto r = interest == Interest::Read ? fd.mSource.regR(handle) : fd.mSource.regW(handle);
+        assert(r);
+      }
+      auto await_resume() noexcept -> void {}
+    };
+    return ReadyAwaiter {*this, interest};
+  }
+  auto read(std::span<std::byte> data)
+  {
+    return io([fd = raw(), data] { return SysCall(::read, fd, data.data(), data.size()); }, Interest::Read);
+  }
+  auto write(std::span<std::byte const> data)
+  {
+    return io([fd = raw(), data] { return SysCall(::write, fd, data.data(), data.size()); }, Interest::Write);
+  }
+
+  auto raw() const -> impl::fd_t { return mSource.getSocket().raw(); }
+  auto valid() const -> bool { return mSource.valid(); }
+
+private:
+  explicit AsyncFd(Socket&& source) : mSource(std::move(source)) {}
+
+  Socket mSource;
+};
+
+// Unidirectional pipe with both ends registered with the reactor.
+struct Pipe {
+  AsyncFd reader;
+  AsyncFd writer;
+
+  inline static auto Create(Reactor& reactor) -> StdResult<Pipe>
+  {
+    int fds[2];
+    if (auto r = SysCall(::pipe2, fds, O_NONBLOCK | O_CLOEXEC); !r) {
+      return make_unexpected(r.error());
+    }
+    auto reader = AsyncFd::Create(reactor, fds[0]);
+    if (!reader) {
+      ::close(fds[1]);
+      return make_unexpected(reader.error());
+    }
+    auto writer = AsyncFd::Create(reactor, fds[1]);
+    if (!writer) {
+      return make_unexpected(writer.error());
+    }
+    return Pipe {std::move(reader).value(), std::move(writer).value()};
+  }
+};
+} // namespace async
@@ -0,0 +1,40 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "sys/Socket.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace async {
+// Small pool of threads for calls that block, like file I/O, so they do not stall the executor threads.
+class BlockingPool {
+public:
+  explicit BlockingPool(std::size_t threads);
+  BlockingPool(BlockingPool const&) = delete;
+  BlockingPool& operator=(BlockingPool const&) = delete;
+  ~BlockingPool();
+
+  // Shared pool with 4 threads, started on first use.
+  static auto Default() -> BlockingPool&;
+
+  // Runs `job` on a pool thread. The calling task waits on an eventfd registered with `reactor`, so it is resumed by
+  // its own runtime and never by a pool thread.
+  auto run(Reactor& reactor, std::function<void()> job) -> Task<StdResult<void>>;
+
+private:
+  auto submit(std::function<void()> job) -> void;
+  auto work() -> void;
+
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  std::deque<std::function<void()>> mJobs;
+  bool mStop = false;
+  std::vector<std::thread> mThreads;
+};
+} // namespace async
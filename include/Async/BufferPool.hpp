@@ -0,0 +1,124 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace async {
+class BufferPool;
+
+// A buffer borrowed from a BufferPool, handed back when it is destroyed or reassigned. A default constructed one holds
+// nothing; one made with a size alone owns a private allocation, for callers that outgrow the pool's buffers.
+//
+// A coroutine holding a buffer may be resumed on another executor thread than the one it borrowed on. The buffer then
+// goes to the Local() pool of the thread releasing it, so no pool is ever touched by two threads.
+class PooledBuffer {
+public:
+  PooledBuffer() = default;
+  explicit PooledBuffer(std::size_t size) : mData(std::make_unique<std::byte[]>(size)), mSize(size) {}
+  PooledBuffer(PooledBuffer const&) = delete;
+  PooledBuffer(PooledBuffer&& other) noexcept
+      : mData(std::move(other.mData)), mSize(std::exchange(other.mSize, 0)), mPool(std::exchange(other.mPool, nullptr)),
+        mOwner(other.mOwner)
+  {
+  }
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept
+  {
+    if (this != &other) {
+      release();
+      mData = std::move(other.mData);
+      mSize = std::exchange(other.mSize, 0);
+      mPool = std::exchange(other.mPool, nullptr);
+      mOwner = other.mOwner;
+    }
+    return *this;
+  }
+  ~PooledBuffer() { release(); }
+
+  auto data() const -> std::byte* { return mData.get(); }
+  auto size() const -> std::size_t { return mSize; }
+  auto span() const -> std::span<std::byte> { return {mData.get(), mSize}; }
+  auto empty() const -> bool { return mData == nullptr; }
+  // Hands the buffer back now.
+  auto release() -> void;
+
+private:
+  friend class BufferPool;
+  PooledBuffer(std::unique_ptr<std::byte[]> data, std::size_t size, BufferPool* pool, std::thread::id owner)
+      : mData(std::move(data)), mSize(size), mPool(pool), mOwner(owner)
+  {
+  }
+
+  std::unique_ptr<std::byte[]> mData;
+  std::size_t mSize = 0;
+  BufferPool* mPool = nullptr;
+  std::thread::id mOwner; // the thread of mPool
+
+};
+
+// Free list of equally sized buffers. Connections that borrow a recv buffer only while data is there (see
+// Socket::readable) make memory scale with the active connections instead of all of them. Not thread-safe: a pool
+// belongs to the thread that created it; use Local() for the current thread's pool. Buffers released on another thread
+// go to that thread's Local() pool (see PooledBuffer), and acquire() on another thread, say by a task that moved to
+// another core since it looked the pool up, borrows from that thread's Local() pool.
+class BufferPool {
+public:
+  constexpr static std::size_t DefaultBufferSize = 16 << 10;
+  constexpr static std::size_t DefaultMaxCached = 256;
+
+  explicit BufferPool(std::size_t bufferSize = DefaultBufferSize, std::size_t maxCached = DefaultMaxCached)
+      : mBufferSize(bufferSize), mMaxCached(maxCached), mOwner(std::this_thread::get_id())
+  {
+  }
+  BufferPool(BufferPool const&) = delete;
+  BufferPool& operator=(BufferPool const&) = delete;
+
+  // The calling thread's pool of `bufferSize` buffers.
+  static auto Local(std::size_t bufferSize = DefaultBufferSize) -> BufferPool&;
+
+  auto acquire() -> PooledBuffer
+  {
+    if (mOwner != std::this_thread::get_id()) {
+      return Local(mBufferSize).acquire();
+    }
+    if (mFree.empty()) {
+      return {std::make_unique<std::byte[]>(mBufferSize), mBufferSize, this, mOwner};
+    }
+    auto data = std::move(mFree.back());
+    mFree.pop_back();
+    return {std::move(data), mBufferSize, this, mOwner};
+  }
+  auto bufferSize() const -> std::size_t { return mBufferSize; }
+  // Buffers kept for reuse; beyond maxCached returned buffers are freed.
+  auto cached() const -> std::size_t { return mFree.size(); }
+
+private:
+  friend class PooledBuffer;
+  auto put(std::unique_ptr<std::byte[]> data) -> void
+  {
+    if (mFree.size() < mMaxCached) {
+      mFree.push_back(std::move(data));
+    }
+  }
+
+  std::size_t mBufferSize;
+  std::size_t mMaxCached;
+  std::thread::id mOwner;
+  std::vector<std::unique_ptr<std::byte[]>> mFree;
+};
+
+inline auto PooledBuffer::release() -> void
+{
+  if (mPool != nullptr && mData != nullptr) {
+    // the owner's pool may not be touched, or even alive, here
+    auto pool = mOwner == std::this_thread::get_id() ? mPool : &BufferPool::Local(mSize);
+    pool->put(std::move(mData));
+  }
+  mData.reset();
+  mSize = 0;
+  mPool = nullptr;
+}
+} // namespace async
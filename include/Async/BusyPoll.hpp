@@ -0,0 +1,45 @@
+#pragma once
+#include "Async/Reactor.hpp"
+
+#include <chrono>
+
+namespace async {
+// Busy-polling loop for a reactor. Each pass polls the reactor without sleeping for up to the budget and only then
+// sleeps in Reactor::poll until the next event, trading a busy CPU for skipping the epoll sleep and wakeup whenever
+// the next event comes within the budget. Tasks the reactor resumes run from inside the spin as they would from a
+// sleeping poll. Combine it with SocketOptions::busyPoll so every spin also polls the NIC queues of the sockets.
+//
+//   auto done = false;
+//   ... spawn the work, which sets done when it finishes
+//   BusyPoll(reactor, 50us).run([&] { return done; });
+//
+// A budget of zero is the plain reactor loop. CoreRuntimeOptions::busyPoll runs every core this way.
+class BusyPoll {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  BusyPoll(Reactor& reactor, std::chrono::nanoseconds budget) : mReactor(reactor), mBudget(budget) {}
+
+  // Polls until `done()` returns true, which is checked after every poll.
+  template <typename Done>
+  auto run(Done done) -> void
+  {
+    while (!done()) {
+      if (mBudget.count() != 0) {
+        for (auto deadline = Clock::now() + mBudget; Clock::now() < deadline;) {
+          mReactor.poll(0);
+          if (done()) {
+            return;
+          }
+        }
+      }
+      mReactor.poll(-1);
+    }
+  }
+  auto budget() const -> std::chrono::nanoseconds { return mBudget; }
+
+private:
+  Reactor& mReactor;
+  std::chrono::nanoseconds mBudget;
+};
+} // namespace async
@@ -0,0 +1,217 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include "File.hpp"
+#include "SslSocket.hpp"
+
+#include <concepts>
+#include <fcntl.h>
+#include <limits>
+#include <vector>
+
+namespace async {
+namespace detail {
+template <typename R>
+concept IoResult = requires(R r) {
+  static_cast<bool>(r);
+  r.value();
+  { WouldBlock(r.error()) } -> std::same_as<bool>;
+};
+template <typename A>
+concept IoAwaitable = requires(A a, std::coroutine_handle<> h) {
+  { a.await_ready() } -> std::convertible_to<bool>;
+  a.await_suspend(h);
+  { a.await_resume() } -> IoResult;
+};
+} // namespace detail
+
+// Byte streams whose recv/send return awaiters completing with the number of bytes transferred or an error, as Socket,
+// TcpStream, UnixStream, SslSocket, SslStream and MemoryStream do. Code templated on these compiles against the
+// concrete awaiters, so nothing on the data path goes through a virtual call.
+template <typename S>
+concept AsyncReadStream = requires(S& s, std::span<std::byte> data) {
+  { s.recv(data) } -> detail::IoAwaitable;
+};
+template <typename S>
+concept AsyncWriteStream = requires(S& s, std::span<std::byte const> data) {
+  { s.send(data) } -> detail::IoAwaitable;
+};
+
+namespace detail {
+constexpr std::size_t CopyBufferSize = 64 << 10;
+
+template <AsyncWriteStream Dst>
+auto SendAll(Dst& dst, std::span<std::byte const> data) -> Task<StdResult<void>>
+{
+  while (!data.empty()) {
+    auto n = co_await dst.send(data);
+    if (n) {
+      data = data.subspan(std::size_t(n.value()));
+    } else if (!WouldBlock(n.error())) {
+      co_return make_unexpected(ToErrc(n.error()));
+    }
+  }
+  co_return StdResult<void> {};
+}
+
+// Moves bytes through one user space buffer.
+template <AsyncReadStream Src, AsyncWriteStream Dst>
+auto CopyBuffered(Src& src, Dst& dst, std::size_t count) -> Task<StdResult<std::size_t>>
+{
+  auto buffer = std::vector<std::byte>(std::min(count, CopyBufferSize));
+  auto copied = std::size_t {0};
+  while (copied < count) {
+    auto n = co_await src.recv(std::span(buffer).first(std::min(buffer.size(), count - copied)));
+    if (!n) {
+      if (IsEof(n.error())) {
+        break;
+      } else if (!WouldBlock(n.error())) {
+        co_return make_unexpected(ToErrc(n.error()));
+      }
+      continue;
+    } else if (n.value() == 0) {
+      break;
+    }
+    if (auto r = co_await SendAll(dst, std::span(buffer).first(std::size_t(n.value()))); !r) {
+      co_return make_unexpected(r.error());
+    }
+    copied += std::size_t(n.value());
+  }
+  co_return copied;
+}
+
+template <AsyncWriteStream Dst>
+auto CopyFileBuffered(File& src, Dst& dst, std::size_t count) -> Task<StdResult<std::size_t>>
+{
+  auto buffer = std::vector<std::byte>(std::min(count, CopyBufferSize));
+  auto copied = std::size_t {0};
+  while (copied < count) {
+    auto n = co_await src.read(std::span(buffer).first(std::min(buffer.size(), count - copied)), off_t(copied));
+    if (!n) {
+      co_return make_unexpected(n.error());
+    } else if (n.value() == 0) {
+      break;
+    }
+    if (auto r = co_await SendAll(dst, std::span(buffer).first(n.value())); !r) {
+      co_return make_unexpected(r.error());
+    }
+    copied += n.value();
+  }
+  co_return copied;
+}
+
+#ifdef __linux__
+// Moves bytes from one socket to another through a pipe with splice(2), so they never reach user space.
+inline auto CopySplice(Socket& src, Socket& dst, std::size_t count) -> Task<StdResult<std::size_t>>
+{
+  int fds[2];
+  if (auto r = SysCall(::pipe2, fds, O_NONBLOCK | O_CLOEXEC); !r) {
+    co_return make_unexpected(r.error());
+  }
+  struct PipeGuard {
+    int* fds;
+    ~PipeGuard()
+    {
+      ::close(fds[0]);
+      ::close(fds[1]);
+    }
+  } guard {fds};
+  auto capacity = std::size_t(CopyBufferSize);
+  if (auto size = SysCall(::fcntl, fds[1], F_GETPIPE_SZ); size) {
+    capacity = std::size_t(size.value());
+  }
+  auto copied = std::size_t {0};
+  auto buffered = std::size_t {0}; // bytes sitting in the pipe
+  auto eof = false;
+  constexpr auto flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+  while (buffered != 0 || (!eof && copied < count)) {
+    auto progress = false;
+    if (!eof && buffered < capacity && copied + buffered < count) {
+      auto want = std::min(capacity - buffered, count - copied - buffered);
+      auto n = SysCall(::splice, src.getSocket().raw(), nullptr, fds[1], nullptr, want, flags);
+      if (n) {
+        eof = n.value() == 0;
+        buffered += std::size_t(n.value());
+        progress = true;
+      } else if (!WouldBlock(n.error())) {
+        co_return make_unexpected(n.error());
+      }
+    }
+    if (buffered != 0) {
+      auto n = SysCall(::splice, fds[0], nullptr, dst.getSocket().raw(), nullptr, buffered, flags);
+      if (n) {
+        buffered -= std::size_t(n.value());
+        copied += std::size_t(n.value());
+        progress = true;
+      } else if (!WouldBlock(n.error())) {
+        co_return make_unexpected(n.error());
+      }
+    }
+    if (!progress) {
+      // with data in the pipe the destination is what holds us up, otherwise the source
+      if (buffered != 0) {
+        co_await dst.writable();
+      } else {
+        co_await src.readable();
+      }
+    }
+  }
+  co_return copied;
+}
+#endif
+} // namespace detail
+
+// Copies up to `count` bytes from `src` to `dst` and returns how many were copied, which is fewer only when `src` ended
+// first. The fastest path the pair of types allows is chosen at compile time: splice(2) between two sockets and a
+// buffered recv/send loop otherwise.
+template <AsyncReadStream Src, AsyncWriteStream Dst>
+auto copyN(Src& src, Dst& dst, std::size_t count) -> Task<StdResult<std::size_t>>
+{
+#ifdef __linux__
+  if constexpr (std::derived_from<Src, Socket> && std::derived_from<Dst, Socket>) {
+    return detail::CopySplice(src, dst, count);
+  } else
+#endif
+  {
+    return detail::CopyBuffered(src, dst, count);
+  }
+}
+// Copies up to `count` bytes from the start of `src`: with sendfile(2) to a socket, with SSL_sendfile to a TLS socket
+// once kernel TLS encrypts its records and through a buffer otherwise.
+template <AsyncWriteStream Dst>
+auto copyN(File& src, Dst& dst, std::size_t count) -> Task<StdResult<std::size_t>>
+{
+#ifdef __linux__
+  if constexpr (std::derived_from<Dst, Socket>) {
+    return dst.sendfileAll(src.raw(), 0, count);
+  } else if constexpr (std::derived_from<Dst, SslSocket>) {
+    if (dst.ktlsSend()) {
+      return [](File& src, Dst& dst, std::size_t count) -> Task<StdResult<std::size_t>> {
+        auto n = co_await dst.sendfileAll(src.raw(), 0, count);
+        if (!n) {
+          co_return make_unexpected(detail::ToErrc(n.error()));
+        }
+        co_return n.value();
+      }(src, dst, count);
+    }
+  }
+#endif
+  return detail::CopyFileBuffered(src, dst, count);
+}
+// Copies until `src` ends.
+template <AsyncReadStream Src, AsyncWriteStream Dst>
+auto copy(Src& src, Dst& dst) -> Task<StdResult<std::size_t>>
+{
+  return copyN(src, dst, std::numeric_limits<std::size_t>::max());
+}
+// Copies all of `src`.
+template <AsyncWriteStream Dst>
+auto copy(File& src, Dst& dst) -> Task<StdResult<std::size_t>>
+{
+  auto size = src.size(); // sendfile(2) rejects counts past SSIZE_MAX, so no "until the end" sentinel
+  if (!size) {
+    co_return make_unexpected(size.error());
+  }
+  co_return co_await copyN(src, dst, std::size_t(size.value()));
+}
+} // namespace async
@@ -0,0 +1,165 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "BusyPoll.hpp"
+#include "Detached.hpp"
+#include "EventFd.hpp"
+#include "SslSocket.hpp"
+#include "TcpListener.hpp"
+#include "sys/Socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace async {
+struct CoreRuntimeOptions {
+  std::size_t cores = 0;  // 0 runs one core per CPU the process may run on
+  bool pinThreads = true; // bind core i to the i-th of those CPUs
+  // spin on each core's reactor for this long before sleeping in epoll (see BusyPoll), 0 always sleeps
+  std::chrono::nanoseconds busyPoll {0};
+};
+
+// Thread-per-core runtime: every core is a thread with a Reactor of its own that only it polls, so the registrations
+// and wakeups of a socket never leave the thread that owns it. Sockets belong to the core whose reactor they were
+// created or accepted on, which listen() arranges by giving each core its own SO_REUSEPORT listener; the kernel then
+// spreads connections over the cores. migrate() moves a connection and the task serving it to another core, e.g. to
+// the core handling its NIC queue (coreFor). Tasks reach a core through an inbox woken by an eventfd.
+//
+// The runtime is independent of Runtime<E>: tasks running on a core must not use the Runtime singletons.
+//
+// The runtime owns the tasks spawned on it, and destroying it destroys those still running, which closes the sockets
+// they hold. Sockets held anywhere else must be closed before the runtime goes away, since their reactor goes with it.
+class CoreRuntime {
+public:
+  static auto Create(CoreRuntimeOptions options = {}) -> StdResult<std::unique_ptr<CoreRuntime>>;
+  CoreRuntime(CoreRuntime const&) = delete;
+  // Stops and joins the cores, then destroys the spawned tasks that have not finished, wherever they are suspended.
+  // Coroutines a task detached on its own, such as a SendQueue's drainer, are not tracked and are left suspended. No
+  // task may be in a BlockingPool call, whose job would outlive it.
+  ~CoreRuntime();
+
+  // The core the calling thread runs, none off this runtime.
+  auto currentCore() const -> std::optional<std::size_t>;
+  auto cores() const -> std::size_t { return mCores.size(); }
+  auto reactor(std::size_t core) -> Reactor& { return *mCores[core]->reactor; }
+  // The core to serve connections arriving on NIC queue `napiId` (see Socket::incomingNapiId), so busy polling stays
+  // on one queue per core.
+  auto coreFor(unsigned napiId) const -> std::size_t { return napiId % mCores.size(); }
+
+  // Runs `task` on `core`. Thread safe.
+  auto spawn(std::size_t core, Task<> task) -> void;
+  // Continues the awaiting coroutine on `core`, right away when it already runs there.
+  auto schedule(std::size_t core)
+  {
+    struct ScheduleAwaiter {
+      CoreRuntime& runtime;
+      std::size_t core;
+      auto await_ready() const noexcept -> bool { return runtime.currentCore() == core; }
+      auto await_suspend(std::coroutine_handle<> handle) -> void { runtime.post(core, handle); }
+      auto await_resume() noexcept -> void {}
+    };
+    return ScheduleAwaiter {*this, core};
+  }
+  // Moves `stream` to `core`: it is deregistered from its reactor, the awaiting task continues on `core` and the
+  // stream is registered with that core's reactor there. Nothing else may be waiting on the stream, so a split stream
+  // has to be joined first. Should the registration fail, the stream is closed and left empty.
+  //
+  // Only the stream moves. Per-thread caches are the new core's from here on: a BufferPool the task looked up before
+  // lends from the new core's Local() pool (see BufferPool::acquire), and buffers it holds return there. Whatever is
+  // bound to the old core's reactor stays there and would resume the task on the old core, so a File or another
+  // socket has to be reopened or migrated too, and BlockingPool::run has to be given the new core's reactor.
+  template <typename Stream>
+  auto migrate(Stream& stream, std::size_t core) -> Task<StdResult<void>>
+  {
+    auto& socket = TransportOf(stream);
+    if (currentCore() == core && socket.reactor() == &reactor(core)) {
+      co_return StdResult<void> {};
+    }
+    auto fd = socket.release();
+    co_await schedule(core);
+    auto registered = Socket::Register(&reactor(core), fd);
+    if (!registered) {
+      co_return make_unexpected(registered.error());
+    }
+    socket = std::move(registered).value();
+    co_return StdResult<void> {};
+  }
+  // Moves a connection accepted on this runtime to the core serving the NIC queue its packets arrive on (see
+  // coreFor), so with busy polling each queue is polled by one core only. Connections the kernel reports no queue for,
+  // such as loopback ones or those that received nothing yet, stay where they are.
+  template <typename Stream>
+  auto place(Stream& stream) -> Task<StdResult<void>>
+  {
+    auto napiId = TransportOf(stream).incomingNapiId();
+    if (!napiId || napiId.value() == 0) {
+      co_return StdResult<void> {};
+    }
+    co_return co_await migrate(stream, coreFor(napiId.value()));
+  }
+  // Binds one listener per core to `addr` with SO_REUSEPORT and runs `serve(listener)` on each core. Nothing runs
+  // unless every listener could be bound. The kernel picks the listener by a hash of the connection, not by its NIC
+  // queue; a task serving an accepted connection starts with place() to get there.
+  template <typename F>
+    requires std::same_as<std::invoke_result_t<F&, TcpListener>, Task<>>
+  auto listen(SocketAddr const& addr, SocketOptions options, F serve) -> StdResult<void>
+  {
+    options.reusePort = true;
+    auto listeners = std::vector<TcpListener>();
+    for (std::size_t core = 0; core < cores(); core++) {
+      auto listener = TcpListener::Bind(reactor(core), addr, options);
+      if (!listener) {
+        return make_unexpected(listener.error());
+      }
+      listeners.push_back(std::move(listener).value());
+    }
+    for (std::size_t core = 0; core < cores(); core++) {
+      // a copy of `serve` lives in each frame, so a lambda's captures outlive this call
+      spawn(core, [](F serve, TcpListener listener) -> Task<> {
+        co_await serve(std::move(listener));
+      }(serve, std::move(listeners[core])));
+    }
+    return {};
+  }
+
+private:
+  struct Core {
+    std::unique_ptr<Reactor> reactor;
+    EventFd wake;
+    std::mutex mutex;
+    std::vector<std::coroutine_handle<>> inbox;
+    std::thread thread;
+    bool running = false; // only touched by the core's thread
+  };
+
+  CoreRuntime() = default;
+  template <typename Stream>
+  inline static auto TransportOf(Stream& stream) -> Socket&
+  {
+    if constexpr (std::derived_from<Stream, Socket>) {
+      return stream;
+    } else {
+      static_assert(std::derived_from<Stream, SslSocket>, "migrate takes sockets and TLS sockets");
+      return stream.socket();
+    }
+  }
+  auto post(std::size_t core, std::coroutine_handle<> handle) -> void;
+  auto run(std::size_t core, int cpu) -> void;
+  auto drain(std::size_t core) -> Task<>;
+  auto own(Task<> task, std::list<std::coroutine_handle<>>::iterator root) -> Task<>;
+
+  std::vector<std::unique_ptr<Core>> mCores;
+  std::chrono::nanoseconds mBusyPoll {0};
+  std::atomic<bool> mStopping {false};
+  std::mutex mRootsMutex;
+  std::list<std::coroutine_handle<>> mRoots; // frames of the spawned tasks that have not finished
+};
+} // namespace async
@@ -0,0 +1,23 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include <coroutine>
+#include <exception>
+
+namespace async::detail {
+// Coroutine that owns itself: it starts when its handle is resumed and frees itself when it finishes.
+struct Detached {
+  struct promise_type {
+    auto get_return_object() -> Detached { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+    auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    auto return_void() -> void {}
+    auto unhandled_exception() -> void { std::terminate(); }
+  };
+  std::coroutine_handle<> handle;
+};
+inline auto Detach(Task<> task) -> Detached
+{
+  co_await std::move(task);
+}
+} // namespace async::detail
@@ -0,0 +1,61 @@
+#pragma once
+#include "AsyncFd.hpp"
+
+#include <sys/eventfd.h>
+
+namespace async {
+// Counter that any thread can bump to wake a task waiting on the reactor, without a mutex and condition variable.
+class EventFd {
+public:
+  // In semaphore mode every wait() takes one from the counter instead of all of it.
+  inline static auto Create(Reactor& reactor, bool semaphore = false) -> StdResult<EventFd>
+  {
+    auto flags = EFD_NONBLOCK | EFD_CLOEXEC | (semaphore ? EFD_SEMAPHORE : 0);
+    if (auto fd = SysCall(::eventfd, 0, flags); !fd) {
+      return make_unexpected(fd.error());
+    } else {
+      return AsyncFd::Create(reactor, fd.value()).map([](AsyncFd fd) { return EventFd(std::move(fd)); });
+    }
+  }
+
+  EventFd() = default;
+  EventFd(EventFd&&) = default;
+  EventFd& operator=(EventFd&&) = default;
+
+  // Adds `count` to the counter. Thread safe and never blocks unless the counter would overflow.
+  auto notify(std::uint64_t count = 1) -> StdResult<void>
+  {
+    if (auto r = SysCall(::write, mFd.raw(), &count, sizeof(count)); !r) {
+      return make_unexpected(r.error());
+    }
+    return {};
+  }
+  // Waits until the counter is non-zero and returns what was taken from it.
+  auto wait()
+  {
+    return mFd.io(
+        [fd = mFd.raw()]() -> StdResult<std::uint64_t> {
+          auto value = std::uint64_t {};
+          if (auto r = SysCall(::read, fd, &value, sizeof(value)); !r) {
+            return make_unexpected(r.error());
+          }
+          return value;
+        },
+        Interest::Read);
+  }
+  // Waits until the counter is non-zero without taking from it.
+  auto ready() { return mFd.ready(Interest::Read); }
+  // Takes the counter without waiting, 0 when it is already zero.
+  auto take() -> std::uint64_t
+  {
+    auto value = std::uint64_t {};
+    return ::read(mFd.raw(), &value, sizeof(value)) == sizeof(value) ? value : 0;
+  }
+  auto raw() const -> impl::fd_t { return mFd.raw(); }
+
+private:
+  explicit EventFd(AsyncFd fd) : mFd(std::move(fd)) {}
+
+  AsyncFd mFd;
+};
+} // namespace async
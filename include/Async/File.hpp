@@ -0,0 +1,51 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "BlockingPool.hpp"
+#include "sys/Socket.hpp"
+
+#include <fcntl.h>
+#include <filesystem>
+
+namespace async {
+// Regular file with awaitable positioned reads and writes. The blocking calls run on a BlockingPool and the awaiting
+// task is resumed by `reactor`, so slow disks never stall the sockets of an executor thread. raw() can be handed to
+// Socket::sendfile to serve the same file.
+class File {
+public:
+  static auto Open(Reactor& reactor, std::filesystem::path path, int flags = O_RDONLY, mode_t mode = 0644,
+                   BlockingPool& pool = BlockingPool::Default()) -> Task<StdResult<File>>;
+
+  File() = default;
+  // Adopts an open descriptor.
+  File(Reactor& reactor, impl::fd_t fd, BlockingPool& pool = BlockingPool::Default())
+      : mReactor(&reactor), mPool(&pool), mFd(fd)
+  {
+  }
+  File(File const&) = delete;
+  File& operator=(File const&) = delete;
+  File(File&& other) noexcept
+      : mReactor(other.mReactor), mPool(other.mPool), mFd(std::exchange(other.mFd, impl::INVALID_FD))
+  {
+  }
+  File& operator=(File&& other) noexcept;
+  ~File();
+
+  // Reads up to data.size() bytes at `offset`; fewer only at the end of the file.
+  auto read(std::span<std::byte> data, off_t offset) -> Task<StdResult<size_t>>;
+  // Writes all of `data` at `offset`.
+  auto write(std::span<std::byte const> data, off_t offset) -> Task<StdResult<size_t>>;
+  auto fsync() -> Task<StdResult<void>>;
+  auto fdatasync() -> Task<StdResult<void>>;
+  auto size() const -> StdResult<off_t>;
+
+  auto raw() const -> impl::fd_t { return mFd; }
+  auto release() -> impl::fd_t { return std::exchange(mFd, impl::INVALID_FD); }
+
+private:
+  Reactor* mReactor = nullptr;
+  BlockingPool* mPool = nullptr;
+  impl::fd_t mFd = impl::INVALID_FD;
+};
+} // namespace async
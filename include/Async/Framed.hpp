@@ -0,0 +1,231 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include "RingBuffer.hpp"
+#include "sys/IoError.hpp"
+
+#include <cstring>
+#include <optional>
+#include <sys/uio.h>
+#include <vector>
+
+namespace async {
+struct FramedOptions {
+  std::size_t maxFrameSize = 16 << 20;
+  std::size_t readBufferSize = 64 << 10;
+  std::size_t writeBufferSize = 64 << 10; // feed() flushes on its own once this much is buffered
+  // read into a RingBuffer, so a frame running past its end is never moved, at the cost of two memory mappings per
+  // connection (mind vm.max_map_count). The plain buffer is used when the mapping fails.
+  bool mirroredReadBuffer = false;
+};
+
+// Length-prefixed framing over a Socket-like stream (TcpStream, UnixStream, SslStream, ...): every frame is a 4 byte
+// big-endian payload length followed by the payload.
+//
+// Reads go into one reusable buffer and frames are handed out as views into it. Only a frame that runs past the end
+// of the buffer is moved to its front, and the buffer only grows for frames larger than it, so decoding does not
+// allocate once the buffer has its working size. With mirroredReadBuffer not even that frame is moved.
+template <typename Stream>
+class Framed {
+public:
+  constexpr static std::size_t HeaderSize = 4;
+
+  explicit Framed(Stream stream, FramedOptions options = {}) : mStream(std::move(stream)), mOptions(options)
+  {
+    if (auto ring = options.mirroredReadBuffer ? RingBuffer::Create(options.readBufferSize) : StdResult<RingBuffer> {};
+        ring && ring->capacity() != 0) {
+      mRing = std::move(ring).value();
+    } else {
+      mIn.resize(std::max(options.readBufferSize, HeaderSize));
+    }
+    mOut.reserve(options.writeBufferSize);
+  }
+  Framed(Framed const&) = delete;
+  Framed(Framed&&) noexcept = default;
+  Framed& operator=(Framed&&) noexcept = default;
+
+  // Waits for the next frame. The view stays valid until the next call. Returns std::nullopt when the peer closes
+  // between frames, std::errc::connection_reset when it closes inside one and std::errc::message_size for frames over
+  // maxFrameSize.
+  auto next() -> Task<StdResult<std::optional<std::span<std::byte const>>>>
+  {
+    return mRing.capacity() != 0 ? nextMirrored() : nextBuffered();
+  }
+  // Appends a frame to the write buffer. Nothing is sent before flush(), unless the buffer is full.
+  auto feed(std::span<std::byte const> frame) -> Task<StdResult<void>>
+  {
+    assert(frame.size() <= mOptions.maxFrameSize);
+    auto header = EncodeLength(frame.size());
+    mOut.insert(mOut.end(), header.begin(), header.end());
+    mOut.insert(mOut.end(), frame.begin(), frame.end());
+    if (mOut.size() >= mOptions.writeBufferSize) {
+      co_return co_await flush();
+    }
+    co_return StdResult<void> {};
+  }
+  auto flush() -> Task<StdResult<void>>
+  {
+    for (auto pending = std::span<std::byte const>(mOut); !pending.empty();) {
+      auto n = co_await mStream.send(pending);
+      if (n) {
+        pending = pending.subspan(std::size_t(n.value()));
+      } else if (!detail::WouldBlock(n.error())) {
+        co_return make_unexpected(detail::ToErrc(n.error()));
+      }
+    }
+    mOut.clear();
+    co_return StdResult<void> {};
+  }
+  auto send(std::span<std::byte const> frame) -> Task<StdResult<void>>
+  {
+    if (auto r = co_await feed(frame); !r) {
+      co_return r;
+    }
+    co_return co_await flush();
+  }
+  // Sends `frames` after anything already fed. Streams with sendv gather the payloads straight from the caller's
+  // buffers; the others copy them into the write buffer and send it as one write.
+  auto sendBatch(std::span<std::span<std::byte const> const> frames) -> Task<StdResult<void>>
+  {
+    if constexpr (requires(Stream& s, std::span<iovec const> iov) { s.sendv(iov); }) {
+      if (auto r = co_await flush(); !r) {
+        co_return r;
+      }
+      mHeaders.resize(frames.size());
+      mIov.clear();
+      for (std::size_t i = 0; i < frames.size(); i++) {
+        assert(frames[i].size() <= mOptions.maxFrameSize);
+        mHeaders[i] = EncodeLength(frames[i].size());
+        mIov.push_back({mHeaders[i].data(), HeaderSize});
+        if (!frames[i].empty()) {
+          mIov.push_back({const_cast<std::byte*>(frames[i].data()), frames[i].size()});
+        }
+      }
+      for (auto pending = std::span(mIov); !pending.empty();) {
+        auto n = co_await mStream.sendv(pending.first(std::min<std::size_t>(pending.size(), MaxIov)));
+        if (!n) {
+          if (!detail::WouldBlock(n.error())) {
+            co_return make_unexpected(detail::ToErrc(n.error()));
+          }
+          continue;
+        }
+        detail::AdvanceIov(pending, std::size_t(n.value()));
+      }
+      co_return StdResult<void> {};
+    } else {
+      for (auto frame : frames) {
+        auto header = EncodeLength(frame.size());
+        mOut.insert(mOut.end(), header.begin(), header.end());
+        mOut.insert(mOut.end(), frame.begin(), frame.end());
+      }
+      co_return co_await flush();
+    }
+  }
+  auto stream() -> Stream& { return mStream; }
+
+private:
+  constexpr static std::size_t MaxIov = 1024; // IOV_MAX on linux
+  inline static auto EncodeLength(std::size_t size) -> std::array<std::byte, HeaderSize>
+  {
+    return {std::byte(size >> 24), std::byte(size >> 16), std::byte(size >> 8), std::byte(size)};
+  }
+  inline static auto DecodeLength(std::byte const* header) -> std::size_t
+  {
+    return std::size_t(std::uint32_t(header[0]) << 24 | std::uint32_t(header[1]) << 16 |
+                       std::uint32_t(header[2]) << 8 | std::uint32_t(header[3]));
+  }
+  auto nextBuffered() -> Task<StdResult<std::optional<std::span<std::byte const>>>>
+  {
+    while (true) {
+      if (mBegin == mEnd) {
+        mBegin = mEnd = 0;
+      }
+      auto want = HeaderSize;
+      if (mEnd - mBegin >= HeaderSize) {
+        auto size = DecodeLength(mIn.data() + mBegin);
+        if (size > mOptions.maxFrameSize) {
+          co_return make_unexpected(std::errc::message_size);
+        }
+        want = HeaderSize + size;
+        if (mEnd - mBegin >= want) {
+          auto frame = std::span<std::byte const>(mIn).subspan(mBegin + HeaderSize, size);
+          mBegin += want;
+          co_return frame;
+        }
+      }
+      if (mBegin + want > mIn.size()) {
+        std::memmove(mIn.data(), mIn.data() + mBegin, mEnd - mBegin);
+        mEnd -= mBegin;
+        mBegin = 0;
+        if (want > mIn.size()) {
+          mIn.resize(want);
+        }
+      }
+      auto n = co_await mStream.recv(std::span(mIn).subspan(mEnd));
+      if (!n && detail::WouldBlock(n.error())) {
+        continue;
+      } else if (!n && !detail::IsEof(n.error())) {
+        co_return make_unexpected(detail::ToErrc(n.error()));
+      } else if (!n || n.value() == 0) { // a TLS close_notify ends the stream like a FIN
+        if (mBegin != mEnd) {
+          co_return make_unexpected(std::errc::connection_reset);
+        }
+        co_return std::nullopt;
+      }
+      mEnd += std::size_t(n.value());
+    }
+  }
+  // The frame handed out last stays readable until this call; the ring wraps where the vector would have to move it.
+  auto nextMirrored() -> Task<StdResult<std::optional<std::span<std::byte const>>>>
+  {
+    mRing.consume(std::exchange(mHandedOut, 0));
+    while (true) {
+      auto readable = mRing.readable();
+      auto want = HeaderSize;
+      if (readable.size() >= HeaderSize) {
+        auto size = DecodeLength(readable.data());
+        if (size > mOptions.maxFrameSize) {
+          co_return make_unexpected(std::errc::message_size);
+        }
+        want = HeaderSize + size;
+        if (readable.size() >= want) {
+          mHandedOut = want;
+          co_return readable.subspan(HeaderSize, size);
+        }
+      }
+      if (want > mRing.capacity()) {
+        auto larger = RingBuffer::Create(want);
+        if (!larger) {
+          co_return make_unexpected(larger.error());
+        }
+        std::memcpy(larger->writable().data(), readable.data(), readable.size());
+        larger->commit(readable.size());
+        mRing = std::move(larger).value();
+      }
+      auto n = co_await mStream.recv(mRing.writable());
+      if (!n && detail::WouldBlock(n.error())) {
+        continue;
+      } else if (!n && !detail::IsEof(n.error())) {
+        co_return make_unexpected(detail::ToErrc(n.error()));
+      } else if (!n || n.value() == 0) { // a TLS close_notify ends the stream like a FIN
+        if (!mRing.empty()) {
+          co_return make_unexpected(std::errc::connection_reset);
+        }
+        co_return std::nullopt;
+      }
+      mRing.commit(std::size_t(n.value()));
+    }
+  }
+
+  Stream mStream;
+  FramedOptions mOptions;
+  std::vector<std::byte> mIn;
+  std::size_t mBegin = 0; // first byte not handed out yet
+  std::size_t mEnd = 0;
+  RingBuffer mRing; // instead of mIn with mirroredReadBuffer
+  std::size_t mHandedOut = 0;
+  std::vector<std::byte> mOut;
+  std::vector<std::array<std::byte, HeaderSize>> mHeaders;
+  std::vector<iovec> mIov;
+};
+} // namespace async
@@ -0,0 +1,207 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "EventFd.hpp"
+#include "SslSocket.hpp"
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace async {
+enum class IoClass : std::uint8_t {
+  Control,     // health checks, control-plane RPCs
+  Interactive, // request/response traffic
+  Bulk,        // large transfers
+};
+constexpr std::size_t IoClassCount = 3;
+
+// The socket options marking a class's packets: SO_PRIORITY for the local qdisc and a DSCP for the network (CS6,
+// AF41 and CS1).
+inline auto SocketOptionsFor(IoClass ioClass) -> SocketOptions
+{
+  constexpr static int Priorities[IoClassCount] = {6, 4, 2}; // TC_PRIO_INTERACTIVE, _INTERACTIVE_BULK, _BULK
+  constexpr static int Tos[IoClassCount] = {0xc0, 0x88, 0x20};
+  auto options = SocketOptions {};
+  options.priority = Priorities[std::size_t(ioClass)];
+  options.tos = Tos[std::size_t(ioClass)];
+  return options;
+}
+
+struct IoClassStats {
+  std::uint64_t resumed = 0;
+  std::chrono::nanoseconds totalDelay {0}; // from the reactor's wakeup to the resumption
+  std::chrono::nanoseconds maxDelay {0};
+
+  auto meanDelay() const -> std::chrono::nanoseconds
+  {
+    return resumed != 0 ? totalDelay / std::int64_t(resumed) : std::chrono::nanoseconds(0);
+  }
+};
+
+struct IoSchedulerOptions {
+  enum class Policy {
+    Strict,   // a class only runs while every class above it is idle
+    Weighted, // per round, each class runs up to its weight, higher classes first
+  };
+  Policy policy = Policy::Strict;
+  std::array<std::uint32_t, IoClassCount> weights {16, 4, 1};
+  // resumptions per dispatch before the reactor gets to report new events, which may be of a higher class
+  std::size_t budget = 64;
+  // operations a Prioritized stream may complete in a row without waiting, and bytes it may move that way, before it
+  // queues for its turn anyway; 0 turns the bound off
+  std::size_t immediateOps = 16;
+  std::size_t immediateBytes = 256 << 10;
+};
+
+// Orders the resumption of I/O awaiters by class. The reactor resumes awaiters in the order it reports events, so a
+// burst of bulk transfers delays a health check that became ready in the same poll. Awaiters of a Prioritized stream
+// that had to wait are instead queued per class when the reactor wakes them and resumed by a dispatcher, itself woken
+// through an eventfd on the next poll, in class order. Operations that complete without waiting are only queued every
+// immediateOps operations or immediateBytes bytes, so a stream that never has to wait still gives way to the others.
+//
+// Use one scheduler per reactor. Awaiters may be queued from any thread.
+class IoScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static auto Create(Reactor& reactor, IoSchedulerOptions options = {}) -> StdResult<std::unique_ptr<IoScheduler>>;
+  IoScheduler(IoScheduler const&) = delete;
+  ~IoScheduler();
+
+  // Suspends the awaiting coroutine until it is its class's turn.
+  auto yield(IoClass ioClass)
+  {
+    struct YieldAwaiter {
+      IoScheduler& scheduler;
+      IoClass ioClass;
+      auto await_ready() const noexcept -> bool { return false; }
+      auto await_suspend(std::coroutine_handle<> handle) -> void { scheduler.enqueue(ioClass, handle); }
+      auto await_resume() noexcept -> void {}
+    };
+    return YieldAwaiter {*this, ioClass};
+  }
+  auto options() const -> IoSchedulerOptions const& { return mOptions; }
+  auto stats(IoClass ioClass) const -> IoClassStats;
+  // Awaiters queued and not resumed yet.
+  auto queued(IoClass ioClass) const -> std::size_t;
+
+private:
+  struct Entry {
+    std::coroutine_handle<> handle;
+    Clock::time_point queued;
+  };
+  // The dispatcher's coroutine. The scheduler owns the frame and destroys it wherever it is suspended.
+  struct Dispatcher {
+    struct promise_type {
+      auto get_return_object() -> Dispatcher
+      {
+        return {std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+      auto final_suspend() noexcept -> std::suspend_always { return {}; }
+      auto return_void() -> void {}
+      auto unhandled_exception() -> void { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  IoScheduler(IoSchedulerOptions options, EventFd wake) : mOptions(options), mWake(std::move(wake)) {}
+  auto enqueue(IoClass ioClass, std::coroutine_handle<> handle) -> void;
+  auto next() -> std::coroutine_handle<>;
+  auto dispatch() -> Dispatcher;
+
+  IoSchedulerOptions mOptions;
+  EventFd mWake;
+  Dispatcher mDispatcher;
+  mutable std::mutex mMutex;
+  std::array<std::deque<Entry>, IoClassCount> mQueues;
+  std::array<IoClassStats, IoClassCount> mStats;
+  std::array<std::uint32_t, IoClassCount> mCredit {}; // what each class may still run this round, when weighted
+  bool mArmed = false; // the eventfd was notified and the dispatcher has not taken it yet
+};
+
+// A stream whose recv and send resume in the order of its class when they had to wait for the reactor. Create marks
+// the packets of TCP and TLS sockets with the class's SO_PRIORITY and DSCP as well (see SocketOptionsFor).
+template <typename Stream>
+class Prioritized {
+public:
+  using RecvResult = decltype(std::declval<Stream&>().recv(std::span<std::byte>()).await_resume());
+  using SendResult = decltype(std::declval<Stream&>().send(std::span<std::byte const>()).await_resume());
+
+  inline static auto Create(IoScheduler& scheduler, Stream stream, IoClass ioClass) -> StdResult<Prioritized>
+  {
+    auto prioritized = Prioritized(scheduler, std::move(stream), ioClass);
+    if (auto r = prioritized.setClass(ioClass); !r) {
+      return make_unexpected(r.error());
+    }
+    return prioritized;
+  }
+
+  Prioritized(Prioritized const&) = delete;
+  Prioritized(Prioritized&&) noexcept = default;
+  Prioritized& operator=(Prioritized&&) noexcept = default;
+
+  auto recv(std::span<std::byte> data) -> Task<RecvResult> { return io(mStream.recv(data)); }
+  auto send(std::span<std::byte const> data) -> Task<SendResult> { return io(mStream.send(data)); }
+  auto ioClass() const -> IoClass { return mClass; }
+  auto setClass(IoClass ioClass) -> StdResult<void>
+  {
+    mClass = ioClass;
+    if constexpr (std::derived_from<Stream, Socket>) {
+      return mStream.getSocket().applyStreamOptions(SocketOptionsFor(ioClass));
+    } else if constexpr (std::derived_from<Stream, SslSocket>) {
+      return impl::Socket(mStream.raw()).applyStreamOptions(SocketOptionsFor(ioClass));
+    } else {
+      return {};
+    }
+  }
+  auto stream() -> Stream& { return mStream; }
+
+private:
+  // Lets the reactor resume the coroutine, which then queues for its turn before completing the operation.
+  template <typename Awaiter>
+  struct ForwardSuspend {
+    Awaiter& awaiter;
+    auto await_ready() const noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) { return awaiter.await_suspend(handle); }
+    auto await_resume() noexcept -> void {}
+  };
+
+  Prioritized(IoScheduler& scheduler, Stream stream, IoClass ioClass)
+      : mScheduler(&scheduler), mStream(std::move(stream)), mClass(ioClass)
+  {
+  }
+  template <typename Awaiter>
+  auto io(Awaiter awaiter) -> Task<decltype(awaiter.await_resume())>
+  {
+    if (!awaiter.await_ready()) {
+      co_await ForwardSuspend<Awaiter> {awaiter};
+      co_await mScheduler->yield(mClass);
+      mImmediateOps = mImmediateBytes = 0;
+      co_return awaiter.await_resume();
+    }
+    auto result = awaiter.await_resume();
+    auto& options = mScheduler->options();
+    mImmediateOps++;
+    mImmediateBytes += result ? std::size_t(result.value()) : 0;
+    if ((options.immediateOps != 0 && mImmediateOps >= options.immediateOps) ||
+        (options.immediateBytes != 0 && mImmediateBytes >= options.immediateBytes)) {
+      mImmediateOps = mImmediateBytes = 0;
+      co_await mScheduler->yield(mClass);
+    }
+    co_return result;
+  }
+
+  IoScheduler* mScheduler;
+  Stream mStream;
+  IoClass mClass;
+  std::size_t mImmediateOps = 0; // completed without waiting since the stream last queued
+  std::size_t mImmediateBytes = 0;
+};
+} // namespace async
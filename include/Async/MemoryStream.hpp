@@ -0,0 +1,235 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "EventFd.hpp"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace async {
+namespace detail {
+// Lock-free ring of bytes for one producer and one consumer. The positions only grow and are masked on access, so
+// the capacity is a power of two.
+class ByteRing {
+public:
+  explicit ByteRing(std::size_t capacity);
+
+  // Copies as much of `data` as fits and returns how much that was. Producer only.
+  auto write(std::span<std::byte const> data) -> std::size_t;
+  // Copies up to `data.size()` bytes out and returns how many. Consumer only.
+  auto read(std::span<std::byte> data) -> std::size_t;
+  auto size() const -> std::size_t
+  {
+    return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+  }
+  auto capacity() const -> std::size_t { return mMask + 1; }
+
+private:
+  std::unique_ptr<std::byte[]> mData;
+  std::size_t mMask;
+  alignas(64) std::atomic<std::size_t> mHead {0}; // next byte to read
+  alignas(64) std::atomic<std::size_t> mTail {0}; // next byte to write
+};
+
+// One direction of a MemoryStream pair. An end that finds the ring empty (or full) raises its waiting flag, checks
+// the ring again and only then parks on its EventFd, which is registered with that end's reactor, so it resumes on its
+// own executor. The other end only touches the EventFd when the flag is up, so a busy channel makes no syscalls.
+struct MemoryChannel {
+  MemoryChannel(std::size_t capacity, EventFd readerWake, EventFd writerWake)
+      : ring(capacity), readerWake(std::move(readerWake)), writerWake(std::move(writerWake))
+  {
+  }
+
+  auto wakeReader() -> void { Wake(readerWaiting, readerWake); }
+  auto wakeWriter() -> void { Wake(writerWaiting, writerWake); }
+
+  ByteRing ring;
+  std::atomic<bool> writerClosed {false};
+  std::atomic<bool> readerClosed {false};
+  std::atomic<bool> readerWaiting {false};
+  std::atomic<bool> writerWaiting {false};
+  EventFd readerWake;
+  EventFd writerWake;
+
+private:
+  inline static auto Wake(std::atomic<bool>& waiting, EventFd& wake) -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // order the ring update before reading the flag
+    if (waiting.load(std::memory_order_relaxed) && waiting.exchange(false)) {
+      auto r = wake.notify();
+      assert(r);
+    }
+  }
+};
+} // namespace detail
+
+// In-process duplex byte stream with the send/recv awaiters of Socket, for components of one process that would
+// otherwise talk over loopback. Each direction is a lock-free SPSC ring, so data moves with one copy in and one copy
+// out and no syscall while both ends keep up; a parked end is woken through an eventfd on its own reactor.
+//
+// One task at a time may send and one may recv on each end. recv returns 0 once the peer shut down writing (or was
+// destroyed) and the ring is drained; send fails with std::errc::broken_pipe once the peer is gone. Like Socket, an
+// awaiter woken without progress returns std::errc::operation_would_block and the caller retries.
+class MemoryStream {
+public:
+  constexpr static std::size_t DefaultCapacity = 256 << 10;
+
+  // Connects an end waiting on `first` with one waiting on `second`; the reactors may belong to different threads.
+  static auto Pair(Reactor& first, Reactor& second, std::size_t capacity = DefaultCapacity)
+      -> StdResult<std::pair<MemoryStream, MemoryStream>>;
+  inline static auto Pair(Reactor& reactor, std::size_t capacity = DefaultCapacity)
+      -> StdResult<std::pair<MemoryStream, MemoryStream>>
+  {
+    return Pair(reactor, reactor, capacity);
+  }
+
+  MemoryStream() = default;
+  MemoryStream(MemoryStream const&) = delete;
+  MemoryStream(MemoryStream&&) noexcept = default;
+  MemoryStream& operator=(MemoryStream&& other) noexcept
+  {
+    close();
+    mIn = std::move(other.mIn);
+    mOut = std::move(other.mOut);
+    return *this;
+  }
+  ~MemoryStream() { close(); }
+
+  auto send(std::span<std::byte const> data)
+  {
+    struct SendAwaiter {
+      detail::MemoryChannel& channel;
+      std::span<std::byte const> data;
+      StdResult<ssize_t> result {};
+      bool suspendedBefore = false;
+      auto attempt() -> std::optional<StdResult<ssize_t>>
+      {
+        if (channel.readerClosed.load(std::memory_order_acquire)) {
+          return make_unexpected(std::errc::broken_pipe);
+        }
+        if (auto n = channel.ring.write(data); n != 0 || data.empty()) {
+          channel.wakeReader();
+          return ssize_t(n);
+        }
+        return std::nullopt;
+      }
+      auto await_ready() -> bool
+      {
+        if (auto r = attempt(); r) {
+          result = *r;
+          return true;
+        }
+        channel.writerWaiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (auto r = attempt(); r) { // the reader may have made room before it could see the flag
+          channel.writerWaiting.store(false);
+          result = *r;
+          return true;
+        }
+        suspendedBefore = true;
+        return false;
+      }
+      auto await_suspend(std::coroutine_handle<> h) -> void { channel.writerWake.ready().await_suspend(h); }
+      auto await_resume() -> StdResult<ssize_t>
+      {
+        if (!suspendedBefore) {
+          return std::move(result);
+        }
+        channel.writerWake.take();
+        channel.writerWaiting.store(false);
+        return attempt().value_or(make_unexpected(std::errc::operation_would_block));
+      }
+    };
+    assert(mOut);
+    return SendAwaiter {*mOut, data};
+  }
+  auto recv(std::span<std::byte> data)
+  {
+    struct RecvAwaiter {
+      detail::MemoryChannel& channel;
+      std::span<std::byte> data;
+      StdResult<ssize_t> result {};
+      bool suspendedBefore = false;
+      auto attempt() -> std::optional<StdResult<ssize_t>>
+      {
+        auto closed = channel.writerClosed.load(std::memory_order_acquire);
+        if (auto n = channel.ring.read(data); n != 0 || data.empty() || closed) {
+          channel.wakeWriter();
+          return ssize_t(n);
+        }
+        return std::nullopt;
+      }
+      auto await_ready() -> bool
+      {
+        if (auto r = attempt(); r) {
+          result = *r;
+          return true;
+        }
+        channel.readerWaiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (auto r = attempt(); r) {
+          channel.readerWaiting.store(false);
+          result = *r;
+          return true;
+        }
+        suspendedBefore = true;
+        return false;
+      }
+      auto await_suspend(std::coroutine_handle<> h) -> void { channel.readerWake.ready().await_suspend(h); }
+      auto await_resume() -> StdResult<ssize_t>
+      {
+        if (!suspendedBefore) {
+          return std::move(result);
+        }
+        channel.readerWake.take();
+        channel.readerWaiting.store(false);
+        return attempt().value_or(make_unexpected(std::errc::operation_would_block));
+      }
+    };
+    assert(mIn);
+    return RecvAwaiter {*mIn, data};
+  }
+  auto sendAll(std::span<std::byte const> data) -> Task<StdResult<size_t>>
+  {
+    auto sent = size_t {0};
+    while (sent < data.size()) {
+      auto n = co_await send(data.subspan(sent));
+      if (n) {
+        sent += size_t(n.value());
+      } else if (n.error() != std::errc::operation_would_block) {
+        co_return make_unexpected(n.error());
+      }
+    }
+    co_return sent;
+  }
+  // The peer's recv returns 0 once it drained what was sent before.
+  auto shutdownWrite() -> void
+  {
+    if (mOut) {
+      mOut->writerClosed.store(true, std::memory_order_release);
+      mOut->wakeReader();
+    }
+  }
+
+private:
+  MemoryStream(std::shared_ptr<detail::MemoryChannel> in, std::shared_ptr<detail::MemoryChannel> out)
+      : mIn(std::move(in)), mOut(std::move(out))
+  {
+  }
+  auto close() -> void
+  {
+    shutdownWrite();
+    if (mIn) {
+      mIn->readerClosed.store(true, std::memory_order_release);
+      mIn->wakeWriter();
+    }
+    mIn.reset();
+    mOut.reset();
+  }
+
+  std::shared_ptr<detail::MemoryChannel> mIn;
+  std::shared_ptr<detail::MemoryChannel> mOut;
+};
+} // namespace async
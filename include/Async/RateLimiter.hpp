@@ -0,0 +1,152 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "SslSocket.hpp"
+#include "TimerFd.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace async {
+namespace detail {
+struct TokenBucket;
+} // namespace detail
+
+// Token bucket that refills at `rate` bytes per second and holds at most `burst` bytes. Copies share one bucket, so a
+// limiter handed to every stream accepted by a listener caps the listener as a whole, and a named group caps every
+// stream that joined it, wherever it was accepted. Safe to share between threads. A rate of 0 means unlimited.
+class RateLimiter {
+public:
+  using Clock = std::chrono::steady_clock;
+  struct Grant {
+    std::size_t bytes;    // may be sent now
+    Clock::duration wait; // when nothing may be sent, until enough tokens refilled
+  };
+
+  // `burst` defaults to 100ms worth of tokens, but at least 16KB.
+  static auto Create(std::uint64_t bytesPerSecond, std::uint64_t burst = 0) -> RateLimiter;
+  // The limiter registered under `name`, created with the given rate or reconfigured to it.
+  static auto Group(std::string const& name, std::uint64_t bytesPerSecond, std::uint64_t burst = 0) -> RateLimiter;
+  static auto FindGroup(std::string const& name) -> std::optional<RateLimiter>;
+
+  // Unlimited.
+  RateLimiter() = default;
+
+  auto setRate(std::uint64_t bytesPerSecond, std::uint64_t burst = 0) -> void;
+  auto rate() const -> std::uint64_t;
+  auto burst() const -> std::uint64_t;
+  // Takes up to `want` tokens. Small grants are held back until min(want, 16KB) tokens are available so a starved
+  // writer does not send a stream of tiny packets.
+  auto take(std::size_t want, Clock::time_point now = Clock::now()) -> Grant;
+  // Returns tokens taken for bytes that were not sent after all.
+  auto refund(std::size_t bytes) -> void;
+  auto valid() const -> bool { return mBucket != nullptr; }
+
+private:
+  explicit RateLimiter(std::shared_ptr<detail::TokenBucket> bucket) : mBucket(std::move(bucket)) {}
+
+  std::shared_ptr<detail::TokenBucket> mBucket;
+};
+
+// A stream whose sends are limited by every one of a set of RateLimiters, e.g. its own, its listener's and its
+// group's. A send that finds a bucket empty suspends on a timerfd until the bucket refilled instead of spinning, and
+// sends only as much as all buckets granted. recv is passed through.
+//
+// When the stream is a TCP or TLS socket, Create also sets SO_MAX_PACING_RATE to the lowest of the rates, so the
+// kernel spaces out the packets of each grant instead of sending them as a burst. Rates changed later with setRate
+// are not reflected there.
+template <typename Stream>
+class RateLimited {
+public:
+  using SendResult = decltype(std::declval<Stream&>().send(std::span<std::byte const>()).await_resume());
+
+  inline static auto Create(Reactor& reactor, Stream stream, std::vector<RateLimiter> limiters)
+      -> StdResult<RateLimited>
+  {
+    auto timer = TimerFd::Create(reactor);
+    if (!timer) {
+      return make_unexpected(timer.error());
+    }
+    auto pacing = std::uint64_t {0};
+    for (auto& limiter : limiters) {
+      if (limiter.rate() != 0 && (pacing == 0 || limiter.rate() < pacing)) {
+        pacing = limiter.rate();
+      }
+    }
+    if (pacing != 0) {
+      if (auto r = SetPacingRate(stream, pacing); !r) {
+        return make_unexpected(r.error());
+      }
+    }
+    return RateLimited(std::move(stream), std::move(limiters), std::move(timer).value());
+  }
+
+  RateLimited(RateLimited const&) = delete;
+  RateLimited(RateLimited&&) noexcept = default;
+  RateLimited& operator=(RateLimited&&) noexcept = default;
+
+  auto send(std::span<std::byte const> data) -> Task<SendResult>
+  {
+    while (true) {
+      auto grant = acquire(data.size());
+      if (grant.bytes != 0 || data.empty()) {
+        auto n = co_await mStream.send(data.first(grant.bytes));
+        if (auto sent = n ? std::size_t(n.value()) : std::size_t {0}; sent < grant.bytes) {
+          for (auto& limiter : mLimiters) {
+            limiter.refund(grant.bytes - sent);
+          }
+        }
+        co_return n;
+      }
+      auto r = co_await mTimer.sleepFor(grant.wait);
+      assert(r);
+    }
+  }
+  auto recv(std::span<std::byte> data) { return mStream.recv(data); }
+  auto stream() -> Stream& { return mStream; }
+  auto limiters() -> std::vector<RateLimiter>& { return mLimiters; }
+
+private:
+  RateLimited(Stream stream, std::vector<RateLimiter> limiters, TimerFd timer)
+      : mStream(std::move(stream)), mLimiters(std::move(limiters)), mTimer(std::move(timer))
+  {
+  }
+  inline static auto SetPacingRate(Stream& stream, std::uint64_t rate) -> StdResult<void>
+  {
+    auto options = SocketOptions {};
+    options.maxPacingRate = rate;
+    if constexpr (std::derived_from<Stream, Socket>) {
+      return stream.setOptions(options);
+    } else if constexpr (std::derived_from<Stream, SslSocket>) {
+      return impl::Socket(stream.raw()).applyStreamOptions(options);
+    } else {
+      return {};
+    }
+  }
+  // Takes the same amount from every limiter: what the most restrictive one grants.
+  auto acquire(std::size_t want) -> RateLimiter::Grant
+  {
+    auto now = RateLimiter::Clock::now();
+    auto grant = RateLimiter::Grant {want, {}};
+    for (std::size_t i = 0; i < mLimiters.size() && grant.bytes != 0; i++) {
+      auto g = mLimiters[i].take(grant.bytes, now);
+      if (g.bytes < grant.bytes) {
+        for (std::size_t j = 0; j < i; j++) {
+          mLimiters[j].refund(grant.bytes - g.bytes);
+        }
+      }
+      grant = g;
+    }
+    return grant;
+  }
+
+  Stream mStream;
+  std::vector<RateLimiter> mLimiters;
+  TimerFd mTimer;
+};
+} // namespace async
@@ -0,0 +1,126 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "TcpStream.hpp"
+#include "TimerFd.hpp"
+#include "sys/Socket.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace async {
+namespace dns {
+struct Answer {
+  std::vector<Ipv4Addr> addrs;
+  std::uint32_t ttl = 0; // smallest TTL of the returned records, or the negative caching TTL
+  std::uint8_t rcode = 0;
+  bool truncated = false;
+};
+constexpr std::uint8_t RcodeNoError = 0;
+constexpr std::uint8_t RcodeNameError = 3;
+
+// Appends a recursive A/IN query for `name` to `out`. Fails if `name` is not a valid domain name.
+auto BuildQuery(std::uint16_t id, std::string_view name, std::vector<std::byte>& out) -> StdResult<void>;
+// Parses the response to `query`, a message built by BuildQuery, collecting A records and the TTL to cache the answer
+// for. A response whose ID or question section (compared ignoring case) differs from the query's is rejected, so a
+// forged datagram has to guess the question as well as the ID and source port (RFC 5452 section 9.1).
+auto ParseResponse(std::span<std::byte const> message, std::span<std::byte const> query, Answer& answer)
+    -> StdResult<void>;
+} // namespace dns
+
+struct ResolverOptions {
+  std::vector<SocketAddr> nameservers;
+  std::chrono::milliseconds timeout {2000}; // per attempt
+  int attempts = 2;
+  std::filesystem::path hostsFile = "/etc/hosts";
+  std::chrono::seconds maxTtl {3600};
+  std::chrono::seconds negativeTtl {30}; // used when a negative answer carries no SOA record
+  std::size_t maxCacheEntries = 4096;
+
+  // Reads nameservers and the timeout/attempts options from resolv.conf. Falls back to 127.0.0.1 like libc.
+  static auto FromResolvConf(std::filesystem::path const& path = "/etc/resolv.conf") -> ResolverOptions;
+};
+
+// Non-blocking IPv4 name resolver. Queries go over UDP through the Reactor, falling back to TCP for truncated answers.
+// Answers, including failures, are cached for their TTL and concurrent lookups of the same name share one query.
+// A single Resolver is meant to be shared by every coroutine of a runtime. Query IDs come from RAND_bytes.
+//
+// The per-attempt timeouts share one timerfd on the reactor, created on first use: a dispatcher coroutine waits on it
+// and shuts down the socket of an attempt that ran out of time, which wakes the attempt through its own registration.
+// The same dispatcher resumes the lookups that joined a query once it finished, so they continue from the reactor
+// like any other I/O instead of inline on the task that ran the query. Destroying the Resolver destroys the
+// dispatcher, so no lookup may be in flight then.
+//
+// Errors: std::errc::no_such_device_or_address when the name does not exist or has no A record, std::errc::timed_out
+// when no nameserver answered, std::errc::bad_message for malformed answers and std::errc::io_error for server
+// failures.
+class Resolver {
+public:
+  Resolver(Reactor& reactor, ResolverOptions options = ResolverOptions::FromResolvConf());
+  Resolver(Resolver const&) = delete;
+  Resolver& operator=(Resolver const&) = delete;
+  ~Resolver();
+
+  auto resolve(std::string_view name) -> Task<StdResult<std::vector<Ipv4Addr>>>;
+  // Connects to the first address of `host` that accepts a connection.
+  auto connect(std::string_view host, std::uint16_t port) -> Task<StdResult<TcpStream>>;
+  auto clearCache() -> void;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct CacheEntry {
+    std::vector<Ipv4Addr> addrs; // empty for a negative entry
+    Clock::time_point expiry;
+  };
+  struct Inflight {
+    std::vector<std::coroutine_handle<>> waiters;
+    std::optional<StdResult<std::vector<Ipv4Addr>>> result;
+  };
+  class Deadline;
+  // The dispatcher's coroutine. The Resolver owns the frame and destroys it wherever it is suspended.
+  struct Dispatcher {
+    struct promise_type {
+      auto get_return_object() -> Dispatcher
+      {
+        return {std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+      auto final_suspend() noexcept -> std::suspend_always { return {}; }
+      auto return_void() -> void {}
+      auto unhandled_exception() -> void { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  // Creates the timer and starts the dispatcher unless that happened already. Called with mMutex held.
+  auto startDispatcher() -> StdResult<void>;
+  auto dispatch() -> Dispatcher;
+  // Makes the timer expire by `when`, unless it already does. Called with mMutex held.
+  auto armBy(Clock::time_point when) -> void;
+
+  auto lookupCached(std::string const& key) -> std::optional<StdResult<std::vector<Ipv4Addr>>>;
+  auto store(std::string const& key, StdResult<dns::Answer> const& answer) -> StdResult<std::vector<Ipv4Addr>>;
+  auto query(std::string const& name) -> Task<StdResult<dns::Answer>>;
+  auto queryUdp(SocketAddr const& server, std::span<std::byte const> packet) -> Task<StdResult<dns::Answer>>;
+  auto queryTcp(SocketAddr const& server, std::span<std::byte const> packet) -> Task<StdResult<dns::Answer>>;
+  auto loadHosts() -> void;
+
+  Reactor& mReactor;
+  ResolverOptions mOptions;
+  std::unordered_map<std::string, Ipv4Addr> mHosts;
+  std::mutex mMutex;
+  std::unordered_map<std::string, CacheEntry> mCache;
+  std::unordered_map<std::string, std::shared_ptr<Inflight>> mInflight;
+  TimerFd mTimer;
+  Dispatcher mDispatcher;
+  Clock::time_point mArmedBy = Clock::time_point::max(); // when the timer expires next, max while it is disarmed
+  std::multimap<Clock::time_point, Deadline*> mDeadlines; // of the attempts in flight
+  std::vector<std::coroutine_handle<>> mJoined;           // lookups to resume, their query finished
+};
+} // namespace async
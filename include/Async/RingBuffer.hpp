@@ -0,0 +1,89 @@
+#pragma once
+#include "Async/utils/predefined.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+namespace async {
+struct RingBufferOptions {
+  // back the buffer with 2MB huge pages when the system has them to spare, normal pages otherwise
+  bool hugePages = false;
+};
+
+// Byte ring whose pages are mapped twice, back to back, so the readable and the writable region are each one
+// contiguous span even where they wrap around the end. A decoder can parse a message straddling the end in place,
+// and recv and send take the spans directly:
+//
+//   auto n = co_await socket.recv(ring.writable());
+//   ring.commit(n.value());
+//   ... parse ring.readable(), then ring.consume(parsed);
+//
+// The capacity is rounded up to a power of two number of pages. Not thread-safe.
+class RingBuffer {
+public:
+  static auto Create(std::size_t capacity, RingBufferOptions options = {}) -> StdResult<RingBuffer>;
+
+  RingBuffer() = default;
+  RingBuffer(RingBuffer const&) = delete;
+  RingBuffer(RingBuffer&& other) noexcept
+      : mReservation(std::exchange(other.mReservation, nullptr)), mReserved(std::exchange(other.mReserved, 0)),
+        mData(std::exchange(other.mData, nullptr)), mMask(std::exchange(other.mMask, 0)),
+        mHead(std::exchange(other.mHead, 0)), mTail(std::exchange(other.mTail, 0)),
+        mHugePages(std::exchange(other.mHugePages, false))
+  {
+  }
+  RingBuffer& operator=(RingBuffer&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      mReservation = std::exchange(other.mReservation, nullptr);
+      mReserved = std::exchange(other.mReserved, 0);
+      mData = std::exchange(other.mData, nullptr);
+      mMask = std::exchange(other.mMask, 0);
+      mHead = std::exchange(other.mHead, 0);
+      mTail = std::exchange(other.mTail, 0);
+      mHugePages = std::exchange(other.mHugePages, false);
+    }
+    return *this;
+  }
+  ~RingBuffer() { reset(); }
+
+  // The bytes written and not consumed yet, oldest first.
+  auto readable() const -> std::span<std::byte> { return {mData + (mHead & mMask), mTail - mHead}; }
+  // The free space after the readable bytes.
+  auto writable() const -> std::span<std::byte> { return {mData + (mTail & mMask), capacity() - size()}; }
+  // Makes the first `n` bytes of writable() readable.
+  auto commit(std::size_t n) -> void
+  {
+    assert(n <= capacity() - size());
+    mTail += n;
+  }
+  // Drops the first `n` bytes of readable().
+  auto consume(std::size_t n) -> void
+  {
+    assert(n <= size());
+    mHead += n;
+  }
+  auto clear() -> void { mHead = mTail = 0; }
+  auto size() const -> std::size_t { return mTail - mHead; }
+  auto capacity() const -> std::size_t { return mData != nullptr ? mMask + 1 : 0; }
+  auto empty() const -> bool { return mTail == mHead; }
+  auto full() const -> bool { return size() == capacity(); }
+  // Whether the buffer got huge pages.
+  auto hugePages() const -> bool { return mHugePages; }
+
+private:
+  static auto Map(std::size_t size, std::size_t pageSize, bool hugePages) -> StdResult<RingBuffer>;
+  auto reset() -> void;
+
+  void* mReservation = nullptr; // the whole mapping, which may start before mData for huge page alignment
+  std::size_t mReserved = 0;
+  std::byte* mData = nullptr;
+  std::size_t mMask = 0;
+  std::size_t mHead = 0;
+  std::size_t mTail = 0;
+  bool mHugePages = false;
+};
+} // namespace async
@@ -0,0 +1,67 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include "sys/Socket.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace async {
+namespace detail {
+// Intrusive multi-producer single-consumer list of nodes with a `next` pointer. push is lock-free and may be called
+// from any thread; the consumer takes everything pushed so far at once, oldest first.
+template <typename Node>
+class MpscList {
+public:
+  auto push(Node* node) -> void
+  {
+    auto head = mHead.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!mHead.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+  }
+  auto takeAll() -> Node*
+  {
+    auto node = mHead.exchange(nullptr, std::memory_order_acquire);
+    auto fifo = (Node*)nullptr;
+    while (node != nullptr) { // pushes build a stack, reverse it into arrival order
+      auto next = node->next;
+      node->next = fifo;
+      fifo = node;
+      node = next;
+    }
+    return fifo;
+  }
+  auto empty() const -> bool { return mHead.load(std::memory_order_acquire) == nullptr; }
+
+private:
+  std::atomic<Node*> mHead {nullptr};
+};
+} // namespace detail
+
+// Multi-producer submission queue for a stream. Tasks on any executor thread hand whole messages to send(); the first
+// sender to find the queue idle becomes the only writer, so messages are never interleaved and only one task ever
+// waits for the socket to become writable. Other senders return as soon as their message is queued. The writer
+// flushes everything submitted meanwhile with vectored sends until its own message is out; when more is queued by then
+// it hands the rest to a drain task of the queue's own, resumed by the reactor, instead of writing for every other
+// sender for as long as they keep up.
+//
+// After a send error the queue stops writing and every later send() reports that error. The queue may be destroyed
+// while that drain is still running; the stream must outlive both.
+class SendQueue {
+public:
+  constexpr static std::size_t MaxBatch = 64; // messages gathered into one sendmsg
+
+  explicit SendQueue(Socket& stream);
+  SendQueue(SendQueue const&) = delete;
+  SendQueue& operator=(SendQueue const&) = delete;
+
+  auto send(std::vector<std::byte> message) -> Task<StdResult<void>>;
+
+private:
+  struct State;
+
+  std::shared_ptr<State> mState; // shared with the drain task
+};
+} // namespace async
@@ -0,0 +1,55 @@
+#pragma once
+#include "AsyncFd.hpp"
+
+#include <csignal>
+#include <initializer_list>
+#include <sys/signalfd.h>
+
+namespace async {
+// Receives signals as awaitable events instead of running an async-signal-safe handler. The signals are blocked for
+// the calling thread; threads started afterwards inherit the mask, so create it before starting a multi-threaded
+// runtime or the signals may still be delivered to another thread.
+class SignalFd {
+public:
+  inline static auto Create(Reactor& reactor, std::initializer_list<int> signals) -> StdResult<SignalFd>
+  {
+    auto mask = sigset_t {};
+    sigemptyset(&mask);
+    for (auto signal : signals) {
+      sigaddset(&mask, signal);
+    }
+    if (auto r = ::pthread_sigmask(SIG_BLOCK, &mask, nullptr); r != 0) {
+      return make_unexpected(std::errc(r));
+    }
+    if (auto fd = SysCall(::signalfd, -1, &mask, SFD_NONBLOCK | SFD_CLOEXEC); !fd) {
+      return make_unexpected(fd.error());
+    } else {
+      return AsyncFd::Create(reactor, fd.value()).map([](AsyncFd fd) { return SignalFd(std::move(fd)); });
+    }
+  }
+
+  SignalFd() = default;
+  SignalFd(SignalFd&&) = default;
+  SignalFd& operator=(SignalFd&&) = default;
+
+  // Waits for the next signal.
+  auto wait()
+  {
+    return mFd.io(
+        [fd = mFd.raw()]() -> StdResult<signalfd_siginfo> {
+          auto info = signalfd_siginfo {};
+          if (auto r = SysCall(::read, fd, &info, sizeof(info)); !r) {
+            return make_unexpected(r.error());
+          }
+          return info;
+        },
+        Interest::Read);
+  }
+  auto raw() const -> impl::fd_t { return mFd.raw(); }
+
+private:
+  explicit SignalFd(AsyncFd fd) : mFd(std::move(fd)) {}
+
+  AsyncFd mFd;
+};
+} // namespace async
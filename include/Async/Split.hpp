@@ -0,0 +1,124 @@
+#pragma once
+#include "sys/Socket.hpp"
+
+#include <memory>
+#include <mutex>
+
+namespace async {
+template <typename Stream>
+class ReadHalf;
+template <typename Stream>
+class WriteHalf;
+
+namespace detail {
+// Stream shared by the two halves of a split. The halves may wait on different executor threads at the same time;
+// the reactor derives the interest of a source from both waiting directions, so their registrations are serialized.
+template <typename Stream>
+struct SplitState {
+  explicit SplitState(Stream stream) : stream(std::move(stream)) {}
+
+  Stream stream;
+  std::mutex mutex;
+
+  template <typename Op>
+  auto io(Op op, bool write)
+  {
+    struct HalfAwaiter {
+      SplitState& state;
+      Op op;
+      bool write;
+      StdResult<ssize_t> result {};
+      bool suspendedBefore = false;
+      auto await_ready() noexcept -> bool
+      {
+        auto n = op();
+        if (!n && detail::WouldBlock(n.error())) {
+          suspendedBefore = true;
+          return false;
+        }
+        result = n;
+        return true;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) -> void
+      {
+        auto lock = std::lock_guard(state.mutex);
+        auto& socket = static_cast<Socket&>(state.stream);
+        auto r = write ? socket.regW(handle) : socket.regR(handle);
+        assert(r);
+      }
+      auto await_resume() -> StdResult<ssize_t> { return suspendedBefore ? op() : std::move(result); }
+    };
+    return HalfAwaiter {*this, std::move(op), write};
+  }
+  auto recv(std::span<std::byte> data)
+  {
+    return io([this, data] { return stream.getSocket().recvNonBlock(data, 0); }, false);
+  }
+  auto send(std::span<std::byte const> data)
+  {
+    return io([this, data] { return stream.getSocket().sendNonBlock(data, 0); }, true);
+  }
+  auto sendv(std::span<iovec const> iov)
+  {
+    return io([this, iov] { return stream.getSocket().sendvNonBlock(iov); }, true);
+  }
+};
+} // namespace detail
+
+// Splits a stream into halves that can be used from two tasks, also on different executor threads: one receiving
+// while the other sends. reunite() puts the stream back together once neither half is in use.
+template <typename Stream>
+auto Split(Stream stream) -> std::pair<ReadHalf<Stream>, WriteHalf<Stream>>
+{
+  auto state = std::make_shared<detail::SplitState<Stream>>(std::move(stream));
+  return {ReadHalf<Stream>(state), WriteHalf<Stream>(std::move(state))};
+}
+
+template <typename Stream>
+class ReadHalf {
+public:
+  ReadHalf() = default;
+  ReadHalf(ReadHalf const&) = delete;
+  ReadHalf(ReadHalf&&) = default;
+  ReadHalf& operator=(ReadHalf&&) = default;
+
+  auto recv(std::span<std::byte> data) { return mState->recv(data); }
+  // Fails with std::errc::invalid_argument if `write` is the half of another stream.
+  auto reunite(WriteHalf<Stream>&& write) && -> StdResult<Stream>
+  {
+    if (mState == nullptr || mState != write.mState) {
+      return make_unexpected(std::errc::invalid_argument);
+    }
+    write.mState.reset();
+    auto state = std::move(mState);
+    return StdResult<Stream>(std::move(state->stream));
+  }
+
+private:
+  template <typename S>
+  friend auto Split(S stream) -> std::pair<ReadHalf<S>, WriteHalf<S>>;
+  explicit ReadHalf(std::shared_ptr<detail::SplitState<Stream>> state) : mState(std::move(state)) {}
+
+  std::shared_ptr<detail::SplitState<Stream>> mState;
+};
+
+template <typename Stream>
+class WriteHalf {
+public:
+  WriteHalf() = default;
+  WriteHalf(WriteHalf const&) = delete;
+  WriteHalf(WriteHalf&&) = default;
+  WriteHalf& operator=(WriteHalf&&) = default;
+
+  auto send(std::span<std::byte const> data) { return mState->send(data); }
+  auto sendv(std::span<iovec const> iov) { return mState->sendv(iov); }
+
+private:
+  friend class ReadHalf<Stream>;
+  template <typename S>
+  friend auto Split(S stream) -> std::pair<ReadHalf<S>, WriteHalf<S>>;
+  explicit WriteHalf(std::shared_ptr<detail::SplitState<Stream>> state) : mState(std::move(state)) {}
+
+  std::shared_ptr<detail::SplitState<Stream>> mState;
+};
+} // namespace async
@@ -4,10 +4,10 @@
 namespace async {
 class SslListener : public SslSocket {
 public:
-  inline static auto Bind(TlsContext& ctx, async::Reactor& reactor, SocketAddr const& addr)
-      -> Expected<SslListener, std::string>
+  inline static auto Bind(TlsContext& ctx, async::Reactor& reactor, SocketAddr const& addr,
+                          SocketOptions options = {}) -> Expected<SslListener, std::string>
   {
-    auto listener = TcpListener::Bind(reactor, addr);
+    auto listener = TcpListener::Bind(reactor, addr, options);
     if(!listener) {
       return make_unexpected(strerror(int(listener.error())));
     }
@@ -16,16 +16,51 @@ public:
       return make_unexpected(sslSocket.error().message());
     }
     auto socket = std::move(sslSocket).value();
-    return SslListener(std::move(socket));
+    return SslListener(std::move(socket), std::move(options));
   }
   SslListener() = default;
-  SslListener(SslSocket&& socket) : SslSocket(std::move(socket)) {}
+  SslListener(SslSocket&& socket, SocketOptions options = {})
+      : SslSocket(std::move(socket)), mOptions(std::move(options))
+  {
+  }
   SslListener(SslListener const&) = delete;
   SslListener(SslListener&& other) noexcept = default;
   SslListener& operator=(SslListener const&) = delete;
   SslListener& operator=(SslListener&& other) noexcept = default;
   ~SslListener() = default;
 
-  auto accept(TlsContext& ctx, SocketAddr* addr) { return SslSocket::accept(ctx, addr); }
+  auto accept(TlsContext& ctx, SocketAddr* addr) { return SslSocket::accept(ctx, addr, &mOptions); }
+  // See TcpListener::setAdmission.
+  auto setAdmission(AdmissionOptions options) -> StdResult<void>
+  {
+    return AdmissionControl::Create(*socket().reactor(), std::move(options)).map([this](auto control) {
+      mAdmission = std::move(control);
+    });
+  }
+  // Like accept under the admission policy, see TcpListener::admit. The permit is taken before the handshake, which
+  // counts towards the CoDel sojourn time. An accept failure is SSL_ERROR_SYSCALL with its errno in sysError.
+  auto admit(TlsContext& ctx, SocketAddr* addr) -> Task<Expected<Admitted<SslSocket>, SslError>>
+  {
+    if (!mAdmission) {
+      if (auto r = setAdmission({}); !r) {
+        co_return make_unexpected(SslError::FromErrc(r.error()));
+      }
+    }
+    auto admitted = co_await mAdmission->accept(socket(), addr, &mOptions);
+    if (!admitted) {
+      co_return make_unexpected(SslError::FromErrc(admitted.error()));
+    }
+    auto permit = std::move(admitted->permit);
+    auto stream = co_await Handshake(ctx, std::move(admitted->stream));
+    if (!stream) {
+      co_return make_unexpected(stream.error());
+    }
+    co_return Admitted<SslSocket> {std::move(stream).value(), std::move(permit)};
+  }
+  auto admission() const -> AdmissionControl const* { return mAdmission.get(); }
+
+private:
+  SocketOptions mOptions;
+  std::shared_ptr<AdmissionControl> mAdmission;
 };
 } // namespace async
\ No newline at end of file
@@ -1,11 +1,15 @@
 #pragma once
 #include "TlsContext.hpp"
+#include "sys/IoError.hpp"
 #include "sys/Socket.hpp"
 
 namespace async {
 struct SslError {
   inline static auto GetError(SSL* ssl, int r) -> SslError { return {SSL_get_error(ssl, r)}; }
+  // A failed system call outside OpenSSL, such as accept, keeping its errno.
+  inline static auto FromErrc(std::errc e) -> SslError { return {SSL_ERROR_SYSCALL, e}; }
   int code;
+  std::errc sysError {}; // the errno behind SSL_ERROR_SYSCALL, when it is known
   static const SslError Ok;
   static const SslError SysCallError;
   auto ok() -> bool { return SSL_ERROR_NONE == code; }
@@ -32,7 +36,7 @@ struct SslError {
     case SSL_ERROR_WANT_X509_LOOKUP:
       return "SSL_ERROR_WANT_X509_LOOKUP";
     case SSL_ERROR_SYSCALL:
-      return strerror(errno);
+      return strerror(sysError != std::errc {} ? int(sysError) : errno);
     case SSL_ERROR_SSL:
       return "SSL_ERROR_SSL";
     default:
@@ -43,9 +47,28 @@ struct SslError {
 inline const SslError SslError::Ok = {SSL_ERROR_NONE};
 inline const SslError SslError::SysCallError = {SSL_ERROR_SYSCALL};
 
+namespace detail {
+template <>
+struct IoErrorTraits<SslError> {
+  static auto WouldBlock(SslError e) -> bool { return e.wait(); }
+  // a TLS socket reports the end of the stream as SSL_ERROR_ZERO_RETURN
+  static auto IsEof(SslError e) -> bool { return e.code == SSL_ERROR_ZERO_RETURN; }
+  static auto ToErrc(SslError e) -> std::errc
+  {
+    if (e.code == SSL_ERROR_SYSCALL && e.sysError != std::errc {}) {
+      return e.sysError;
+    }
+    return e.code == SSL_ERROR_ZERO_RETURN ? std::errc::connection_reset : std::errc::io_error;
+  }
+};
+} // namespace detail
+
 class SslSocket {
 public:
+  friend class CoreRuntime;
   friend class SslStream;
+  template <typename Stream>
+  friend struct detail::SplitState;
   struct SslDeleter {
     void operator()(SSL* ssl) const noexcept { SSL_free(ssl); }
   };
@@ -60,10 +83,15 @@ public:
     if (auto r = SSL_set_fd(ssl, socket.getSocket().raw()); r == 0) {
       return make_unexpected(OpenSSLError::GetLastErr());
     };
-    return SslSocket(ssl, std::move(socket));
+    auto sslSocket = SslSocket(ssl, std::move(socket), ctx.recordSizing());
+    sslSocket.mLeanIdle = ctx.leanIdle();
+    return sslSocket;
   }
   SslSocket() : mSsl(nullptr) {}
-  SslSocket(SSL* ssl, Socket&& socket) : mSocket(std::move(socket)), mSsl(ssl) {}
+  SslSocket(SSL* ssl, Socket&& socket, TlsRecordSizing sizing = {})
+      : mSocket(std::move(socket)), mSsl(ssl), mSizer(sizing)
+  {
+  }
   SslSocket(SslSocket const&) = delete;
   SslSocket(SslSocket&& other) = default;
   SslSocket& operator=(SslSocket const&) = delete;
@@ -97,197 +125,72 @@ public:
   }
   auto send(std::span<std::byte const> data)
   {
-    struct WritableAwaiter {
-      SslSocket& socket;
-      std::span<std::byte const> data;
-      Expected<size_t, SslError> result;
-      bool suspendedBefore = false;
-      bool isReadable = false;
-      auto await_ready() -> bool
-      {
-        auto e = SSL_write(socket.ssl(), data.data(), data.size());
-        if (e > 0) {
-          result = e;
-          return true;
-        } else if (e <= 0) {
-          auto error = SslError::GetError(socket.ssl(), e);
-          if (error.waitReadable()) {
-            suspendedBefore = true;
-            isReadable = true;
-            return false;
-          } else if (error.waitWritable()) {
-            suspendedBefore = true;
-            isReadable = false;
-            return false;
-          } else {
-            result = make_unexpected(error);
-            return true;
-          }
-        }
-        assert(0);
-      }
-      auto await_suspend(std::coroutine_handle<> h) -> void
-      {
-        if (isReadable) {
-          auto r = socket.mSocket.regR(h);
-          assert(r);
-        } else {
-          auto r = socket.mSocket.regW(h);
-          assert(r);
-        }
-      }
-      auto await_resume() -> Expected<size_t, SslError>
-      {
-        if (suspendedBefore) {
-          auto e = SSL_write(socket.ssl(), data.data(), data.size());
-          if (e > 0) {
-            return e;
-          } else if (e <= 0) {
-            auto error = SslError::GetError(socket.ssl(), e);
-            return make_unexpected(error);
-          }
-        } else {
-          return std::move(result);
-        }
-        assert(0);
+    return io([this, data]() -> Expected<size_t, SslError> {
+      if (auto e = write(data); e > 0) {
+        return size_t(e);
+      } else {
+        return make_unexpected(SslError::GetError(ssl(), e));
       }
-    };
-    return WritableAwaiter {*this, data};
+    });
   }
-
   auto recv(std::span<std::byte> data)
   {
-    struct ReadableAwaiter {
+    return io([this, data] { return read(data); });
+  }
+  // Waits until SSL_read can make progress without touching the SSL object while the socket has nothing to read.
+  auto readable()
+  {
+    struct ReadyAwaiter {
       SslSocket& socket;
-      std::span<std::byte> data;
-      Expected<size_t, SslError> result;
-      bool suspendedBefore = false;
-      bool isReadable = false;
-      auto await_ready() -> bool
-      {
-        auto e = SSL_read(socket.ssl(), data.data(), data.size());
-        if (e > 0) {
-          result = e;
-          return true;
-        } else if (e <= 0) {
-          auto error = SslError::GetError(socket.ssl(), e);
-          if (error.waitReadable()) {
-            suspendedBefore = true;
-            isReadable = true;
-            return false;
-          } else if (error.waitWritable()) {
-            suspendedBefore = true;
-            isReadable = false;
-            return false;
-          } else {
-            result = make_unexpected(error);
-            return true;
-          }
-        }
-        assert(0);
-      }
+      auto await_ready() -> bool { return socket.readReady(); }
       auto await_suspend(std::coroutine_handle<> h) -> void
       {
-        if (isReadable) {
-          auto r = socket.mSocket.regR(h);
-          assert(r);
-        } else {
-          auto r = socket.mSocket.regW(h);
-          assert(r);
-        }
-      }
-      auto await_resume() -> Expected<size_t, SslError>
-      {
-        if (suspendedBefore) {
-          auto e = SSL_read(socket.ssl(), data.data(), data.size());
-          if (e > 0) {
-            return e;
-          } else if (e <= 0) {
-            auto error = SslError::GetError(socket.ssl(), e);
-            return make_unexpected(error);
-          }
-        } else {
-          return std::move(result);
-        }
-        assert(0);
+        auto r = socket.mSocket.regR(h);
+        assert(r);
       }
+      auto await_resume() noexcept -> void {}
     };
-    return ReadableAwaiter {*this, data};
+    return ReadyAwaiter {*this};
+  }
+  // Suspends until the socket is writable, without touching the SSL object.
+  auto writable() { return mSocket.writable(); }
+  // Per-socket override of TlsContext::setLeanIdle.
+  auto setLeanIdle(bool lean) -> void
+  {
+    if (lean) {
+      SSL_set_mode(ssl(), SSL_MODE_RELEASE_BUFFERS);
+    } else {
+      SSL_clear_mode(ssl(), SSL_MODE_RELEASE_BUFFERS);
+    }
+    mLeanIdle = lean;
+    mReadStarved = mReadStarved && lean;
   }
 
+  // Sends from `file` through kernel TLS; fails unless kTLS is active for sending (see ktlsSend()).
   auto sendfile(impl::fd_t file, off_t offset, size_t size)
   {
-    struct SendfileAwaiter {
-      SslSocket& socket;
-      impl::fd_t file;
-      off_t offset;
-      size_t size;
-      Expected<size_t, SslError> result;
-      bool suspendedBefore = false;
-      bool isReadable = false;
-      auto await_ready() -> bool
-      {
-        auto e = SSL_sendfile(socket.ssl(), file, offset, size, 0); // flag is ignored on linux platform
-        if (e >= 0) {
-          result = e;
-          return true;
-        } else if (e < 0) {
-          auto error = SslError::GetError(socket.ssl(), e);
-          if (error.waitReadable()) {
-            suspendedBefore = true;
-            isReadable = true;
-            return false;
-          } else if (error.waitWritable()) {
-            suspendedBefore = true;
-            isReadable = false;
-            return false;
-          } else {
-            result = make_unexpected(error);
-            return true;
-          }
-        }
-        assert(0);
-      }
-      auto await_suspend(std::coroutine_handle<> h) -> void
-      {
-        if (isReadable) {
-          auto r = socket.mSocket.regR(h);
-          assert(r);
-        } else {
-          auto r = socket.mSocket.regW(h);
-          assert(r);
-        }
-      }
-      auto await_resume() -> Expected<size_t, SslError>
-      {
-        if (suspendedBefore) {
-          auto e = SSL_sendfile(socket.ssl(), file, offset, size, 0);
-          if (e >= 0) {
-            return e;
-          } else if (e < 0) {
-            auto error = SslError::GetError(socket.ssl(), e);
-            return make_unexpected(error);
-          }
-        } else {
-          return std::move(result);
-        }
-        assert(0);
+    return io([this, file, offset, size]() -> Expected<size_t, SslError> {
+      if (auto e = SSL_sendfile(ssl(), file, offset, size, 0); e >= 0) { // flag is ignored on linux platform
+        return size_t(e);
+      } else {
+        return make_unexpected(SslError::GetError(ssl(), int(e)));
       }
-    };
-    return SendfileAwaiter {*this, file, offset, size};
+    });
   }
+  // Whether records are encrypted by the kernel, which SSL_sendfile requires.
+  auto ktlsSend() -> bool { return BIO_get_ktls_send(SSL_get_wbio(ssl())); }
   auto sendAll(std::span<std::byte const> buffer) -> Task<Expected<size_t, SslError>>
   {
-    while (true) {
-      auto n = co_await send(buffer);
+    auto sent = size_t {0};
+    while (sent < buffer.size()) {
+      auto n = co_await send(buffer.subspan(sent));
       if (n) {
-        co_return n;
-      } else if (!n && n.error().wait()) {
-        continue;
-      } else {
+        sent += n.value();
+      } else if (!n.error().wait()) {
         co_return make_unexpected(n.error());
       }
     }
+    co_return sent;
   }
   auto recvAll(std::span<std::byte> buffer) -> Task<Expected<size_t, SslError>>
   {
@@ -304,15 +207,17 @@ public:
   }
   auto sendfileAll(impl::fd_t file, off_t offset, size_t size) -> Task<Expected<size_t, SslError>>
   {
+    auto sent = size_t {0};
     while (true) {
       auto n = co_await sendfile(file, offset, size);
       if (n) {
-        if (n.value() < size) {
+        sent += n.value();
+        if (n.value() != 0 && n.value() < size) {
           size -= n.value();
           offset += n.value();
           continue;
         }
-        co_return n;
+        co_return sent;
       } else if (!n && n.error().wait()) {
         continue;
       } else {
@@ -324,13 +229,23 @@ public:
   auto raw() -> impl::fd_t { return mSocket.getSocket().raw(); }
 
 protected:
-  auto accept(TlsContext& ctx, SocketAddr* addr) -> Task<Expected<SslSocket, SslError>>
+  auto socket() -> Socket& { return mSocket; }
+  auto accept(TlsContext& ctx, SocketAddr* addr, SocketOptions const* options = nullptr)
+      -> Task<Expected<SslSocket, SslError>>
   {
-    // TODO error handling
-    auto socket = co_await mSocket.accept(addr);
-    assert(socket);
-    auto sslSocket = SslSocket::Create(ctx, std::move(socket.value()));
-    assert(sslSocket);
+    auto socket = co_await mSocket.accept(addr, options);
+    if (!socket) {
+      co_return make_unexpected(SslError::FromErrc(socket.error()));
+    }
+    co_return co_await Handshake(ctx, std::move(socket).value());
+  }
+  // Runs the server side of the TLS handshake on an accepted socket.
+  inline static auto Handshake(TlsContext& ctx, Socket socket) -> Task<Expected<SslSocket, SslError>>
+  {
+    auto sslSocket = SslSocket::Create(ctx, std::move(socket));
+    if (!sslSocket) {
+      co_return make_unexpected(SslError {SSL_ERROR_SSL});
+    }
     struct AcceptAwaiter {
       SslSocket& socket;
       SslError result;
@@ -397,7 +312,105 @@ protected:
   }
 
 private:
+  // Awaits one OpenSSL call `op`: when OpenSSL wants the socket to become readable or writable first, waits for that
+  // and runs it once more.
+  template <typename Op>
+  struct IoAwaiter {
+    SslSocket& socket;
+    Op op;
+    Expected<size_t, SslError> result {};
+    bool suspendedBefore = false;
+    auto await_ready() -> bool
+    {
+      result = op();
+      if (!result && result.error().wait()) {
+        suspendedBefore = true;
+        return false;
+      }
+      return true;
+    }
+    auto await_suspend(std::coroutine_handle<> h) -> void
+    {
+      auto r = result.error().waitReadable() ? socket.mSocket.regR(h) : socket.mSocket.regW(h);
+      assert(r);
+    }
+    auto await_resume() -> Expected<size_t, SslError> { return suspendedBefore ? op() : std::move(result); }
+  };
+  template <typename Op>
+  auto io(Op op) -> IoAwaiter<Op>
+  {
+    return {*this, std::move(op)};
+  }
+  // Whether SSL_read has buffered plaintext or the socket has bytes or EOF to read. Errors count as ready so SSL_read
+  // reports them.
+  auto readReady() -> bool
+  {
+    if (SSL_has_pending(ssl())) {
+      return true;
+    }
+    auto byte = std::byte {};
+    auto n = mSocket.getSocket().recvNonBlock(std::span(&byte, 1), MSG_PEEK);
+    return n || !detail::WouldBlock(n.error());
+  }
+  // SSL_read. In lean mode a read that came up empty makes the following ones peek at the socket first and skip
+  // SSL_read while it has nothing, since an SSL_read finding nothing allocates the read buffer only to release it
+  // again. A connection that keeps finding data never peeks.
+  auto read(std::span<std::byte> data) -> Expected<size_t, SslError>
+  {
+    if (mReadStarved) {
+      if (!readReady()) {
+        return make_unexpected(SslError {SSL_ERROR_WANT_READ});
+      }
+      mReadStarved = false;
+    }
+    if (auto e = SSL_read(ssl(), data.data(), int(data.size())); e > 0) {
+      return size_t(e);
+    } else {
+      auto error = SslError::GetError(ssl(), e);
+      mReadStarved = mLeanIdle && error.waitReadable();
+      return make_unexpected(error);
+    }
+  }
+  // SSL_write with the record size picked by the sizer. Until the sizer boosts, a write goes out in pieces of at most
+  // its remaining budget, so the records of a single large write grow once the threshold is crossed. A piece that has
+  // to be retried keeps its length and record size, since OpenSSL expects the retry to continue the records it already
+  // built; if earlier pieces went out, the bytes written so far are returned and the caller retries from there.
+  auto write(std::span<std::byte const> data) -> int
+  {
+    auto written = 0;
+    while (true) {
+      if (mSizer.enabled() && !mWritePending) {
+        if (auto size = mSizer.next(detail::RecordSizer::Clock::now()); size != mRecordSize) {
+          // lowering the maximum also lowers the split fragment, which then sizes the records even after it grows
+          SSL_set_max_send_fragment(mSsl.get(), size);
+          SSL_set_split_send_fragment(mSsl.get(), size);
+          mRecordSize = size;
+        }
+        mWriteLength = std::min(data.size(), mSizer.budget());
+      }
+      auto piece = mSizer.enabled() ? data.first(std::min(data.size(), mWriteLength)) : data;
+      auto e = SSL_write(mSsl.get(), piece.data(), int(piece.size()));
+      auto error = e > 0 ? SslError::Ok : SslError::GetError(mSsl.get(), e);
+      mWritePending = error.wait();
+      if (e <= 0) {
+        return written > 0 ? written : e;
+      }
+      mSizer.sent(std::size_t(e));
+      written += e;
+      data = data.subspan(std::size_t(e));
+      if (data.empty()) {
+        return written;
+      }
+    }
+  }
+
   Socket mSocket;
   SslPtr mSsl {nullptr};
+  detail::RecordSizer mSizer;
+  std::size_t mRecordSize = 0;
+  std::size_t mWriteLength = 0; // length of the piece a pending write has to be retried with
+  bool mWritePending = false;
+  bool mLeanIdle = false;
+  bool mReadStarved = false; // the last SSL_read wanted more data, lean mode only
 };
 } // namespace async
\ No newline at end of file
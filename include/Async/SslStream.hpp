@@ -1,7 +1,13 @@
 #pragma once
 #include "SslSocket.hpp"
 
+#include "EventFd.hpp"
+#include "Split.hpp"
 #include "TcpStream.hpp"
+
+#include <optional>
+#include <vector>
+
 namespace async {
 class SslStream : public SslSocket {
 public:
@@ -90,5 +96,177 @@ public:
   SslStream& operator=(SslStream const&) = delete;
   SslStream& operator=(SslStream&& other) noexcept = default;
   ~SslStream() = default;
+
+  auto split() && -> std::pair<ReadHalf<SslStream>, WriteHalf<SslStream>>;
 };
+
+namespace detail {
+// The halves of a TLS stream share one SSL object, which OpenSSL does not allow to be used concurrently, so every
+// SSL_read and SSL_write runs under the mutex. Either call may need the opposite direction (SSL_read flushing a key
+// update, SSL_write reading a renegotiation). When the other half already waits on the direction a half needs, the
+// half cannot register for it as well; it queues behind that wait instead and retries once the other half woke up.
+// The queued halves are resumed by a dispatcher coroutine on the stream's reactor, not inline on whichever thread woke
+// the other half, so a half split off to another thread still runs where the reactor runs it.
+template <>
+struct SplitState<SslStream> {
+  explicit SplitState(SslStream stream) : stream(std::move(stream)) {}
+  SplitState(SplitState const&) = delete;
+  ~SplitState()
+  {
+    if (dispatching != nullptr) {
+      *dispatching = true; // destroyed by a half it resumed, the dispatcher ends itself once that returns
+    } else if (dispatcher.handle) {
+      dispatcher.handle.destroy();
+    }
+  }
+
+  SslStream stream;
+  std::mutex mutex;
+  bool reading = false; // a half is registered for readability
+  bool writing = false;
+  std::vector<std::coroutine_handle<>> afterRead; // halves waiting for the registered read to complete
+  std::vector<std::coroutine_handle<>> afterWrite;
+  std::vector<std::coroutine_handle<>> handedOver; // followers the dispatcher resumes next
+
+  struct Dispatcher {
+    struct promise_type {
+      auto get_return_object() -> Dispatcher { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+      auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+      auto final_suspend() noexcept -> std::suspend_never { return {}; }
+      auto return_void() -> void {}
+      auto unhandled_exception() -> void { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+  };
+  std::optional<EventFd> wake; // created with the first hand-over
+  Dispatcher dispatcher;
+  bool* dispatching = nullptr; // set while the dispatcher resumes halves
+
+  // Passes `followers` to the dispatcher, starting it on the stream's reactor the first time; the mutex is held.
+  // Leaves them in `followers` to be resumed inline if there is no descriptor for the wake-up.
+  auto handOver(std::vector<std::coroutine_handle<>>& followers) -> void
+  {
+    if (!dispatcher.handle) {
+      auto event = EventFd::Create(*stream.mSocket.reactor());
+      if (!event) {
+        return;
+      }
+      wake.emplace(std::move(event).value());
+      dispatcher = dispatch();
+      dispatcher.handle.resume(); // up to its first wait
+    }
+    handedOver.insert(handedOver.end(), followers.begin(), followers.end());
+    followers.clear();
+    auto r = wake->notify();
+    assert(r);
+  }
+  auto dispatch() -> Dispatcher
+  {
+    while (true) {
+      co_await wake->ready();
+      wake->take();
+      auto handles = std::vector<std::coroutine_handle<>>();
+      {
+        auto lock = std::lock_guard(mutex);
+        handles.swap(handedOver);
+      }
+      auto destroyed = false;
+      dispatching = &destroyed;
+      for (auto handle : handles) {
+        handle.resume();
+        if (destroyed) {
+          co_return;
+        }
+      }
+      dispatching = nullptr;
+    }
+  }
+
+  template <typename Op>
+  auto io(Op op)
+  {
+    struct HalfAwaiter {
+      SplitState& state;
+      Op op;
+      Expected<size_t, SslError> result {};
+      bool suspendedBefore = false;
+      bool registered = false; // with the reactor, rather than behind the other half
+      bool wantRead = false;
+      auto call() -> Expected<size_t, SslError>
+      {
+        auto lock = std::lock_guard(state.mutex);
+        return op();
+      }
+      auto await_ready() -> bool
+      {
+        result = call();
+        suspendedBefore = !result && result.error().wait();
+        return !suspendedBefore;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) -> bool
+      {
+        auto lock = std::lock_guard(state.mutex);
+        // the other half may have run in between and done what this call waited for, e.g. read the records it needs
+        result = op();
+        if (result || !result.error().wait()) {
+          suspendedBefore = false;
+          return false;
+        }
+        wantRead = result.error().waitReadable();
+        auto& waiting = wantRead ? state.reading : state.writing;
+        if (waiting) {
+          (wantRead ? state.afterRead : state.afterWrite).push_back(handle);
+          return true;
+        }
+        waiting = registered = true;
+        auto r = wantRead ? state.stream.mSocket.regR(handle) : state.stream.mSocket.regW(handle);
+        assert(r);
+        return true;
+      }
+      auto await_resume() -> Expected<size_t, SslError>
+      {
+        if (!suspendedBefore) {
+          return std::move(result);
+        }
+        auto followers = std::vector<std::coroutine_handle<>>();
+        {
+          auto lock = std::lock_guard(state.mutex);
+          if (registered) {
+            (wantRead ? state.reading : state.writing) = false;
+            followers.swap(wantRead ? state.afterRead : state.afterWrite);
+            if (!followers.empty()) {
+              state.handOver(followers); // the socket became ready for them too
+            }
+          }
+        }
+        auto r = call();
+        for (auto follower : followers) {
+          follower.resume();
+        }
+        return r;
+      }
+    };
+    return HalfAwaiter {*this, std::move(op)};
+  }
+  auto recv(std::span<std::byte> data)
+  {
+    return io([this, data] { return stream.read(data); });
+  }
+  auto send(std::span<std::byte const> data)
+  {
+    return io([this, data]() -> Expected<size_t, SslError> {
+      if (auto e = stream.write(data); e > 0) {
+        return size_t(e);
+      } else {
+        return make_unexpected(SslError::GetError(stream.ssl(), e));
+      }
+    });
+  }
+};
+} // namespace detail
+
+inline auto SslStream::split() && -> std::pair<ReadHalf<SslStream>, WriteHalf<SslStream>>
+{
+  return Split(std::move(*this));
+}
 } // namespace async
\ No newline at end of file
@@ -2,36 +2,73 @@
 #include "Async/Reactor.hpp"
 #include "Async/Task.hpp"
 
+#include "Admission.hpp"
 #include "TcpStream.hpp"
 #include "sys/Socket.hpp"
 
 namespace async {
 class TcpListener : public Socket {
 public:
-  inline static auto Bind(async::Reactor& reactor, SocketAddr const& addr) -> StdResult<TcpListener>
+  // Binds a listener whose accepted sockets all get the stream part of `options`.
+  inline static auto Bind(async::Reactor& reactor, SocketAddr const& addr, SocketOptions options = {})
+      -> StdResult<TcpListener>
   {
     if (auto socket = impl::Socket::CreateNonBlock(addr); !socket) {
       return make_unexpected(socket.error());
+    } else if (auto r = socket->applyListenerOptions(options); !r) {
+      socket->close();
+      return make_unexpected(r.error());
     } else if (auto r = socket->bind(addr); !r) {
+      socket->close();
       return make_unexpected(r.error());
-    } else if (auto r = socket->listen(1024); !r) {
+    } else if (auto r = socket->listen(options.backlog); !r) {
+      socket->close();
       return make_unexpected(r.error());
     } else {
-      if (auto source = reactor.insertIo(socket->raw()); !source) {
-        return make_unexpected(source.error());
-      } else {
-        return {TcpListener {&reactor, *source}};
-      }
+      return Socket::Register(&reactor, *socket).map([&](Socket socket) {
+        return TcpListener(std::move(socket), std::move(options));
+      });
     }
   }
 
   TcpListener() = default;
-  TcpListener(async::Reactor* reactor, std::shared_ptr<async::Source> source) : Socket(reactor, source) {}
+  TcpListener(Socket&& socket, SocketOptions options = {}) : Socket(std::move(socket)), mOptions(std::move(options))
+  {
+  }
   TcpListener(TcpListener const&) = delete;
   TcpListener(TcpListener&&) = default;
   ~TcpListener() = default;
 
+  auto accept(SocketAddr* addr) { return Socket::accept(addr, &mOptions); }
+  // Puts admit() under an admission policy, see AdmissionControl.
+  auto setAdmission(AdmissionOptions options) -> StdResult<void>
+  {
+    return AdmissionControl::Create(*reactor(), std::move(options)).map([this](auto control) {
+      mAdmission = std::move(control);
+    });
+  }
+  // Like accept, but paused while the policy admits no connection and never failing for lack of descriptors. Without
+  // setAdmission the default policy applies: no limit but the descriptor limit and no shedding.
+  auto admit(SocketAddr* addr) -> Task<StdResult<Admitted<TcpStream>>>
+  {
+    if (!mAdmission) {
+      if (auto r = setAdmission({}); !r) {
+        co_return make_unexpected(r.error());
+      }
+    }
+    auto admitted = co_await mAdmission->accept(*this, addr, &mOptions);
+    if (!admitted) {
+      co_return make_unexpected(admitted.error());
+    }
+    co_return Admitted<TcpStream> {TcpStream(std::move(admitted->stream)), std::move(admitted->permit)};
+  }
+  auto admission() const -> AdmissionControl const* { return mAdmission.get(); }
+  auto options() const -> SocketOptions const& { return mOptions; }
   auto raw() const -> impl::fd_t { return getSocket().raw(); }
-  auto take() -> async::Socket { return Socket(mReactor, std::move(mSource)); }
+  auto take() -> async::Socket { return Socket(std::move(*this)); }
+
+private:
+  SocketOptions mOptions;
+  std::shared_ptr<AdmissionControl> mAdmission;
 };
-} // namespace async
\ No newline at end of file
+} // namespace async
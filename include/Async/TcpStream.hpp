@@ -2,6 +2,7 @@
 #include "Async/Reactor.hpp"
 #include "Async/Task.hpp"
 
+#include "Split.hpp"
 #include "sys/Socket.hpp"
 
 namespace async {
@@ -9,70 +10,87 @@ class TcpStream : public Socket {
 public:
   inline static auto Connect(async::Reactor& reactor, SocketAddr const& addr)
   {
-    struct ConnectAwaiter {
-      StdResult<Socket> result;
+    return detail::ConnectAwaiter<TcpStream> {{}, reactor, addr};
+  }
+  // Connects and sends `data` in the SYN (TCP Fast Open) when a cookie from an earlier connection to `addr` is cached,
+  // saving a round trip. Without a cookie, or with Fast Open disabled, it falls back to a regular handshake and sends
+  // `data` once connected. Returns the stream and how many bytes of `data` were sent, which may be less than all.
+  inline static auto ConnectFastOpen(async::Reactor& reactor, SocketAddr const& addr, std::span<std::byte const> data)
+  {
+    struct FastOpenAwaiter {
       async::Reactor& reactor;
       SocketAddr const& addr;
+      std::span<std::byte const> data;
+      StdResult<Socket> socket;
+      StdResult<ssize_t> sent;
       bool suspendedBefore = false;
+      auto sendData() -> StdResult<ssize_t>
+      {
+        auto n = socket->getSocket().sendNonBlock(data, MSG_NOSIGNAL);
+        if (!n && detail::WouldBlock(n.error())) {
+          return 0;
+        }
+        return n;
+      }
       auto await_ready() noexcept -> bool
       {
-        if (auto r = Socket::Create(&reactor, addr); !r) {
-          result = make_unexpected(r.error());
+        if (socket = Socket::Create(&reactor, addr); !socket) {
           return true;
-        } else {
-          // socket create success
-          if (auto cr = r->getSocket().connect(addr); !cr) {
-            if (cr.error() == std::errc::operation_in_progress) {
-              // unix failed with EAGAIN
-              // tcp failed with EINPROGRESS
-              suspendedBefore = true; // suspend now
-              result = std::move(r).value();
-              return false;
-            } else {
-              result = make_unexpected(cr.error());
-              return true;
-            }
-          } else { // connect success
-            result = std::move(r).value();
-            return true;
-          }
         }
+        auto storage = impl::sockaddr_storage {};
+        auto len = impl::socketlen_t {};
+        if (auto r = impl::SocketAddrToSockAddr(addr, &storage, &len); !r) {
+          sent = make_unexpected(r.error());
+          return true;
+        }
+        auto n = socket->getSocket().sendto(data, MSG_FASTOPEN | MSG_NOSIGNAL | MSG_DONTWAIT,
+                                            (impl::sockaddr const*)&storage, len);
+        if (!n && n.error() == std::errc::operation_not_supported) { // client Fast Open disabled on this host
+          auto r = socket->getSocket().connect(addr);
+          n = r ? sendData() : make_unexpected(r.error());
+        }
+        if (!n && n.error() == std::errc::operation_in_progress) { // no cookie yet: a plain SYN went out
+          suspendedBefore = true;
+          return false;
+        }
+        sent = n;
+        return true;
       }
       auto await_suspend(std::coroutine_handle<> handle) -> void
       {
-        assert(suspendedBefore);
-        assert(result);
-        auto r = result->regW(handle);
+        auto r = socket->regW(handle);
         assert(r);
       }
-      auto await_resume() -> StdResult<TcpStream>
+      auto await_resume() -> StdResult<std::pair<TcpStream, size_t>>
       {
+        if (!socket) {
+          return make_unexpected(socket.error());
+        }
         if (suspendedBefore) {
-          assert(result);
-          // connect again
-          if (auto b = result->getSocket().connect(addr); !b) {
-            return make_unexpected(b.error()); // connect error
-          } else {
-            return {TcpStream(std::move(result).value())};
+          if (auto error = socket->getSocket().getOption<int>(SOL_SOCKET, SO_ERROR); !error) {
+            return make_unexpected(error.error());
+          } else if (error.value() != 0) {
+            return make_unexpected(std::errc(error.value()));
           }
-        } else if (result) { // socket created
-          return {TcpStream(std::move(result).value())};
-        } else { // error occurred
-          return make_unexpected(result.error());
+          sent = sendData();
+        }
+        if (!sent) {
+          return make_unexpected(sent.error());
         }
+        return std::pair {TcpStream(std::move(socket).value()), size_t(sent.value())};
       }
     };
-    return ConnectAwaiter {{}, reactor, addr};
+    return FastOpenAwaiter {reactor, addr, data};
   }
 
   TcpStream() = default;
   TcpStream(Socket&& socket) : Socket(std::move(socket)) {}
-  TcpStream(async::Reactor* reactor, std::shared_ptr<async::Source> source) : Socket(reactor, source) {}
   TcpStream(TcpStream const&) = delete;
   TcpStream(TcpStream&&) = default;
   TcpStream& operator=(TcpStream&& stream) = default;
   ~TcpStream() = default;
 
-  auto take() -> async::Socket { return Socket {mReactor, std::move(mSource)}; }
+  auto split() && { return Split(std::move(*this)); }
+  auto take() -> async::Socket { return Socket(std::move(*this)); }
 };
 } // namespace async
@@ -0,0 +1,84 @@
+#pragma once
+#include "AsyncFd.hpp"
+
+#include <chrono>
+#include <sys/timerfd.h>
+
+namespace async {
+// Kernel timer whose expirations are awaited through the reactor.
+class TimerFd {
+public:
+  inline static auto Create(Reactor& reactor, clockid_t clock = CLOCK_MONOTONIC) -> StdResult<TimerFd>
+  {
+    if (auto fd = SysCall(::timerfd_create, clock, TFD_NONBLOCK | TFD_CLOEXEC); !fd) {
+      return make_unexpected(fd.error());
+    } else {
+      return AsyncFd::Create(reactor, fd.value()).map([](AsyncFd fd) { return TimerFd(std::move(fd)); });
+    }
+  }
+
+  TimerFd() = default;
+  TimerFd(TimerFd&&) = default;
+  TimerFd& operator=(TimerFd&&) = default;
+
+  // Arms the timer to expire after `initial` and then every `interval`, if non-zero. Re-arming replaces the previous
+  // setting.
+  auto set(std::chrono::nanoseconds initial, std::chrono::nanoseconds interval = {}) -> StdResult<void>
+  {
+    auto spec = itimerspec {ToTimespec(interval), ToTimespec(initial)};
+    if (initial.count() <= 0) {
+      // zero would disarm the timer and a negative value is EINVAL, expire right away instead
+      spec.it_value = timespec {0, 1};
+    }
+    if (auto r = SysCall(::timerfd_settime, mFd.raw(), 0, &spec, nullptr); !r) {
+      return make_unexpected(r.error());
+    }
+    return {};
+  }
+  auto cancel() -> StdResult<void>
+  {
+    auto spec = itimerspec {};
+    if (auto r = SysCall(::timerfd_settime, mFd.raw(), 0, &spec, nullptr); !r) {
+      return make_unexpected(r.error());
+    }
+    return {};
+  }
+  // Waits for the next expiration and returns how many expirations happened since the last wait.
+  auto wait()
+  {
+    return mFd.io(
+        [fd = mFd.raw()]() -> StdResult<std::uint64_t> {
+          auto expirations = std::uint64_t {};
+          if (auto r = SysCall(::read, fd, &expirations, sizeof(expirations)); !r) {
+            return make_unexpected(r.error());
+          }
+          return expirations;
+        },
+        Interest::Read);
+  }
+  auto sleepFor(std::chrono::nanoseconds duration) -> Task<StdResult<void>>
+  {
+    if (auto r = set(duration); !r) {
+      co_return make_unexpected(r.error());
+    }
+    while (true) {
+      if (auto n = co_await wait(); n) {
+        co_return StdResult<void> {};
+      } else if (!detail::WouldBlock(n.error())) {
+        co_return make_unexpected(n.error());
+      }
+    }
+  }
+  auto raw() const -> impl::fd_t { return mFd.raw(); }
+
+private:
+  explicit TimerFd(AsyncFd fd) : mFd(std::move(fd)) {}
+  inline static auto ToTimespec(std::chrono::nanoseconds duration) -> timespec
+  {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    return {time_t(seconds.count()), long((duration - seconds).count())};
+  }
+
+  AsyncFd mFd;
+};
+} // namespace async
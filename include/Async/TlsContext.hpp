@@ -1,6 +1,8 @@
 #pragma once
 #include "Async/utils/predefined.hpp"
+#include <chrono>
 #include <filesystem>
+#include <limits>
 #include <mutex>
 #include <openssl/bio.h>
 #include <openssl/err.h>
@@ -18,6 +20,54 @@ struct OpenSSLError {
   inline static auto GetLastErr() -> OpenSSLError { return {ERR_get_error()}; }
   inline static auto GetLastErrMsg() -> std::string { return OpenSSLError {GetLastErr()}.message(); }
 };
+// Dynamic record sizing. Records of a cold connection fit in one TCP segment, so the peer can decrypt the first bytes
+// as soon as they arrive instead of waiting for a 16 KB record spread over several round trips of a small congestion
+// window. Records grow to `maxRecord` once `boostAfter` bytes went out, and shrink again after an idle gap.
+//
+// Off unless a context opts in with setRecordSizing({.enabled = true}): small records cost throughput on bulk
+// transfers, and OpenSSL's own 16 KB records are what existing users of SslSocket expect.
+struct TlsRecordSizing {
+  bool enabled = false;
+  std::size_t minRecord = 1400; // a 1460 byte MSS minus TCP options and TLS record overhead
+  std::size_t maxRecord = SSL3_RT_MAX_PLAIN_LENGTH;
+  std::size_t boostAfter = 1 << 20;
+  std::chrono::milliseconds idleReset {1000};
+};
+
+namespace detail {
+class RecordSizer {
+public:
+  using Clock = std::chrono::steady_clock;
+  explicit RecordSizer(TlsRecordSizing options = {}) : mOptions(options) {}
+
+  // Returns the plaintext size of the records for a write starting at `now`.
+  auto next(Clock::time_point now) -> std::size_t
+  {
+    if (now - mLastWrite >= mOptions.idleReset) {
+      mSent = 0;
+    }
+    mLastWrite = now;
+    return mSent >= mOptions.boostAfter ? mOptions.maxRecord : mOptions.minRecord;
+  }
+  // Bytes that can still go out at the size next() returned before records grow; unbounded once they did.
+  auto budget() const -> std::size_t
+  {
+    return mSent >= mOptions.boostAfter ? std::numeric_limits<std::size_t>::max() : mOptions.boostAfter - mSent;
+  }
+  auto sent(std::size_t n) -> void
+  {
+    mSent += n;
+    mLastWrite = Clock::now();
+  }
+  auto enabled() const -> bool { return mOptions.enabled; }
+
+private:
+  TlsRecordSizing mOptions;
+  std::size_t mSent = 0; // bytes written since the connection started or was last idle
+  Clock::time_point mLastWrite {};
+};
+} // namespace detail
+
 class TlsContext {
 public:
   enum FileType {
@@ -61,6 +111,23 @@ public:
     };
     return {};
   }
+  // Optimizes connections that sit idle most of the time for memory. OpenSSL frees the read and write buffers (16 KB+
+  // each) once a record is fully consumed or flushed instead of keeping them for the connection's lifetime, and recv
+  // waits for the socket to become readable before touching the SSL object, so a pending read holds no buffer. Costs
+  // an allocation per burst of records. Applies to sockets created afterwards.
+  auto setLeanIdle(bool lean) -> void
+  {
+    if (lean) {
+      SSL_CTX_set_mode(raw(), SSL_MODE_RELEASE_BUFFERS);
+      SSL_CTX_set_read_ahead(raw(), 0); // read-ahead would keep a full buffer of the next records
+    } else {
+      SSL_CTX_clear_mode(raw(), SSL_MODE_RELEASE_BUFFERS);
+    }
+    mLeanIdle = lean;
+  }
+  auto leanIdle() const -> bool { return mLeanIdle; }
+  auto setRecordSizing(TlsRecordSizing sizing) -> void { mRecordSizing = sizing; }
+  auto recordSizing() const -> TlsRecordSizing const& { return mRecordSizing; }
   auto raw() -> SSL_CTX* { return mContext.get(); }
 
 private:
@@ -70,5 +137,7 @@ private:
     void operator()(SSL_CTX* ctx) const { SSL_CTX_free(ctx); }
   };
   std::unique_ptr<SSL_CTX, CtxDeleter> mContext;
+  TlsRecordSizing mRecordSizing;
+  bool mLeanIdle = false;
 };
 } // namespace async
\ No newline at end of file
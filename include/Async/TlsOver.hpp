@@ -0,0 +1,165 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include "SslSocket.hpp"
+
+#include <climits>
+#include <vector>
+
+namespace async {
+// TLS over any stream with the send/recv awaiters of Socket, such as MemoryStream or UnixStream. OpenSSL reads and
+// writes a pair of memory BIOs and the records are moved between them and the stream, so a handshake and the traffic
+// after it run without a socket descriptor: in-process and in tests, deterministically. There is no kernel TLS,
+// sendfile or dynamic record sizing as with SslSocket.
+//
+// send and recv complete with the bytes transferred or an error: the stream's own, std::errc::io_error for a TLS
+// failure. recv returns 0 once the peer sent close_notify. One task at a time drives a connection, both ways share
+// the SSL object.
+template <typename Stream>
+class TlsOver {
+public:
+  static auto Connect(TlsContext& ctx, Stream stream) -> Task<StdResult<TlsOver>>
+  {
+    return Handshake(ctx, std::move(stream), false);
+  }
+  static auto Accept(TlsContext& ctx, Stream stream) -> Task<StdResult<TlsOver>>
+  {
+    return Handshake(ctx, std::move(stream), true);
+  }
+
+  TlsOver(TlsOver const&) = delete;
+  TlsOver(TlsOver&&) noexcept = default;
+  TlsOver& operator=(TlsOver&&) noexcept = default;
+
+  auto send(std::span<std::byte const> data) -> Task<StdResult<ssize_t>>
+  {
+    if (data.empty()) {
+      co_return ssize_t(0);
+    }
+    auto size = int(std::min<std::size_t>(data.size(), INT_MAX));
+    co_return co_await drive([&] { return SSL_write(mSsl.get(), data.data(), size); });
+  }
+  auto recv(std::span<std::byte> data) -> Task<StdResult<ssize_t>>
+  {
+    if (data.empty()) {
+      co_return ssize_t(0);
+    }
+    auto size = int(std::min<std::size_t>(data.size(), INT_MAX));
+    co_return co_await drive([&] { return SSL_read(mSsl.get(), data.data(), size); });
+  }
+  auto sendAll(std::span<std::byte const> data) -> Task<StdResult<std::size_t>>
+  {
+    for (auto sent = std::size_t {0}; sent < data.size();) {
+      auto n = co_await send(data.subspan(sent));
+      if (!n) {
+        co_return make_unexpected(n.error());
+      }
+      sent += std::size_t(n.value());
+    }
+    co_return data.size();
+  }
+  // Sends close_notify; the peer's recv then returns 0.
+  auto shutdown() -> Task<StdResult<void>>
+  {
+    SSL_shutdown(mSsl.get()); // 0 only means the peer's close_notify did not arrive yet, which is not waited for
+    co_return co_await flush();
+  }
+  auto ssl() -> SSL* { return mSsl.get(); }
+  auto stream() -> Stream& { return mStream; }
+
+private:
+  TlsOver(Stream stream, SslSocket::SslPtr ssl) : mStream(std::move(stream)), mSsl(std::move(ssl)) {}
+
+  static auto Handshake(TlsContext& ctx, Stream stream, bool server) -> Task<StdResult<TlsOver>>
+  {
+    auto ssl = SslSocket::SslPtr(SSL_new(ctx.raw()));
+    auto in = BIO_new(BIO_s_mem());
+    auto out = BIO_new(BIO_s_mem());
+    if (!ssl || in == nullptr || out == nullptr) {
+      BIO_free(in);
+      BIO_free(out);
+      co_return make_unexpected(std::errc::not_enough_memory);
+    }
+    SSL_set_bio(ssl.get(), in, out); // the SSL object owns both from here
+    if (server) {
+      SSL_set_accept_state(ssl.get());
+    } else {
+      SSL_set_connect_state(ssl.get());
+    }
+    auto tls = TlsOver(std::move(stream), std::move(ssl));
+    if (auto r = co_await tls.drive([&] { return SSL_do_handshake(tls.mSsl.get()); }); !r) {
+      co_return make_unexpected(r.error());
+    } else if (r.value() == 0) {
+      co_return make_unexpected(std::errc::connection_reset);
+    }
+    co_return std::move(tls);
+  }
+
+  // Runs `op` until it succeeds, sending whatever records it produced and feeding the input BIO from the stream
+  // whenever it wants to read. Returns op's positive result, or 0 when the peer closed the TLS session.
+  template <typename Op>
+  auto drive(Op op) -> Task<StdResult<ssize_t>>
+  {
+    while (true) {
+      auto r = op();
+      auto error = r > 0 ? SSL_ERROR_NONE : SSL_get_error(mSsl.get(), r);
+      // handshake records, alerts and data alike; an error alert must reach the peer before giving up
+      if (auto f = co_await flush(); !f) {
+        co_return make_unexpected(f.error());
+      }
+      switch (error) {
+      case SSL_ERROR_NONE:
+        co_return ssize_t(r);
+      case SSL_ERROR_ZERO_RETURN:
+        co_return ssize_t(0);
+      case SSL_ERROR_WANT_READ:
+        if (auto f = co_await fill(); !f) {
+          co_return make_unexpected(f.error());
+        }
+        continue;
+      case SSL_ERROR_WANT_WRITE: // a memory BIO never fills up, but flush() made room anyway
+        continue;
+      default:
+        co_return make_unexpected(std::errc::io_error);
+      }
+    }
+  }
+  auto flush() -> Task<StdResult<void>>
+  {
+    auto out = SSL_get_wbio(mSsl.get());
+    while (BIO_ctrl_pending(out) > 0) {
+      mBuffer.resize(std::max<std::size_t>(BIO_ctrl_pending(out), 16 << 10));
+      auto n = BIO_read(out, mBuffer.data(), int(mBuffer.size()));
+      for (auto pending = std::span<std::byte const>(mBuffer).first(std::size_t(std::max(n, 0)));
+           !pending.empty();) {
+        auto s = co_await mStream.send(pending);
+        if (s) {
+          pending = pending.subspan(std::size_t(s.value()));
+        } else if (!detail::WouldBlock(s.error())) {
+          co_return make_unexpected(detail::ToErrc(s.error()));
+        }
+      }
+    }
+    co_return StdResult<void> {};
+  }
+  auto fill() -> Task<StdResult<void>>
+  {
+    mBuffer.resize(16 << 10);
+    auto n = co_await mStream.recv(std::span(mBuffer));
+    while (!n && detail::WouldBlock(n.error())) {
+      n = co_await mStream.recv(std::span(mBuffer));
+    }
+    if (!n) {
+      co_return make_unexpected(detail::ToErrc(n.error()));
+    } else if (n.value() == 0) {
+      co_return make_unexpected(std::errc::connection_reset); // closed without close_notify
+    }
+    BIO_write(SSL_get_rbio(mSsl.get()), mBuffer.data(), int(n.value()));
+    co_return StdResult<void> {};
+  }
+
+  Stream mStream;
+  SslSocket::SslPtr mSsl;
+  std::vector<std::byte> mBuffer; // records on their way between a BIO and the stream
+};
+} // namespace async
@@ -0,0 +1,40 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "UnixStream.hpp"
+#include "sys/Socket.hpp"
+
+namespace async {
+// Listener for unix domain stream sockets. A filesystem path must not exist yet when binding; unlink a stale socket
+// file first. Abstract addresses need no cleanup.
+class UnixListener : public Socket {
+public:
+  // Of `options` only the backlog applies: the TCP ones have no meaning here.
+  inline static auto Bind(async::Reactor& reactor, SocketAddr const& addr, SocketOptions const& options = {})
+      -> StdResult<UnixListener>
+  {
+    assert(addr.isUnix());
+    if (auto socket = impl::Socket::CreateNonBlock(addr); !socket) {
+      return make_unexpected(socket.error());
+    } else if (auto r = socket->bind(addr); !r) {
+      socket->close();
+      return make_unexpected(r.error());
+    } else if (auto r = socket->listen(options.backlog); !r) {
+      socket->close();
+      return make_unexpected(r.error());
+    } else {
+      return Socket::Register(&reactor, *socket).map([](Socket socket) { return UnixListener(std::move(socket)); });
+    }
+  }
+
+  UnixListener() = default;
+  UnixListener(Socket&& socket) : Socket(std::move(socket)) {}
+  UnixListener(UnixListener const&) = delete;
+  UnixListener(UnixListener&&) = default;
+  ~UnixListener() = default;
+
+  auto raw() const -> impl::fd_t { return getSocket().raw(); }
+  auto take() -> async::Socket { return Socket(std::move(*this)); }
+};
+} // namespace async
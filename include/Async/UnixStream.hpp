@@ -0,0 +1,168 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+
+#include "Split.hpp"
+#include "sys/Socket.hpp"
+
+#include <cstring>
+#include <sys/un.h>
+
+namespace async {
+struct RecvFdsResult {
+  size_t bytes;
+  size_t fds;     // descriptors stored at the front of the fd span, opened with O_CLOEXEC
+  bool truncated; // the peer sent more descriptors than fit, the kernel closed the rest
+};
+
+class UnixStream : public Socket {
+public:
+  // most descriptors sendFds passes in one message
+  constexpr static size_t MaxFds = 64;
+
+  // Fails with resource_unavailable_try_again while the listener's backlog is full; retrying is up to the caller.
+  inline static auto Connect(async::Reactor& reactor, SocketAddr const& addr)
+  {
+    assert(addr.isUnix());
+    return detail::ConnectAwaiter<UnixStream> {{}, reactor, addr};
+  }
+  // Creates a pair of connected, unnamed sockets.
+  inline static auto Pair(async::Reactor& reactor) -> StdResult<std::pair<UnixStream, UnixStream>>
+  {
+    int fds[2];
+    if (auto r = SysCall(::socketpair, AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds); !r) {
+      return make_unexpected(r.error());
+    }
+    auto first = Socket::Register(&reactor, impl::Socket(fds[0]));
+    if (!first) {
+      impl::Socket(fds[1]).close();
+      return make_unexpected(first.error());
+    }
+    auto second = Socket::Register(&reactor, impl::Socket(fds[1]));
+    if (!second) {
+      return make_unexpected(second.error());
+    }
+    return std::pair {UnixStream(std::move(first).value()), UnixStream(std::move(second).value())};
+  }
+
+  UnixStream() = default;
+  UnixStream(Socket&& socket) : Socket(std::move(socket)) {}
+  UnixStream(UnixStream const&) = delete;
+  UnixStream(UnixStream&&) = default;
+  UnixStream& operator=(UnixStream&& stream) = default;
+  ~UnixStream() = default;
+
+  // Sends `data` together with duplicates of `fds` (SCM_RIGHTS). The descriptors travel with the first byte, so `data`
+  // must not be empty; the caller keeps ownership of its own copies.
+  auto sendFds(std::span<std::byte const> data, std::span<impl::fd_t const> fds)
+  {
+    assert(!data.empty() && fds.size() <= MaxFds);
+    struct SendFdsAwaiter {
+      UnixStream& stream;
+      std::span<std::byte const> data;
+      std::span<impl::fd_t const> fds;
+      StdResult<ssize_t> result;
+      bool suspendedBefore = false;
+      auto trySend() -> StdResult<ssize_t>
+      {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(impl::fd_t) * MaxFds)];
+        auto iov = iovec {const_cast<std::byte*>(data.data()), data.size()};
+        auto msg = msghdr {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (!fds.empty()) {
+          msg.msg_control = control;
+          msg.msg_controllen = CMSG_SPACE(sizeof(impl::fd_t) * fds.size());
+          auto cmsg = CMSG_FIRSTHDR(&msg);
+          cmsg->cmsg_level = SOL_SOCKET;
+          cmsg->cmsg_type = SCM_RIGHTS;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(impl::fd_t) * fds.size());
+          std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(impl::fd_t) * fds.size());
+        }
+        return stream.getSocket().sendmsgNonBlock(&msg, 0);
+      }
+      auto await_ready() noexcept -> bool
+      {
+        auto n = trySend();
+        if (!n && detail::WouldBlock(n.error())) {
+          suspendedBefore = true;
+          return false;
+        }
+        result = n;
+        return true;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+      {
+        auto r = stream.regW(handle);
+        assert(r);
+      }
+      auto await_resume() -> StdResult<ssize_t> { return suspendedBefore ? trySend() : std::move(result); }
+    };
+    return SendFdsAwaiter {*this, data, fds};
+  }
+
+  // Receives bytes into `data` and any descriptors passed along with them into `fds`.
+  auto recvFds(std::span<std::byte> data, std::span<impl::fd_t> fds)
+  {
+    struct RecvFdsAwaiter {
+      UnixStream& stream;
+      std::span<std::byte> data;
+      std::span<impl::fd_t> fds;
+      StdResult<RecvFdsResult> result;
+      bool suspendedBefore = false;
+      auto tryRecv() -> StdResult<RecvFdsResult>
+      {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(impl::fd_t) * MaxFds)];
+        auto iov = iovec {data.data(), data.size()};
+        auto msg = msghdr {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(impl::fd_t) * std::min(fds.size(), MaxFds));
+        auto n = stream.getSocket().recvmsgNonBlock(&msg, MSG_CMSG_CLOEXEC);
+        if (!n) {
+          return make_unexpected(n.error());
+        }
+        auto received = RecvFdsResult {size_t(n.value()), 0, bool(msg.msg_flags & MSG_CTRUNC)};
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+          if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+          }
+          auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(impl::fd_t);
+          for (size_t i = 0; i < count; i++) {
+            auto fd = impl::fd_t {};
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(impl::fd_t), sizeof(fd));
+            if (received.fds < fds.size()) {
+              fds[received.fds++] = fd;
+            } else {
+              ::close(fd);
+              received.truncated = true;
+            }
+          }
+        }
+        return received;
+      }
+      auto await_ready() noexcept -> bool
+      {
+        auto n = tryRecv();
+        if (!n && detail::WouldBlock(n.error())) {
+          suspendedBefore = true;
+          return false;
+        }
+        result = n;
+        return true;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+      {
+        auto r = stream.regR(handle);
+        assert(r);
+      }
+      auto await_resume() -> StdResult<RecvFdsResult> { return suspendedBefore ? tryRecv() : std::move(result); }
+    };
+    return RecvFdsAwaiter {*this, data, fds};
+  }
+
+  auto split() && { return Split(std::move(*this)); }
+  auto take() -> async::Socket { return Socket(std::move(*this)); }
+};
+} // namespace async
@@ -0,0 +1,46 @@
+#pragma once
+#include "Async/Task.hpp"
+
+#include "sys/Socket.hpp"
+
+#include <memory>
+#include <optional>
+
+namespace async {
+struct WatermarkOptions {
+  std::size_t highWatermark = 1 << 20; // writers suspend once this many bytes are queued
+  std::size_t lowWatermark = 256 << 10; // and resume when the queue drained to this level
+  // TCP_NOTSENT_LOWAT for the stream, so unsent data stays in the queue where it is accounted for instead of piling up
+  // in the kernel send buffer
+  std::optional<int> notSentLowat = 16 << 10;
+};
+
+// Bounded outbound queue in front of a stream. write() copies a message into the queue and returns right away while
+// another write is flushing it; the write that finds the queue idle sends what is queued up to and including its own
+// message in one batch, and leaves whatever was queued meanwhile to a drain task of the queue's own, resumed by the
+// reactor, which batches it into large sends. Once highWatermark bytes are queued further writers suspend until the
+// stream drained the queue to lowWatermark, so a slow peer bounds memory instead of growing it. A message larger than
+// the high watermark is still accepted whole.
+//
+// Safe to share between tasks on any executor thread, but a writer or flusher that had to wait is resumed on the
+// thread of whichever task drained the queue, or the reactor's for the queue's drain task, not on its own executor.
+// The queue must outlive every write and flush. It may be destroyed while its drain task is still sending; the stream
+// must outlive both.
+class WriteQueue {
+public:
+  WriteQueue(Socket& stream, WatermarkOptions options = {});
+  WriteQueue(WriteQueue const&) = delete;
+  WriteQueue& operator=(WriteQueue const&) = delete;
+
+  auto write(std::span<std::byte const> data) -> Task<StdResult<void>>;
+  // Waits until everything queued so far was handed to the kernel.
+  auto flush() -> Task<StdResult<void>>;
+  // Bytes accepted by write() that the kernel did not take yet.
+  auto queued() const -> std::size_t;
+
+private:
+  struct State;
+
+  std::shared_ptr<State> mState; // shared with the drain task
+};
+} // namespace async
@@ -0,0 +1,92 @@
+#pragma once
+#include "Async/sys/Socket.hpp"
+#include "HttpServer.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace async::http {
+// An open file kept by FileCache together with the metadata a response needs. The fd stays open for as long as any
+// response still references the entry, even after the cache dropped it.
+struct CachedFile {
+  impl::fd_t fd = impl::INVALID_FD;
+  off_t size = 0;
+  timespec mtime {};
+  std::string_view contentType;
+  std::string lastModified; // IMF-fixdate
+  std::string etag;
+
+  CachedFile() = default;
+  CachedFile(CachedFile const&) = delete;
+  CachedFile& operator=(CachedFile const&) = delete;
+  ~CachedFile();
+};
+
+struct FileCacheOptions {
+  std::size_t maxEntries = 1024;
+  // inotify events are drained on lookup at most this often
+  std::chrono::milliseconds invalidateInterval {50};
+  // serve paths with a segment starting with '.', such as .git/config, .env or .well-known; otherwise they are
+  // reported missing
+  bool allowHidden = false;
+};
+
+// Bounded LRU cache of open files below a document root, so serving a hot file costs no open/fstat/close. Entries are
+// invalidated through inotify when the file is modified, replaced or removed. When inotify is unavailable every hit is
+// revalidated with fstat instead. Safe to share between executor threads.
+class FileCache {
+public:
+  FileCache(std::filesystem::path root, FileCacheOptions options = {});
+  FileCache(FileCache const&) = delete;
+  FileCache& operator=(FileCache const&) = delete;
+  ~FileCache();
+
+  // Opens `path` relative to the root. `path` must already be decoded; absolute paths, hidden segments (unless
+  // allowHidden is set) and anything resolving outside the root or through a symlink fail.
+  auto open(std::string_view path) -> StdResult<std::shared_ptr<CachedFile const>>;
+  auto size() const -> std::size_t;
+
+private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<CachedFile const> file;
+    int watch;
+  };
+  auto load(std::string const& key) -> StdResult<std::shared_ptr<CachedFile const>>;
+  auto drainEvents() -> void;
+  auto erase(std::list<Entry>::iterator it) -> void;
+
+  std::filesystem::path mRoot;
+  FileCacheOptions mOptions;
+  int mRootFd;
+  int mInotify;
+  std::chrono::steady_clock::time_point mNextDrain {};
+  mutable std::mutex mMutex;
+  std::list<Entry> mLru; // most recently used first
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> mIndex;
+  std::unordered_multimap<int, std::list<Entry>::iterator> mWatches;
+};
+
+struct ByteRange {
+  off_t first;
+  off_t length;
+};
+
+// Parses a Range header value against a resource of `size` bytes. Only single "bytes=" ranges are honored; returns
+// std::nullopt when the header should be ignored and a zero length range when it is unsatisfiable.
+auto ParseRange(std::string_view value, off_t size) -> std::optional<ByteRange>;
+
+// Parses an HTTP-date in any of the three formats of RFC 9110 section 5.6.7, std::nullopt when it is none of them.
+auto ParseHttpDate(std::string_view value) -> std::optional<time_t>;
+
+// Whether the If-None-Match `value`, "*" or a list of entity tags, matches `etag` by the weak comparison of RFC 9110
+// section 8.8.3.2, which ignores the W/ prefix on either side. A malformed list matches nothing from where it breaks.
+auto NoneMatchHits(std::string_view value, std::string_view etag) -> bool;
+
+// Request handler serving GET and HEAD requests for files in `cache`, including conditional and range requests.
+auto ServeFile(FileCache& cache, Request const& request, ResponseWriter& response) -> void;
+} // namespace async::http
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace async::http {
+struct Header {
+  std::string_view name;
+  std::string_view value;
+};
+
+// A parsed request. Every view points into the buffer handed to RequestParser::parse, so a Request is only valid
+// until that buffer is modified.
+struct Request {
+  constexpr static std::size_t MaxHeaders = 64;
+
+  std::string_view method;
+  std::string_view target;
+  int minorVersion = 1;
+  std::string_view body;
+  std::size_t contentLength = 0;
+  bool keepAlive = true;
+
+  auto headers() const -> std::span<Header const> { return {headerStorage.data(), headerCount}; }
+  // case-insensitive lookup of the first header named `name`
+  auto header(std::string_view name) const -> std::optional<std::string_view>;
+
+  std::array<Header, MaxHeaders> headerStorage;
+  std::size_t headerCount = 0;
+};
+
+enum class ParseStatus : std::uint8_t {
+  Complete,
+  Incomplete,
+  Error,
+};
+
+struct ParseResult {
+  ParseStatus status;
+  std::size_t consumed; // bytes of the buffer belonging to the request, valid when status is Complete
+};
+
+// Incremental HTTP/1.1 request parser. Call parse() with all bytes received so far for the current request; it
+// remembers how far it has already searched for the end of the header block, so feeding a request in small pieces
+// stays linear. Once a request completes, drop `consumed` bytes from the front of the buffer and call parse() again for
+// the next pipelined request.
+class RequestParser {
+public:
+  // Request bodies are only accepted with Content-Length, and only up to this size.
+  constexpr static std::size_t MaxBodySize = 1 << 20;
+  constexpr static std::size_t MaxHeadSize = 64 << 10;
+
+  auto parse(std::string_view data, Request& request) -> ParseResult;
+  auto reset() -> void { mScanned = 0; }
+
+private:
+  std::size_t mScanned = 0;
+};
+
+namespace detail {
+auto EqualsIgnoreCase(std::string_view a, std::string_view b) -> bool;
+// Whether the comma separated `list` has an element equal to `token`, ignoring case and surrounding whitespace.
+auto ContainsTokenIgnoreCase(std::string_view list, std::string_view token) -> bool;
+// First byte of [first, last) lying in one of the inclusive ranges given as [lo0, hi0, lo1, hi1, ...], or last.
+// Uses AVX2 or SSE4.2 when the CPU supports it.
+auto FindInRanges(char const* first, char const* last, std::string_view ranges) -> char const*;
+} // namespace detail
+} // namespace async::http
@@ -0,0 +1,348 @@
+#pragma once
+#include "Async/BufferPool.hpp"
+#include "Async/SslSocket.hpp"
+#include "Async/Task.hpp"
+#include "HttpParser.hpp"
+
+#include <charconv>
+#include <concepts>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace async::http {
+struct ServerOptions {
+  std::size_t readBufferSize = 16 << 10;
+  std::size_t writeBufferSize = 16 << 10;
+  // Between requests wait for the connection to become readable holding no buffers, and borrow the read buffer from
+  // BufferPool::Local() only once data arrived; the write buffer is put aside for reuse by the thread's next busy
+  // connection meanwhile. Idle keep-alive connections then cost no buffer memory. Safe on a
+  // multi-threaded executor: a buffer released on another thread than it was borrowed on goes to that thread's pool.
+  bool poolBuffers = true;
+};
+
+inline auto ReasonPhrase(int code) -> std::string_view
+{
+  switch (code) {
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 204:
+    return "No Content";
+  case 206:
+    return "Partial Content";
+  case 301:
+    return "Moved Permanently";
+  case 302:
+    return "Found";
+  case 304:
+    return "Not Modified";
+  case 400:
+    return "Bad Request";
+  case 403:
+    return "Forbidden";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 413:
+    return "Payload Too Large";
+  case 416:
+    return "Range Not Satisfiable";
+  case 500:
+    return "Internal Server Error";
+  case 501:
+    return "Not Implemented";
+  case 503:
+    return "Service Unavailable";
+  default:
+    return "Unknown";
+  }
+}
+
+// A response body that Serve() streams from a file with sendfile once the header block has been flushed, or over TLS
+// without kernel TLS through its write buffer. `owner` keeps `fd` open until the transfer is done.
+struct FileBody {
+  std::shared_ptr<void const> owner;
+  int fd = -1;
+  off_t offset = 0;
+  std::size_t length = 0;
+};
+
+// Serializes one response straight into the connection's output buffer. The buffer is reused for every request on the
+// connection, so once it has grown to the working size no response allocates. Content-Length and Connection are
+// written by body(), only Connection by finishWithoutBody(). `minorVersion` is that of the request: an HTTP/1.0 client
+// assumes the server closes unless the response says "Connection: keep-alive" (RFC 9112 section 9.3).
+class ResponseWriter {
+public:
+  ResponseWriter(std::string& out, bool keepAlive, int minorVersion = 1)
+      : mOut(out), mKeepAlive(keepAlive), mMinorVersion(minorVersion)
+  {
+  }
+  ResponseWriter(ResponseWriter const&) = delete;
+  ResponseWriter& operator=(ResponseWriter const&) = delete;
+
+  auto status(int code, std::string_view reason = {}) -> ResponseWriter&
+  {
+    assert(mState == State::Start && "status already written");
+    assert(code >= 100 && code <= 999 && "status codes have three digits");
+    char digits[3];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), code);
+    mOut.append("HTTP/1.1 ").append(digits, end - digits).append(" ");
+    mOut.append(reason.empty() ? ReasonPhrase(code) : reason).append("\r\n");
+    mState = State::Headers;
+    return *this;
+  }
+  auto header(std::string_view name, std::string_view value) -> ResponseWriter&
+  {
+    assert(mState != State::Done && "response already finished");
+    if (mState == State::Start) {
+      status(200);
+    }
+    mOut.append(name).append(": ").append(value).append("\r\n");
+    return *this;
+  }
+  // Writes the header block terminator followed by `data` and finishes the response.
+  auto body(std::string_view data) -> void
+  {
+    finishHead(data.size());
+    mOut.append(data);
+  }
+  // Finishes the header block of a response whose `length` body bytes the caller sends itself, e.g. with sendfile.
+  auto finishHead(std::size_t length) -> void
+  {
+    assert(mState != State::Done && "response already finished");
+    if (mState == State::Start) {
+      status(200);
+    }
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), length);
+    mOut.append("Content-Length: ").append(digits, end - digits).append("\r\n");
+    endHead();
+  }
+  // Finishes a response that has no body and must not announce one, such as a 304 or a 204 (RFC 9110 sections 8.6
+  // and 15.4.5).
+  auto finishWithoutBody() -> void
+  {
+    assert(mState != State::Done && "response already finished");
+    if (mState == State::Start) {
+      status(204);
+    }
+    endHead();
+  }
+  // Finishes the header block and has Serve() send `file` as the body.
+  auto sendfile(FileBody file) -> void
+  {
+    finishHead(file.length);
+    mFile = std::move(file);
+  }
+  // Closes the connection after this response.
+  auto close() -> ResponseWriter&
+  {
+    assert(mState != State::Done && "response already finished");
+    mKeepAlive = false;
+    return *this;
+  }
+  auto finish() -> void
+  {
+    if (mState != State::Done) {
+      body({});
+    }
+  }
+  auto keepAlive() const -> bool { return mKeepAlive; }
+  auto takeFile() -> FileBody { return std::move(mFile); }
+
+private:
+  enum class State : std::uint8_t { Start, Headers, Done };
+
+  auto endHead() -> void
+  {
+    if (!mKeepAlive) {
+      mOut.append("Connection: close\r\n");
+    } else if (mMinorVersion == 0) {
+      mOut.append("Connection: keep-alive\r\n");
+    }
+    mOut.append("\r\n");
+    mState = State::Done;
+  }
+
+  std::string& mOut;
+  FileBody mFile;
+  State mState = State::Start;
+  bool mKeepAlive;
+  int mMinorVersion;
+};
+
+namespace detail {
+// Write buffers put aside by idle connections, per thread like BufferPool::Local(). A connection gives its buffer to
+// the list of the thread it goes idle on and takes one from that of the thread it resumes on.
+inline auto IdleWriteBuffers() -> std::vector<std::string>&
+{
+  thread_local auto buffers = std::vector<std::string>();
+  return buffers;
+}
+inline auto TakeWriteBuffer(std::size_t capacity) -> std::string
+{
+  auto& buffers = IdleWriteBuffers();
+  if (buffers.empty()) {
+    auto buffer = std::string();
+    buffer.reserve(capacity);
+    return buffer;
+  }
+  auto buffer = std::move(buffers.back());
+  buffers.pop_back();
+  return buffer;
+}
+inline auto GiveWriteBuffer(std::string buffer, std::size_t capacity) -> void
+{
+  auto& buffers = IdleWriteBuffers();
+  // one grown by a large response is freed rather than kept around
+  if (buffer.capacity() >= capacity && buffer.capacity() <= 4 * capacity &&
+      buffers.size() < BufferPool::DefaultMaxCached) {
+    buffer.clear();
+    buffers.push_back(std::move(buffer));
+  }
+}
+
+// Sends `file` by reading it into `buffer` in chunks of `chunk` bytes, for a TLS stream whose records the kernel does
+// not encrypt and SSL_sendfile therefore cannot send. Leaves `buffer` empty when it succeeds.
+template <typename Stream>
+auto SendFileBuffered(Stream& stream, FileBody const& file, std::string& buffer, std::size_t chunk) -> Task<bool>
+{
+  buffer.resize(std::min(file.length, chunk));
+  for (std::size_t sent = 0; sent < file.length;) {
+    auto n = SysCall(::pread, file.fd, buffer.data(), std::min(buffer.size(), file.length - sent),
+                     file.offset + off_t(sent));
+    if (!n || n.value() == 0) { // a file that shrank under the response cannot honour its Content-Length
+      co_return false;
+    }
+    for (auto pending = std::string_view(buffer.data(), std::size_t(n.value())); !pending.empty();) {
+      auto w = co_await stream.send(std::as_bytes(std::span(pending)));
+      if (w) {
+        pending.remove_prefix(std::size_t(w.value()));
+      } else if (!async::detail::WouldBlock(w.error())) {
+        co_return false;
+      }
+    }
+    sent += std::size_t(n.value());
+  }
+  buffer.clear();
+  co_return true;
+}
+
+// Sends all of `file`, with sendfile where the stream can and through `buffer` otherwise.
+template <typename Stream>
+auto SendFile(Stream& stream, FileBody const& file, std::string& buffer, std::size_t chunk) -> Task<bool>
+{
+  if constexpr (std::derived_from<Stream, SslSocket>) {
+    if (!stream.ktlsSend()) {
+      co_return co_await SendFileBuffered(stream, file, buffer, chunk);
+    }
+  }
+  auto n = co_await stream.sendfileAll(file.fd, file.offset, file.length);
+  co_return n && n.value() == file.length;
+}
+} // namespace detail
+
+template <typename Handler>
+concept RequestHandler = std::invocable<Handler&, Request const&, ResponseWriter&>;
+
+// Serves HTTP/1.1 on an accepted TcpStream or SslStream until the peer closes, asks to close, or sends a malformed
+// request. Pipelined requests already in the read buffer are all handled before their responses are flushed with a
+// single write.
+template <typename Stream, RequestHandler Handler>
+auto Serve(Stream stream, Handler handler, ServerOptions options = {}) -> Task<>
+{
+  auto in = PooledBuffer {};
+  auto filled = std::size_t {0};
+  auto out = std::string();
+  if (!options.poolBuffers) {
+    out.reserve(options.writeBufferSize);
+  }
+  auto parser = RequestParser {};
+  auto request = Request {};
+  auto keepAlive = true;
+
+  while (keepAlive) {
+    auto consumed = std::size_t {0};
+    auto file = FileBody {};
+    while (keepAlive && !file.owner) {
+      auto r = parser.parse({reinterpret_cast<char const*>(in.data()) + consumed, filled - consumed}, request);
+      if (r.status == ParseStatus::Incomplete) {
+        break;
+      } else if (r.status == ParseStatus::Error) {
+        out.append("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        keepAlive = false;
+        break;
+      }
+      auto writer = ResponseWriter(out, request.keepAlive, request.minorVersion);
+      std::invoke(handler, std::as_const(request), writer);
+      writer.finish();
+      keepAlive = writer.keepAlive();
+      file = writer.takeFile();
+      consumed += r.consumed;
+    }
+    if (consumed != 0) {
+      std::memmove(in.data(), in.data() + consumed, filled - consumed);
+      filled -= consumed;
+    }
+    if (keepAlive && !file.owner && filled != 0 && filled == in.size()) {
+      if (in.size() >= RequestParser::MaxHeadSize + RequestParser::MaxBodySize) {
+        out.append("HTTP/1.1 413 Payload Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        keepAlive = false;
+      } else {
+        auto larger = PooledBuffer(in.size() * 2);
+        std::memcpy(larger.data(), in.data(), filled);
+        in = std::move(larger);
+      }
+    }
+    // written inline rather than through a helper task so a flush doesn't allocate a coroutine frame
+    for (auto pending = std::string_view(out); !pending.empty();) {
+      auto n = co_await stream.send(std::as_bytes(std::span(pending)));
+      if (n) {
+        pending.remove_prefix(std::size_t(n.value()));
+      } else if (!async::detail::WouldBlock(n.error())) {
+        co_return;
+      }
+    }
+    out.clear();
+    if (file.owner) {
+      if (!co_await detail::SendFile(stream, file, out, std::max(options.writeBufferSize, out.capacity()))) {
+        co_return;
+      }
+      if (keepAlive && filled != 0) {
+        continue; // more pipelined requests may already be buffered
+      }
+    }
+    if (!keepAlive) {
+      break;
+    }
+    if (filled == 0 && options.poolBuffers) {
+      in.release();
+      detail::GiveWriteBuffer(std::exchange(out, {}), options.writeBufferSize);
+      if constexpr (requires { stream.readable(); }) {
+        co_await stream.readable();
+      }
+      out = detail::TakeWriteBuffer(options.writeBufferSize);
+    }
+    if (in.empty()) {
+      in = options.poolBuffers ? BufferPool::Local(options.readBufferSize).acquire()
+                               : PooledBuffer(options.readBufferSize);
+    }
+    auto span = in.span().subspan(filled);
+    auto n = co_await stream.recv(span);
+    while (!n && async::detail::WouldBlock(n.error())) {
+      n = co_await stream.recv(span);
+    }
+    if (!n || n.value() == 0) {
+      break;
+    }
+    filled += std::size_t(n.value());
+  }
+  if constexpr (std::derived_from<Stream, SslSocket>) {
+    stream.defaultShutdown();
+  }
+}
+} // namespace async::http
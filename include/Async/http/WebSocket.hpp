@@ -0,0 +1,412 @@
+#pragma once
+#include "Async/Task.hpp"
+#include "Async/utils/predefined.hpp"
+#include "HttpServer.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+namespace async::http {
+namespace ws {
+enum class Opcode : std::uint8_t {
+  Continuation = 0x0,
+  Text = 0x1,
+  Binary = 0x2,
+  Close = 0x8,
+  Ping = 0x9,
+  Pong = 0xa,
+};
+
+enum class Role : std::uint8_t { Server, Client };
+
+constexpr std::size_t MaxHeaderSize = 14;
+constexpr std::size_t MaxControlPayload = 125;
+
+// Close status codes of RFC 6455 section 7.4.1.
+constexpr std::uint16_t CloseNormal = 1000;
+constexpr std::uint16_t CloseGoingAway = 1001;
+constexpr std::uint16_t CloseProtocolError = 1002;
+constexpr std::uint16_t CloseInvalidData = 1007;
+constexpr std::uint16_t CloseTooBig = 1009;
+
+struct FrameHeader {
+  bool fin = true;
+  Opcode opcode = Opcode::Binary;
+  bool masked = false;
+  std::array<std::byte, 4> mask {};
+  std::uint64_t length = 0;
+};
+
+// Writes the wire form of `header` to `out` and returns its size.
+auto EncodeHeader(FrameHeader const& header, std::span<std::byte, MaxHeaderSize> out) -> std::size_t;
+// Reads a frame header from the front of `data`. Reserved bits, unknown opcodes and oversized or fragmented control
+// frames are errors. `consumed` is the header size on success.
+auto DecodeHeader(std::span<std::byte const> data, FrameHeader& header) -> ParseResult;
+// XORs `data` with `mask`, starting `offset` bytes into the masking key. Uses AVX2 or SSE2 when the CPU supports it.
+auto ApplyMask(std::span<std::byte> data, std::array<std::byte, 4> mask, std::size_t offset = 0) -> void;
+
+// Whether `data` is well-formed UTF-8, as text messages and close reasons must be.
+auto ValidUtf8(std::span<std::byte const> data) -> bool;
+// Whether a Close frame may carry `code`: 1000-1003, 1007-1014 and 3000-4999. The others are reserved or, like 1005
+// and 1006, only stand in locally for a missing code (RFC 6455 section 7.4).
+auto ValidCloseCode(std::uint16_t code) -> bool;
+
+// Sec-WebSocket-Accept value for the client's Sec-WebSocket-Key.
+auto AcceptKey(std::string_view key) -> std::string;
+// Returns the Sec-WebSocket-Key of a valid version 13 upgrade request.
+auto UpgradeKey(Request const& request) -> std::optional<std::string_view>;
+auto WriteUpgradeResponse(std::string& out, std::string_view key) -> void;
+// Appends an upgrade request with a fresh key to `out` and returns the Sec-WebSocket-Accept value to expect.
+auto WriteUpgradeRequest(std::string& out, std::string_view host, std::string_view path) -> StdResult<std::string>;
+// Parses the server's answer to an upgrade request; only a 101 carrying `accept` completes.
+auto ParseUpgradeResponse(std::string_view data, std::string_view accept) -> ParseResult;
+// Masking key for a client frame, drawn from the CSPRNG: a predictable key would let a page steer the bytes an
+// intermediary sees (RFC 6455 section 10.3).
+auto NewMask() -> StdResult<std::array<std::byte, 4>>;
+} // namespace ws
+
+struct WebSocketOptions {
+  std::size_t maxMessageSize = 16 << 20; // after reassembling fragments
+  std::size_t readBufferSize = 16 << 10;
+  bool autoPong = true; // answer pings from receive()
+};
+
+struct WebSocketMessage {
+  ws::Opcode opcode; // Text, Binary or Close
+  std::span<std::byte const> data; // valid until the next receive()
+
+  auto text() const -> std::string_view { return {reinterpret_cast<char const*>(data.data()), data.size()}; }
+};
+
+// A WebSocket connection over a TcpStream or SslStream, created by AcceptWebSocket or ConnectWebSocket. Unfragmented
+// messages are handed out as views into the read buffer, unmasked in place. A server sends header and payload with
+// one vectored write when the stream supports it; a client masks into a scratch buffer since the payload is const.
+//
+// One task at a time may send, and receive() itself sends pongs and the close reply, so either drive a connection
+// from one task or turn off autoPong and answer pings yourself.
+template <typename Stream>
+class WebSocket {
+public:
+  WebSocket(Stream stream, ws::Role role, WebSocketOptions options = {}, std::string_view buffered = {})
+      : mStream(std::move(stream)), mOptions(options), mRole(role)
+  {
+    mIn.resize(std::max(mOptions.readBufferSize, buffered.size()));
+    std::memcpy(mIn.data(), buffered.data(), buffered.size());
+    mFilled = buffered.size();
+  }
+  WebSocket(WebSocket const&) = delete;
+  WebSocket(WebSocket&&) noexcept = default;
+  WebSocket& operator=(WebSocket&&) noexcept = default;
+
+  // Waits for the next complete message. A Close message is answered before it is returned, after which the
+  // connection is done. Protocol violations close the connection and return std::errc::protocol_error, messages over
+  // maxMessageSize std::errc::message_size, and text that is not valid UTF-8 std::errc::illegal_byte_sequence.
+  auto receive() -> Task<StdResult<WebSocketMessage>>
+  {
+    if (mConsumed == mFilled) {
+      mConsumed = mFilled = 0; // nothing buffered to keep; fill() moves a partial frame only when it runs out of room
+    }
+    while (true) {
+      auto header = ws::FrameHeader {};
+      auto r = ws::DecodeHeader(std::span(mIn).first(mFilled).subspan(mConsumed), header);
+      if (r.status == ParseStatus::Incomplete) {
+        if (auto n = co_await fill(ws::MaxHeaderSize); !n) {
+          co_return make_unexpected(n.error());
+        }
+        continue;
+      } else if (r.status == ParseStatus::Error || header.masked != (mRole == ws::Role::Server)) {
+        co_return co_await fail(ws::CloseProtocolError, std::errc::protocol_error);
+      } else if (header.length > mOptions.maxMessageSize - std::min(mOptions.maxMessageSize, mMessage.size())) {
+        co_return co_await fail(ws::CloseTooBig, std::errc::message_size);
+      }
+      auto frameSize = r.consumed + std::size_t(header.length);
+      if (mFilled - mConsumed < frameSize) {
+        if (auto n = co_await fill(frameSize); !n) {
+          co_return make_unexpected(n.error());
+        }
+        continue;
+      }
+      auto payload = std::span(mIn).subspan(mConsumed + r.consumed, std::size_t(header.length));
+      if (header.masked) {
+        ws::ApplyMask(payload, header.mask);
+      }
+      mConsumed += frameSize;
+      switch (header.opcode) {
+      case ws::Opcode::Ping:
+        // once our Close is out nothing but the peer's Close is owed (RFC 6455 section 5.5.1)
+        if (mOptions.autoPong && !mCloseSent) {
+          if (auto s = co_await sendFrame(ws::Opcode::Pong, payload, true); !s) {
+            co_return make_unexpected(s.error());
+          }
+        }
+        continue;
+      case ws::Opcode::Pong:
+        continue;
+      case ws::Opcode::Close:
+        // an empty payload, or a status code followed by a UTF-8 reason
+        if (payload.size() == 1) {
+          co_return co_await fail(ws::CloseProtocolError, std::errc::protocol_error);
+        } else if (payload.size() >= 2 &&
+                   !ws::ValidCloseCode(std::uint16_t(std::to_integer<int>(payload[0]) << 8 |
+                                                     std::to_integer<int>(payload[1])))) {
+          co_return co_await fail(ws::CloseProtocolError, std::errc::protocol_error);
+        } else if (payload.size() > 2 && !ws::ValidUtf8(payload.subspan(2))) {
+          co_return co_await fail(ws::CloseInvalidData, std::errc::illegal_byte_sequence);
+        }
+        if (!mCloseSent) {
+          // echo the status code, as RFC 6455 section 5.5.1 asks
+          if (auto s = co_await sendFrame(ws::Opcode::Close, payload.first(std::min<std::size_t>(payload.size(), 2)),
+                                          true);
+              !s) {
+            co_return make_unexpected(s.error());
+          }
+          mCloseSent = true;
+        }
+        co_return WebSocketMessage {ws::Opcode::Close, payload};
+      case ws::Opcode::Continuation:
+        if (mFragmented == ws::Opcode::Continuation) {
+          co_return co_await fail(ws::CloseProtocolError, std::errc::protocol_error);
+        }
+        mMessage.insert(mMessage.end(), payload.begin(), payload.end());
+        if (header.fin) {
+          if (mFragmented == ws::Opcode::Text && !ws::ValidUtf8(mMessage)) {
+            co_return co_await fail(ws::CloseInvalidData, std::errc::illegal_byte_sequence);
+          }
+          std::swap(mReassembled, mMessage);
+          mMessage.clear();
+          co_return WebSocketMessage {std::exchange(mFragmented, ws::Opcode::Continuation), mReassembled};
+        }
+        continue;
+      default: // Text or Binary
+        if (mFragmented != ws::Opcode::Continuation) {
+          co_return co_await fail(ws::CloseProtocolError, std::errc::protocol_error);
+        } else if (header.fin) {
+          if (header.opcode == ws::Opcode::Text && !ws::ValidUtf8(payload)) {
+            co_return co_await fail(ws::CloseInvalidData, std::errc::illegal_byte_sequence);
+          }
+          co_return WebSocketMessage {header.opcode, payload};
+        }
+        mFragmented = header.opcode;
+        mMessage.assign(payload.begin(), payload.end());
+        continue;
+      }
+    }
+  }
+  // Sends one frame. A message may be sent in fragments: the first with its opcode and `fin` false, the rest with
+  // Opcode::Continuation.
+  auto send(std::span<std::byte const> data, ws::Opcode opcode = ws::Opcode::Binary, bool fin = true)
+      -> Task<StdResult<void>>
+  {
+    return sendFrame(opcode, data, fin);
+  }
+  auto sendText(std::string_view text) -> Task<StdResult<void>>
+  {
+    return sendFrame(ws::Opcode::Text, std::as_bytes(std::span(text)), true);
+  }
+  auto ping(std::span<std::byte const> data = {}) -> Task<StdResult<void>>
+  {
+    assert(data.size() <= ws::MaxControlPayload);
+    return sendFrame(ws::Opcode::Ping, data, true);
+  }
+  // Starts the closing handshake; keep calling receive() until it returns the peer's Close.
+  auto close(std::uint16_t code = ws::CloseNormal, std::string_view reason = {}) -> Task<StdResult<void>>
+  {
+    auto payload = std::array<std::byte, ws::MaxControlPayload> {};
+    payload[0] = std::byte(code >> 8);
+    payload[1] = std::byte(code & 0xff);
+    reason = reason.substr(0, payload.size() - 2);
+    std::memcpy(payload.data() + 2, reason.data(), reason.size());
+    mCloseSent = true;
+    co_return co_await sendFrame(ws::Opcode::Close, std::span(payload).first(2 + reason.size()), true);
+  }
+  auto stream() -> Stream& { return mStream; }
+
+private:
+  auto sendFrame(ws::Opcode opcode, std::span<std::byte const> payload, bool fin) -> Task<StdResult<void>>
+  {
+    auto header = ws::FrameHeader {fin, opcode, mRole == ws::Role::Client, {}, payload.size()};
+    if (header.masked) {
+      auto mask = ws::NewMask();
+      if (!mask) {
+        co_return make_unexpected(mask.error());
+      }
+      header.mask = mask.value();
+    }
+    auto head = std::array<std::byte, ws::MaxHeaderSize> {};
+    auto headSize = ws::EncodeHeader(header, head);
+    if constexpr (requires(Stream& s, std::span<iovec const> iov) { s.sendv(iov); }) {
+      if (!header.masked) {
+        iovec iov[2] = {{head.data(), headSize}, {const_cast<std::byte*>(payload.data()), payload.size()}};
+        auto pending = std::span<iovec>(iov, payload.empty() ? 1 : 2);
+        while (!pending.empty()) {
+          auto n = co_await mStream.sendv(pending);
+          if (!n) {
+            if (!async::detail::WouldBlock(n.error())) {
+              co_return make_unexpected(async::detail::ToErrc(n.error()));
+            }
+            continue;
+          }
+          async::detail::AdvanceIov(pending, std::size_t(n.value()));
+        }
+        co_return StdResult<void> {};
+      }
+    }
+    // header and payload go out as one write, which for TLS also means one record
+    mOut.resize(headSize + payload.size());
+    std::memcpy(mOut.data(), head.data(), headSize);
+    std::memcpy(mOut.data() + headSize, payload.data(), payload.size());
+    if (header.masked) {
+      ws::ApplyMask(std::span(mOut).subspan(headSize), header.mask);
+    }
+    for (auto pending = std::span<std::byte const>(mOut); !pending.empty();) {
+      auto n = co_await mStream.send(pending);
+      if (n) {
+        pending = pending.subspan(std::size_t(n.value()));
+      } else if (!async::detail::WouldBlock(n.error())) {
+        co_return make_unexpected(async::detail::ToErrc(n.error()));
+      }
+    }
+    co_return StdResult<void> {};
+  }
+  // Reads until the unconsumed part of the buffer holds at least `want` bytes or the peer stops sending.
+  auto fill(std::size_t want) -> Task<StdResult<void>>
+  {
+    if (mConsumed != 0 && mConsumed + want > mIn.size()) {
+      std::memmove(mIn.data(), mIn.data() + mConsumed, mFilled - mConsumed);
+      mFilled -= mConsumed;
+      mConsumed = 0;
+    }
+    if (mConsumed + want > mIn.size()) {
+      mIn.resize(std::max(mConsumed + want, mIn.size() * 2));
+    }
+    auto n = co_await mStream.recv(std::span(mIn).subspan(mFilled));
+    while (!n && async::detail::WouldBlock(n.error())) {
+      n = co_await mStream.recv(std::span(mIn).subspan(mFilled));
+    }
+    if (!n) {
+      co_return make_unexpected(async::detail::ToErrc(n.error()));
+    } else if (n.value() == 0) {
+      co_return make_unexpected(std::errc::connection_reset);
+    }
+    mFilled += std::size_t(n.value());
+    co_return StdResult<void> {};
+  }
+  auto fail(std::uint16_t code, std::errc error) -> Task<StdResult<WebSocketMessage>>
+  {
+    if (!mCloseSent) {
+      co_await close(code);
+    }
+    co_return make_unexpected(error);
+  }
+
+  Stream mStream;
+  WebSocketOptions mOptions;
+  ws::Role mRole;
+  bool mCloseSent = false;
+  ws::Opcode mFragmented = ws::Opcode::Continuation; // opcode of the message being reassembled, if any
+  std::vector<std::byte> mIn;
+  std::size_t mFilled = 0;
+  std::size_t mConsumed = 0; // bytes of mIn handed out or skipped, dropped once fill() needs the room
+  std::vector<std::byte> mMessage;
+  std::vector<std::byte> mReassembled; // last reassembled message, kept alive until the next receive()
+  std::vector<std::byte> mOut;
+};
+
+// Reads the upgrade request from a freshly accepted stream and completes the server side of the handshake. Requests
+// that are not valid WebSocket upgrades get a 400 and std::errc::protocol_error.
+template <typename Stream>
+auto AcceptWebSocket(Stream stream, WebSocketOptions options = {}) -> Task<StdResult<WebSocket<Stream>>>
+{
+  auto in = std::string(4096, '\0');
+  auto filled = std::size_t {0};
+  auto parser = RequestParser {};
+  auto request = Request {};
+  while (true) {
+    auto r = parser.parse({in.data(), filled}, request);
+    if (r.status == ParseStatus::Incomplete) {
+      if (filled == in.size()) {
+        if (in.size() >= RequestParser::MaxHeadSize) {
+          co_return make_unexpected(std::errc::protocol_error);
+        }
+        in.resize(in.size() * 2);
+      }
+      auto n = co_await stream.recv(std::as_writable_bytes(std::span(in)).subspan(filled));
+      if (!n && async::detail::WouldBlock(n.error())) {
+        continue;
+      } else if (!n) {
+        co_return make_unexpected(async::detail::ToErrc(n.error()));
+      } else if (n.value() == 0) {
+        co_return make_unexpected(std::errc::connection_reset);
+      }
+      filled += std::size_t(n.value());
+      continue;
+    }
+    auto out = std::string();
+    auto key = r.status == ParseStatus::Complete ? ws::UpgradeKey(request) : std::nullopt;
+    if (key) {
+      ws::WriteUpgradeResponse(out, *key);
+    } else {
+      out = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+    for (auto pending = std::string_view(out); !pending.empty();) {
+      auto n = co_await stream.send(std::as_bytes(std::span(pending)));
+      if (n) {
+        pending.remove_prefix(std::size_t(n.value()));
+      } else if (!async::detail::WouldBlock(n.error())) {
+        co_return make_unexpected(async::detail::ToErrc(n.error()));
+      }
+    }
+    if (!key) {
+      co_return make_unexpected(std::errc::protocol_error);
+    }
+    auto buffered = std::string_view(in).substr(r.consumed, filled - r.consumed);
+    co_return WebSocket<Stream>(std::move(stream), ws::Role::Server, options, buffered);
+  }
+}
+
+// Performs the client side of the handshake for `path` on `host` over a connected stream.
+template <typename Stream>
+auto ConnectWebSocket(Stream stream, std::string_view host, std::string_view path, WebSocketOptions options = {})
+    -> Task<StdResult<WebSocket<Stream>>>
+{
+  auto out = std::string();
+  auto accept = ws::WriteUpgradeRequest(out, host, path);
+  if (!accept) {
+    co_return make_unexpected(accept.error());
+  }
+  for (auto pending = std::string_view(out); !pending.empty();) {
+    auto n = co_await stream.send(std::as_bytes(std::span(pending)));
+    if (n) {
+      pending.remove_prefix(std::size_t(n.value()));
+    } else if (!async::detail::WouldBlock(n.error())) {
+      co_return make_unexpected(async::detail::ToErrc(n.error()));
+    }
+  }
+  auto in = std::string(4096, '\0');
+  auto filled = std::size_t {0};
+  while (true) {
+    auto r = ws::ParseUpgradeResponse({in.data(), filled}, *accept);
+    if (r.status == ParseStatus::Error) {
+      co_return make_unexpected(std::errc::protocol_error);
+    } else if (r.status == ParseStatus::Complete) {
+      auto buffered = std::string_view(in).substr(r.consumed, filled - r.consumed);
+      co_return WebSocket<Stream>(std::move(stream), ws::Role::Client, options, buffered);
+    } else if (filled == in.size()) {
+      co_return make_unexpected(std::errc::protocol_error);
+    }
+    auto n = co_await stream.recv(std::as_writable_bytes(std::span(in)).subspan(filled));
+    if (!n && async::detail::WouldBlock(n.error())) {
+      continue;
+    } else if (!n) {
+      co_return make_unexpected(async::detail::ToErrc(n.error()));
+    } else if (n.value() == 0) {
+      co_return make_unexpected(std::errc::connection_reset);
+    }
+    filled += std::size_t(n.value());
+  }
+}
+} // namespace async::http
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <sys/uio.h>
+#include <system_error>
+
+namespace async::detail {
+// How a transport reports its errors, for code generic over plain sockets (std::errc errors) and other transports:
+// whether the operation has to wait for readiness, whether the error is the end of the stream, and the std::errc to
+// hand to callers. A transport with its own error type specializes this next to it, as SslSocket.hpp does for
+// SslError, so generic code needs no header of that transport.
+template <typename E>
+struct IoErrorTraits;
+
+template <>
+struct IoErrorTraits<std::errc> {
+  static auto WouldBlock(std::errc e) -> bool
+  {
+    return e == std::errc::operation_would_block || e == std::errc::resource_unavailable_try_again;
+  }
+  // a plain socket reports the end of the stream as a 0 byte read
+  static auto IsEof(std::errc) -> bool { return false; }
+  static auto ToErrc(std::errc e) -> std::errc { return e; }
+};
+
+template <typename E>
+inline auto WouldBlock(E e) -> decltype(IoErrorTraits<E>::WouldBlock(e))
+{
+  return IoErrorTraits<E>::WouldBlock(e);
+}
+template <typename E>
+inline auto IsEof(E e) -> decltype(IoErrorTraits<E>::IsEof(e))
+{
+  return IoErrorTraits<E>::IsEof(e);
+}
+template <typename E>
+inline auto ToErrc(E e) -> decltype(IoErrorTraits<E>::ToErrc(e))
+{
+  return IoErrorTraits<E>::ToErrc(e);
+}
+
+// Drops the first `sent` bytes of a vectored write from `pending`, leaving the iovecs still to send.
+inline auto AdvanceIov(std::span<iovec>& pending, std::size_t sent) -> void
+{
+  while (sent != 0) {
+    auto step = std::min(sent, pending.front().iov_len);
+    pending.front().iov_base = static_cast<std::byte*>(pending.front().iov_base) + step;
+    pending.front().iov_len -= step;
+    sent -= step;
+    if (pending.front().iov_len == 0) {
+      pending = pending.subspan(1);
+    }
+  }
+}
+} // namespace async::detail
@@ -1,44 +1,72 @@
 #pragma once
+#include "IoError.hpp"
 #include "sys.hpp"
 #include <Async/Executor.hpp>
 #include <Async/Reactor.hpp>
+#include <Async/Task.hpp>
 
 namespace async {
+namespace detail {
+template <typename Stream>
+struct ConnectAwaiter;
+template <typename Stream>
+struct SplitState;
+} // namespace detail
+
 class Socket {
 public:
+  template <typename Stream>
+  friend struct detail::ConnectAwaiter;
+  template <typename Stream>
+  friend struct detail::SplitState;
+  friend class AsyncFd;
+  friend class BlockingPool;
   friend class SslSocket;
   friend class SslStream;
   friend class SslListener;
   friend class TcpStream;
   friend class TcpListener;
+  friend class Resolver;
+  friend class UnixStream;
   inline static auto Create(Reactor* reactor, SocketAddr const& addr) -> StdResult<Socket>
   {
     if (auto fd = impl::Socket::CreateNonBlock(addr); !fd) {
       return make_unexpected(fd.error());
     } else {
-      if (auto source = reactor->insertIo(fd.value().raw()); !source) {
-        return make_unexpected(source.error());
-      } else {
-        return {Socket {reactor, *source}};
+      return Register(reactor, fd.value());
+    }
+  }
+  // Registers an already created non-blocking socket with the reactor. The socket is closed if that fails, except when
+  // the descriptor is already registered (file_exists): it then belongs to that registration and is left open.
+  inline static auto Register(Reactor* reactor, impl::Socket socket) -> StdResult<Socket>
+  {
+    if (auto source = reactor->insertIo(socket.raw()); !source) {
+      if (source.error() != std::errc::file_exists) {
+        socket.close();
       }
+      return make_unexpected(source.error());
+    } else {
+      return {Socket {reactor, std::move(*source)}};
     }
   }
-  Socket() : mSource(nullptr), mReactor(nullptr) {}
+  Socket() = default;
   Socket(Reactor* reactor, std::shared_ptr<Source> source) : mSource(std::move(source)), mReactor(reactor) {}
   Socket(Socket const&) = delete;
   Socket& operator=(Socket const&) = delete;
-  Socket(Socket&& other) = default;
-  Socket& operator=(Socket&&) = default;
-  ~Socket()
+  Socket(Socket&& other) noexcept
+      : mSource(std::move(other.mSource)), mReactor(std::exchange(other.mReactor, nullptr))
   {
-    if (mSource) {
-      assert(mReactor);
-      auto r1 = mReactor->removeIo(*mSource);
-      assert(r1);
-      auto r2 = getSocket().close();
-      assert(r2);
+  }
+  Socket& operator=(Socket&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      mSource = std::move(other.mSource);
+      mReactor = std::exchange(other.mReactor, nullptr);
     }
+    return *this;
   }
+  ~Socket() { reset(); }
 
   auto send(std::span<std::byte const> data)
   {
@@ -50,8 +78,7 @@ public:
       auto await_ready() noexcept -> bool
       {
         auto n = socket.getSocket().sendNonBlock(data, 0);
-        if (!n &&
-            (n.error() == std::errc::operation_would_block || n.error() == std::errc::resource_unavailable_try_again)) {
+        if (!n && detail::WouldBlock(n.error())) {
           suspendedBefore = true;
           return false; // suspend now
         } else if (!n) {
@@ -83,6 +110,38 @@ public:
     };
     return WritableAwaiter {*this, data};
   }
+#ifdef __linux__
+  // Gathers `iov` into one send. Returns the number of bytes sent, which may end inside any of the buffers.
+  auto sendv(std::span<iovec const> iov)
+  {
+    struct VectoredAwaiter {
+      Socket& socket;
+      std::span<iovec const> iov;
+      StdResult<ssize_t> result;
+      bool suspendedBefore = false;
+      auto await_ready() noexcept -> bool
+      {
+        auto n = socket.getSocket().sendvNonBlock(iov);
+        if (!n && detail::WouldBlock(n.error())) {
+          suspendedBefore = true;
+          return false;
+        }
+        result = n;
+        return true;
+      }
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+      {
+        auto r = socket.regW(handle);
+        assert(r);
+      }
+      auto await_resume() -> StdResult<ssize_t>
+      {
+        return suspendedBefore ? socket.getSocket().sendvNonBlock(iov) : std::move(result);
+      }
+    };
+    return VectoredAwaiter {*this, iov};
+  }
+#endif
   auto recv(std::span<std::byte> data)
   {
     struct ReadableAwaiter {
@@ -93,8 +152,7 @@ public:
       auto await_ready() noexcept -> bool
       {
         auto n = socket.getSocket().recvNonBlock(data, 0);
-        if (!n &&
-            (n.error() == std::errc::operation_would_block || n.error() == std::errc::resource_unavailable_try_again)) {
+        if (!n && detail::WouldBlock(n.error())) {
           suspendedBefore = true;
           return false; // suspend right now
         } else if (!n) {
@@ -126,20 +184,35 @@ public:
     };
     return ReadableAwaiter {*this, data};
   }
-  // readable
-  auto accept(SocketAddr* addr)
+  // Suspend until the socket is readable or writable without doing any I/O, so a connection can wait for its next
+  // request holding no buffer and borrow one only once data arrived. A wakeup is a hint: the following recv or send
+  // may still find nothing to do and report std::errc::operation_would_block.
+  auto readable() { return ReadyAwaiter {*this, false}; }
+  auto writable() { return ReadyAwaiter {*this, true}; }
+  // readable. `options`, when given, is applied to the accepted socket before it is registered.
+  auto accept(SocketAddr* addr, SocketOptions const* options = nullptr)
   {
     struct AcceptAwaiter {
       Socket& socket;
       SocketAddr* addr;
+      SocketOptions const* options;
       StdResult<Socket> result {};
       bool suspendedBefore = false; // assign true when suspended
+      auto accepted(impl::Socket sock) -> StdResult<Socket>
+      {
+        if (options != nullptr) {
+          if (auto r = sock.applyStreamOptions(*options); !r) {
+            sock.close();
+            return make_unexpected(r.error());
+          }
+        }
+        return socket.regSocket(sock);
+      }
       auto await_ready() noexcept -> bool
       {
         auto sock = socket.getSocket().acceptNonBlock(addr);
         if (!sock) {
-          if (sock.error() == std::errc::operation_would_block ||
-              sock.error() == std::errc::resource_unavailable_try_again) {
+          if (detail::WouldBlock(sock.error())) {
             suspendedBefore = true;
             return false; // suspend right now
           } else {
@@ -147,7 +220,7 @@ public:
             return true;
           }
         } else {
-          result = socket.regSocket(sock.value());
+          result = accepted(sock.value());
           return true;
         }
       }
@@ -160,36 +233,34 @@ public:
       {
         if (suspendedBefore) { //
           auto sock = socket.getSocket().acceptNonBlock(addr);
-          assert(sock);
-          return socket.regSocket(sock.value());
+          if (!sock) {
+            return make_unexpected(sock.error()); // EMFILE and friends, or another acceptor was first
+          }
+          return accepted(sock.value());
         } else {
           return std::move(result);
         }
       }
     };
-    return AcceptAwaiter {*this, addr};
+    return AcceptAwaiter {*this, addr, options};
   }
 #ifdef __linux__
+  // Sends up to `count` bytes of `inFile` starting at *offset, which is advanced by the amount sent.
   auto sendfile(impl::fd_t inFile, off_t* offset, size_t count)
   {
     struct SendfileAwaiter {
+      Socket& socket;
       impl::fd_t file;
-      bool suspendedBefore = false;
-      StdResult<ssize_t> result;
       off_t* offset;
       size_t count;
-      Socket& socket;
+      StdResult<ssize_t> result;
+      bool suspendedBefore = false;
       auto await_ready() noexcept -> bool
       {
         auto r = socket.getSocket().sendfile(file, offset, count);
-        if (!r) {
-          if (r.error() == std::errc::resource_unavailable_try_again) {
-            suspendedBefore = true;
-            return false;
-          } else {
-            result = r;
-            return true;
-          }
+        if (!r && detail::WouldBlock(r.error())) {
+          suspendedBefore = true;
+          return false;
         } else {
           result = r;
           return true;
@@ -203,14 +274,41 @@ public:
       auto await_resume() -> StdResult<ssize_t>
       {
         if (suspendedBefore) {
-          auto r = socket.getSocket().sendfile(file, offset, count);
-          assert(r);
-          return r;
+          return socket.getSocket().sendfile(file, offset, count);
         } else {
           return std::move(result);
         }
       }
     };
+    return SendfileAwaiter {*this, inFile, offset, count};
+  }
+  // Sends `count` bytes of `inFile` starting at `offset`. Returns the number of bytes sent, which is less than `count`
+  // only if the file is shorter than expected.
+  auto sendfileAll(impl::fd_t inFile, off_t offset, size_t count) -> Task<StdResult<size_t>>
+  {
+    auto sent = size_t {0};
+    while (sent < count) {
+      auto n = co_await sendfile(inFile, &offset, count - sent);
+      if (!n) {
+        if (detail::WouldBlock(n.error())) {
+          continue;
+        }
+        co_return make_unexpected(n.error());
+      } else if (n.value() == 0) {
+        break; // end of file
+      }
+      sent += size_t(n.value());
+    }
+    co_return sent;
+  }
+#endif
+  auto setOptions(SocketOptions const& options) -> StdResult<void> { return getSocket().applyStreamOptions(options); }
+#ifdef __linux__
+  // Id of the NIC receive queue the connection's packets arrive on, 0 before any arrived. Handing connections with the
+  // same id to the same worker keeps busy polling on one queue per thread.
+  auto incomingNapiId() const -> StdResult<unsigned>
+  {
+    return getSocket().getOption<unsigned>(SOL_SOCKET, SO_INCOMING_NAPI_ID);
   }
 #endif
   auto shutdownRead() -> StdResult<void> { return getSocket().shutdownRead(); }
@@ -221,12 +319,37 @@ public:
     assert(mSource);
     return impl::Socket(mSource->fd);
   }
+  auto valid() const -> bool { return mSource != nullptr; }
+  auto reactor() const -> Reactor* { return mReactor; }
+  // Deregisters the socket from its reactor and hands back the descriptor, still open, leaving this Socket empty.
+  // Registering the descriptor with another reactor moves the connection there. Nothing may be waiting on it.
+  auto release() -> impl::Socket
+  {
+    assert(mSource && mReactor);
+    auto source = std::move(mSource);
+    auto r = std::exchange(mReactor, nullptr)->removeIo(*source);
+    assert(r);
+    return impl::Socket(source->fd);
+  }
 
 private:
+  auto source() const -> Source& { return *mSource; }
+  auto reset() -> void
+  {
+    if (mSource) {
+      assert(mReactor);
+      auto source = std::move(mSource);
+      auto r1 = std::exchange(mReactor, nullptr)->removeIo(*source);
+      assert(r1);
+      auto r2 = impl::Socket(source->fd).close();
+      assert(r2);
+    }
+  }
   auto regR(std::coroutine_handle<> handle) -> StdResult<>
   {
-    if (mSource->setReadable(handle)) {
-      return mReactor->updateIo(*mSource);
+    auto& source = this->source();
+    if (source.setReadable(handle)) {
+      return reactor()->updateIo(source);
     } else {
       assert(0 && "already readable");
       return {};
@@ -234,24 +357,88 @@ private:
   }
   auto regW(std::coroutine_handle<> handle) -> StdResult<>
   {
-    if (mSource->setWritable(handle)) {
-      return mReactor->updateIo(*mSource);
+    auto& source = this->source();
+    if (source.setWritable(handle)) {
+      return reactor()->updateIo(source);
     } else {
       assert(0 && "already writable");
       return {};
     }
   }
-  auto regSocket(impl::Socket socket) -> StdResult<Socket>
-  {
-    if (auto source = mReactor->insertIo(socket.raw()); !source) {
-      return make_unexpected(source.error());
-    } else {
-      return Socket {mReactor, *source};
+  auto regSocket(impl::Socket socket) -> StdResult<Socket> { return Register(reactor(), socket); }
+  struct ReadyAwaiter {
+    Socket& socket;
+    bool write;
+    auto await_ready() noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+    {
+      auto r = write ? socket.regW(handle) : socket.regR(handle);
+      assert(r);
     }
-  }
+    auto await_resume() noexcept -> void {}
+  };
 
 private:
   std::shared_ptr<Source> mSource;
-  Reactor* mReactor;
+  Reactor* mReactor = nullptr;
+};
+
+namespace detail {
+// Non-blocking connect shared by the stream types. Completes immediately when the kernel can, otherwise waits for the
+// socket to become writable and finishes the connection on resume.
+template <typename Stream>
+struct ConnectAwaiter {
+  StdResult<Socket> result;
+  async::Reactor& reactor;
+  SocketAddr const& addr;
+  bool suspendedBefore = false;
+  auto await_ready() noexcept -> bool
+  {
+    if (auto r = Socket::Create(&reactor, addr); !r) {
+      result = make_unexpected(r.error());
+      return true;
+    } else {
+      // socket create success
+      if (auto cr = r->getSocket().connect(addr); !cr) {
+        if (cr.error() == std::errc::operation_in_progress) {
+          // tcp failed with EINPROGRESS. A unix socket never does: it connects at once or fails, EAGAIN meaning the
+          // listener's backlog is full, which waiting for writability would not fix.
+          suspendedBefore = true; // suspend now
+          result = std::move(r).value();
+          return false;
+        } else {
+          result = make_unexpected(cr.error());
+          return true;
+        }
+      } else { // connect success
+        result = std::move(r).value();
+        return true;
+      }
+    }
+  }
+  auto await_suspend(std::coroutine_handle<> handle) -> void
+  {
+    assert(suspendedBefore);
+    assert(result);
+    auto r = result->regW(handle);
+    assert(r);
+  }
+  auto await_resume() -> StdResult<Stream>
+  {
+    if (suspendedBefore) {
+      assert(result);
+      // connect again
+      if (auto b = result->getSocket().connect(addr); !b) {
+        return make_unexpected(b.error()); // connect error
+      } else {
+        return {Stream(std::move(result).value())};
+      }
+    } else if (result) { // socket created
+      return {Stream(std::move(result).value())};
+    } else { // error occurred
+      return make_unexpected(result.error());
+    }
+  }
 };
-} // namespace async
\ No newline at end of file
+} // namespace detail
+} // namespace async
@@ -1,7 +1,10 @@
 #pragma once
+#include "Async/utils/predefined.hpp"
 #include <cassert>
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <string_view>
 namespace async {
 struct Ipv4Addr {
   operator uint32_t() const { return *reinterpret_cast<uint32_t const*>(addr); }
@@ -33,16 +36,54 @@ struct SocketAddrV6 {
   uint16_t port;
 };
 
+// Address of a unix domain socket: a filesystem path, or a name in the Linux abstract namespace which is not visible in
+// the filesystem and disappears with the last socket bound to it.
+struct SocketAddrUnix {
+  constexpr static std::size_t MaxPath = 107; // sizeof(sockaddr_un::sun_path) - 1
+
+  char path[MaxPath + 1];
+  uint8_t length; // bytes of `path` in use, excluding the terminating NUL of a filesystem path
+  bool abstract;
+
+  constexpr auto name() const -> std::string_view { return {path, length}; }
+
+  // Fails with filename_too_long when `path` does not fit sun_path together with its terminating NUL.
+  inline static auto Path(std::string_view path) -> StdResult<SocketAddrUnix>
+  {
+    if (path.empty()) {
+      return make_unexpected(std::errc::invalid_argument);
+    } else if (path.size() > MaxPath) {
+      return make_unexpected(std::errc::filename_too_long);
+    }
+    auto addr = SocketAddrUnix {{}, uint8_t(path.size()), false};
+    std::copy(path.begin(), path.end(), addr.path);
+    return addr;
+  }
+  // Fails with filename_too_long when `name` does not fit sun_path after the leading NUL.
+  inline static auto Abstract(std::string_view name) -> StdResult<SocketAddrUnix>
+  {
+    if (name.size() > MaxPath) {
+      return make_unexpected(std::errc::filename_too_long);
+    }
+    auto addr = SocketAddrUnix {{}, uint8_t(name.size()), true};
+    std::copy(name.begin(), name.end(), addr.path);
+    return addr;
+  }
+};
+
 class SocketAddr {
 public:
   enum class Family : uint8_t {
     V4,
     V6,
+    Unix,
   };
   constexpr SocketAddr(SocketAddrV4 addr) : v4(addr), family(Family::V4) {}
   constexpr SocketAddr(SocketAddrV6 addr) : v6(addr), family(Family::V6) {}
+  constexpr SocketAddr(SocketAddrUnix addr) : un(addr), family(Family::Unix) {}
   constexpr auto isIpv4() const -> bool { return family == Family::V4; }
   constexpr auto isIpv6() const -> bool { return family == Family::V6; }
+  constexpr auto isUnix() const -> bool { return family == Family::Unix; }
   constexpr auto getIpv4() const -> SocketAddrV4 const&
   {
     assert(isIpv4());
@@ -53,6 +94,11 @@ public:
     assert(isIpv6());
     return v6;
   }
+  constexpr auto getUnix() const -> SocketAddrUnix const&
+  {
+    assert(isUnix());
+    return un;
+  }
   constexpr auto getFamily() const -> Family { return family; }
   auto toString() -> std::string
   {
@@ -69,6 +115,8 @@ public:
       return result;
     } else if (isIpv6()) {
       assert(0 && "unimplmented");
+    } else if (isUnix()) {
+      return (un.abstract ? "@" : "") + std::string(un.name());
     } else {
       assert(0 && "unreachable");
     }
@@ -79,6 +127,7 @@ private:
   union {
     SocketAddrV4 v4;
     SocketAddrV6 v6;
+    SocketAddrUnix un;
   };
   Family family;
 };
@@ -0,0 +1,60 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace async {
+struct KeepAlive {
+  std::chrono::seconds idle {60};     // idle time before the first probe
+  std::chrono::seconds interval {10}; // time between unanswered probes
+  int count = 5;                      // unanswered probes before the connection is dropped
+};
+
+// Socket option profile. Unset options keep the system default. A listener applies the listener part when it is bound
+// and the stream part to every socket it accepts; streams can apply a profile with Socket::setOptions.
+struct SocketOptions {
+  // listener
+  int backlog = 1024;
+  bool reusePort = false;
+  std::optional<std::chrono::seconds> deferAccept; // wake accept only once data arrived (TCP_DEFER_ACCEPT)
+  std::optional<int> fastOpenQueue; // pending Fast Open requests accepted with data in the SYN (TCP_FASTOPEN)
+
+  // stream
+  std::optional<bool> noDelay;
+  std::optional<bool> quickAck; // not sticky: the kernel may fall back to delayed acks later
+  std::optional<int> sendBuffer;
+  std::optional<int> recvBuffer; // also set on the listener, the window scale is chosen before accept
+  std::optional<int> notSentLowat; // bytes of unsent data the socket may hold before it stops being writable
+  std::optional<KeepAlive> keepAlive;
+  // bytes per second the qdisc paces each connection to (SO_MAX_PACING_RATE), ignored where the kernel lacks it
+  std::optional<std::uint64_t> maxPacingRate;
+  // queueing class of the socket's packets in the qdisc (SO_PRIORITY), 0-6 without CAP_NET_ADMIN
+  std::optional<int> priority;
+  // IP_TOS, or IPV6_TCLASS on IPv6 sockets, ignored on others; the DSCP sits in the upper six bits
+  std::optional<int> tos;
+  // poll the NIC queue on receive instead of waiting (SO_BUSY_POLL). Raising these above the sysctl defaults needs
+  // CAP_NET_ADMIN.
+  std::optional<std::chrono::microseconds> busyPoll;
+  bool preferBusyPoll = false;       // suppress interrupts while the application keeps polling (SO_PREFER_BUSY_POLL)
+  std::optional<int> busyPollBudget; // packets handled per busy poll (SO_BUSY_POLL_BUDGET)
+
+  // Small request/response messages: no Nagle, immediate acks and a shallow send queue so writes stay fresh.
+  static auto LowLatency() -> SocketOptions
+  {
+    auto options = SocketOptions {};
+    options.noDelay = true;
+    options.quickAck = true;
+    options.notSentLowat = 16 << 10;
+    return options;
+  }
+  // Large transfers: deep buffers so a single connection can fill a long fat pipe.
+  static auto Bulk() -> SocketOptions
+  {
+    auto options = SocketOptions {};
+    options.sendBuffer = 4 << 20;
+    options.recvBuffer = 4 << 20;
+    options.keepAlive = KeepAlive {};
+    return options;
+  }
+};
+} // namespace async
@@ -1,5 +1,6 @@
 #pragma once
 #include "../SocketAddr.hpp"
+#include "../SocketOptions.hpp"
 #ifdef __linux__
   #include "Async/utils/predefined.hpp"
   #include <arpa/inet.h>
@@ -7,6 +8,7 @@
   #include <span>
   #include <sys/sendfile.h>
   #include <sys/socket.h>
+  #include <sys/uio.h>
   #include <unistd.h>
 namespace async::impl {
 using fd_t = int;
@@ -25,6 +27,7 @@ class Socket {
 public:
   static auto Create(async::SocketAddr const& addr, int ty) -> StdResult<Socket>;
   static auto CreateNonBlock(async::SocketAddr const& addr) -> StdResult<Socket>;
+  static auto CreateDatagramNonBlock(async::SocketAddr const& addr) -> StdResult<Socket>;
   Socket() : mFd(INVALID_FD) {}
   Socket(fd_t fd) : mFd(fd) {}
   ~Socket() = default;
@@ -133,6 +136,21 @@ public:
   {
     return SysCall(::recvfrom, mFd, buf, len, flags, src_addr, addrlen);
   }
+  auto sendvNonBlock(std::span<iovec const> iov) -> StdResult<ssize_t>
+  {
+    auto msg = msghdr {};
+    msg.msg_iov = const_cast<iovec*>(iov.data());
+    msg.msg_iovlen = iov.size();
+    return sendmsgNonBlock(&msg, 0);
+  }
+  auto sendmsgNonBlock(msghdr const* msg, int flags) -> StdResult<ssize_t>
+  {
+    return SysCall(::sendmsg, mFd, msg, flags | MSG_DONTWAIT | MSG_NOSIGNAL);
+  }
+  auto recvmsgNonBlock(msghdr* msg, int flags) -> StdResult<ssize_t>
+  {
+    return SysCall(::recvmsg, mFd, msg, flags | MSG_DONTWAIT);
+  }
   auto shutdownRead() -> StdResult<void> { return shutdown(SHUT_RD); }
   auto shutdownWrite() -> StdResult<void> { return shutdown(SHUT_WR); }
   auto shutdownReadWrite() -> StdResult<void> { return shutdown(SHUT_RDWR); }
@@ -149,6 +167,28 @@ public:
       return r;
     };
   }
+  template <typename T>
+  auto setOption(int level, int name, T const& value) -> StdResult<void>
+  {
+    if (auto r = SysCall(::setsockopt, mFd, level, name, &value, socklen_t(sizeof(T))); !r) {
+      return make_unexpected(r.error());
+    }
+    return {};
+  }
+  template <typename T>
+  auto getOption(int level, int name) const -> StdResult<T>
+  {
+    auto value = T {};
+    auto len = socklen_t(sizeof(T));
+    if (auto r = SysCall(::getsockopt, mFd, level, name, &value, &len); !r) {
+      return make_unexpected(r.error());
+    }
+    return value;
+  }
+  // Applies the options that must be set before bind and listen.
+  auto applyListenerOptions(SocketOptions const& options) -> StdResult<void>;
+  // Applies the per connection options.
+  auto applyStreamOptions(SocketOptions const& options) -> StdResult<void>;
   auto valid() const -> bool { return mFd != INVALID_FD; }
   auto raw() const -> fd_t { return mFd; }
 
@@ -0,0 +1,191 @@
+#include <Async/Admission.hpp>
+
+#include <cmath>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+namespace async {
+auto AdmissionPermit::firstByte() -> void
+{
+  if (mControl && !mSampled) {
+    mSampled = true;
+    auto now = AdmissionControl::Clock::now();
+    mControl->sample(now - mAccepted, now);
+  }
+}
+
+auto AdmissionPermit::reset() -> void
+{
+  if (mControl) {
+    mControl->release();
+    mControl.reset();
+  }
+}
+
+auto AdmissionControl::Create(Reactor& reactor, AdmissionOptions options)
+    -> StdResult<std::shared_ptr<AdmissionControl>>
+{
+  auto limit = options.maxConnections != 0 ? options.maxConnections : SIZE_MAX;
+  auto fdLimit = std::size_t(SIZE_MAX);
+  if (auto rlimit = ::rlimit {}; ::getrlimit(RLIMIT_NOFILE, &rlimit) == 0 && rlimit.rlim_cur != RLIM_INFINITY) {
+    fdLimit = rlimit.rlim_cur > options.fdHeadroom ? std::size_t(rlimit.rlim_cur - options.fdHeadroom) : 1;
+  }
+  auto wake = EventFd::Create(reactor);
+  if (!wake) {
+    return make_unexpected(wake.error());
+  }
+  auto timer = TimerFd::Create(reactor);
+  if (!timer) {
+    return make_unexpected(timer.error());
+  }
+  auto reserve = SysCall(::open, "/dev/null", O_RDONLY | O_CLOEXEC);
+  if (!reserve) {
+    return make_unexpected(reserve.error());
+  }
+  return std::shared_ptr<AdmissionControl>(new AdmissionControl(options, limit, fdLimit, std::move(wake).value(),
+                                                                std::move(timer).value(), reserve.value()));
+}
+
+AdmissionControl::AdmissionControl(AdmissionOptions options, std::size_t limit, std::size_t fdLimit, EventFd wake,
+                                   TimerFd timer, impl::fd_t reserve)
+    : mOptions(options), mLimit(limit), mFdLimit(fdLimit), mWake(std::move(wake)), mTimer(std::move(timer)),
+      mReserve(reserve)
+{
+}
+
+AdmissionControl::~AdmissionControl()
+{
+  if (mReserve != impl::INVALID_FD) {
+    ::close(mReserve);
+  }
+}
+
+auto AdmissionControl::accept(Socket& listener, SocketAddr* addr, SocketOptions const* options)
+    -> Task<StdResult<Admitted<Socket>>>
+{
+  while (true) {
+    if (mActive.load() >= mLimit) {
+      // leaving the listener unarmed until a permit is released
+      mWaiting.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (mActive.load() >= mLimit) {
+        co_await mWake.ready();
+        mWake.take();
+      }
+      mWaiting.store(false);
+      continue;
+    }
+    if (mProbeFds) {
+      // the lowest free descriptor, as many are open below it
+      auto next = SysCall(::fcntl, listener.getSocket().raw(), F_DUPFD_CLOEXEC, 0);
+      if (next) {
+        ::close(next.value());
+      } else {
+        shedOne(listener); // none left at all, accept would fail with EMFILE
+      }
+      if (!next || std::size_t(next.value()) >= mFdLimit) {
+        auto r = co_await mTimer.sleepFor(mOptions.fdRetryDelay); // what others release frees no permit here
+        assert(r);
+        continue;
+      }
+      mProbeFds = false;
+    }
+    auto socket = co_await listener.accept(addr, options);
+    if (!socket) {
+      auto error = socket.error();
+      if (error == std::errc::too_many_files_open || error == std::errc::too_many_files_open_in_system) {
+        shedOne(listener);
+        auto r = co_await mTimer.sleepFor(mOptions.fdRetryDelay);
+        assert(r);
+        continue;
+      } else if (detail::WouldBlock(error) || error == std::errc::connection_aborted) {
+        continue;
+      }
+      co_return make_unexpected(error);
+    }
+    // every descriptor below the new one is open, whoever holds it
+    mProbeFds = std::size_t(socket->getSocket().raw()) + 1 >= mFdLimit;
+    auto now = Clock::now();
+    if (shouldShed(now)) {
+      mShed.fetch_add(1, std::memory_order_relaxed);
+      continue; // the socket closes here
+    }
+    mActive.fetch_add(1);
+    co_return Admitted<Socket> {std::move(socket).value(), AdmissionPermit(shared_from_this(), now)};
+  }
+}
+
+auto AdmissionControl::release() -> void
+{
+  mActive.fetch_sub(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst); // order the release before reading the flag
+  if (mWaiting.load(std::memory_order_relaxed) && mWaiting.exchange(false)) {
+    auto r = mWake.notify();
+    assert(r);
+  }
+}
+
+auto AdmissionControl::shedOne(Socket& listener) -> void
+{
+  if (mReserve == impl::INVALID_FD) {
+    return;
+  }
+  ::close(mReserve);
+  if (auto fd = SysCall(::accept4, listener.getSocket().raw(), nullptr, nullptr, SOCK_CLOEXEC); fd) {
+    ::close(fd.value());
+    mShed.fetch_add(1, std::memory_order_relaxed);
+  }
+  auto reserve = SysCall(::open, "/dev/null", O_RDONLY | O_CLOEXEC);
+  mReserve = reserve ? reserve.value() : impl::INVALID_FD; // retried on the next shed
+}
+
+auto AdmissionControl::sample(Clock::duration sojourn, Clock::time_point now) -> void
+{
+  if (!mOptions.codel) {
+    return;
+  }
+  auto lock = std::lock_guard(mMutex);
+  mLastSample = now;
+  if (sojourn < mOptions.codel->target) {
+    mFirstAbove = {};
+    mOverloaded = false;
+  } else if (mFirstAbove == Clock::time_point {}) {
+    mFirstAbove = now + mOptions.codel->interval;
+  } else if (now >= mFirstAbove) {
+    mOverloaded = true;
+  }
+}
+
+auto AdmissionControl::shouldShed(Clock::time_point now) -> bool
+{
+  if (!mOptions.codel) {
+    return false;
+  }
+  auto const interval = mOptions.codel->interval;
+  auto controlLaw = [&](Clock::time_point t) {
+    return t + std::chrono::duration_cast<Clock::duration>(interval / std::sqrt(double(mDropCount)));
+  };
+  auto lock = std::lock_guard(mMutex);
+  if (mOverloaded && now - mLastSample > interval) {
+    mOverloaded = false; // nothing was measured lately, the last verdict is stale
+    mFirstAbove = {};
+  }
+  if (!mOverloaded) {
+    mDropping = false;
+    return false;
+  }
+  if (!mDropping) {
+    // resume near the previous shedding rate when overload returns soon after it ended
+    mDropCount = mDropCount > 2 && now - mDropNext < 16 * interval ? mDropCount - 2 : 1;
+    mDropping = true;
+    mDropNext = controlLaw(now);
+    return true;
+  }
+  if (now >= mDropNext) {
+    mDropCount++;
+    mDropNext = controlLaw(mDropNext);
+    return true;
+  }
+  return false;
+}
+} // namespace async
@@ -0,0 +1,116 @@
+#include <Async/BlockingPool.hpp>
+
+#include <sys/eventfd.h>
+
+namespace async {
+namespace {
+constexpr std::size_t MaxIdleEvents = 8;
+
+// registered eventfds kept per thread, creating and registering one costs several syscalls
+thread_local std::vector<Socket> tIdleEvents;
+
+auto AcquireEvent(Reactor& reactor) -> StdResult<Socket>
+{
+  for (auto it = tIdleEvents.begin(); it != tIdleEvents.end(); ++it) {
+    if (it->reactor() == &reactor) {
+      auto event = std::move(*it);
+      tIdleEvents.erase(it);
+      return event;
+    }
+  }
+  if (auto fd = SysCall(::eventfd, 0, EFD_NONBLOCK | EFD_CLOEXEC); !fd) {
+    return make_unexpected(fd.error());
+  } else {
+    return Socket::Register(&reactor, impl::Socket(fd.value()));
+  }
+}
+
+auto ReleaseEvent(Socket event) -> void
+{
+  if (tIdleEvents.size() < MaxIdleEvents) {
+    tIdleEvents.push_back(std::move(event));
+  }
+}
+} // namespace
+
+BlockingPool::BlockingPool(std::size_t threads)
+{
+  assert(threads > 0);
+  for (std::size_t i = 0; i < threads; i++) {
+    mThreads.emplace_back([this] { work(); });
+  }
+}
+
+BlockingPool::~BlockingPool()
+{
+  {
+    auto lock = std::lock_guard(mMutex);
+    mStop = true;
+  }
+  mCond.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+auto BlockingPool::Default() -> BlockingPool&
+{
+  static BlockingPool pool(4);
+  return pool;
+}
+
+auto BlockingPool::submit(std::function<void()> job) -> void
+{
+  {
+    auto lock = std::lock_guard(mMutex);
+    mJobs.push_back(std::move(job));
+  }
+  mCond.notify_one();
+}
+
+auto BlockingPool::work() -> void
+{
+  while (true) {
+    auto lock = std::unique_lock(mMutex);
+    mCond.wait(lock, [this] { return mStop || !mJobs.empty(); });
+    if (mJobs.empty()) {
+      return;
+    }
+    auto job = std::move(mJobs.front());
+    mJobs.pop_front();
+    lock.unlock();
+    job();
+  }
+}
+
+auto BlockingPool::run(Reactor& reactor, std::function<void()> job) -> Task<StdResult<void>>
+{
+  auto event = AcquireEvent(reactor);
+  if (!event) {
+    co_return make_unexpected(event.error());
+  }
+  auto fd = event->getSocket().raw();
+  submit([&job, fd] {
+    job();
+    ::eventfd_write(fd, 1);
+  });
+
+  struct ReadableAwaiter {
+    Socket& event;
+    auto await_ready() noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) -> void
+    {
+      auto r = event.regR(handle);
+      assert(r);
+    }
+    auto await_resume() noexcept -> void {}
+  };
+  // the job owns the eventfd until its write was consumed, only then may it go back to the idle list
+  auto value = eventfd_t {};
+  while (::eventfd_read(fd, &value) != 0) {
+    co_await ReadableAwaiter {*event};
+  }
+  ReleaseEvent(std::move(event).value());
+  co_return StdResult<void> {};
+}
+} // namespace async
@@ -0,0 +1,15 @@
+#include <Async/BufferPool.hpp>
+
+#include <unordered_map>
+
+namespace async {
+auto BufferPool::Local(std::size_t bufferSize) -> BufferPool&
+{
+  thread_local auto pools = std::unordered_map<std::size_t, std::unique_ptr<BufferPool>>();
+  auto& pool = pools[bufferSize];
+  if (!pool) {
+    pool = std::make_unique<BufferPool>(bufferSize);
+  }
+  return *pool;
+}
+} // namespace async
@@ -0,0 +1,138 @@
+#include <Async/CoreRuntime.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace async {
+namespace {
+struct CurrentCore {
+  CoreRuntime const* runtime = nullptr;
+  std::size_t core = 0;
+};
+thread_local auto tCurrent = CurrentCore {};
+} // namespace
+
+auto CoreRuntime::Create(CoreRuntimeOptions options) -> StdResult<std::unique_ptr<CoreRuntime>>
+{
+  auto cpus = std::vector<int>();
+  if (auto set = cpu_set_t {}; ::sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  auto count = options.cores != 0 ? options.cores : std::max<std::size_t>(cpus.size(), 1);
+  auto runtime = std::unique_ptr<CoreRuntime>(new CoreRuntime());
+  runtime->mBusyPoll = options.busyPoll;
+  for (std::size_t i = 0; i < count; i++) {
+    auto core = std::make_unique<Core>();
+    core->reactor = std::make_unique<Reactor>();
+    auto wake = EventFd::Create(*core->reactor);
+    if (!wake) {
+      return make_unexpected(wake.error());
+    }
+    core->wake = std::move(wake).value();
+    runtime->mCores.push_back(std::move(core));
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    auto cpu = options.pinThreads && !cpus.empty() ? cpus[i % cpus.size()] : -1;
+    runtime->mCores[i]->thread = std::thread([runtime = runtime.get(), i, cpu] { runtime->run(i, cpu); });
+  }
+  return runtime;
+}
+
+CoreRuntime::~CoreRuntime()
+{
+  mStopping.store(true, std::memory_order_release);
+  for (auto& core : mCores) {
+    auto r = core->wake.notify();
+    assert(r);
+  }
+  for (auto& core : mCores) {
+    if (core->thread.joinable()) {
+      core->thread.join();
+    }
+  }
+  // no core runs anymore, so the frames can go from here, while the reactors their sockets deregister from are still
+  // there; the inboxes only point into these frames
+  for (auto root : mRoots) {
+    root.destroy();
+  }
+  mRoots.clear();
+  for (auto& core : mCores) {
+    core->inbox.clear();
+  }
+}
+
+auto CoreRuntime::currentCore() const -> std::optional<std::size_t>
+{
+  if (tCurrent.runtime != this) {
+    return std::nullopt;
+  }
+  return tCurrent.core;
+}
+
+auto CoreRuntime::spawn(std::size_t core, Task<> task) -> void
+{
+  auto lock = std::unique_lock(mRootsMutex);
+  auto root = mRoots.emplace(mRoots.end());
+  auto handle = *root = detail::Detach(own(std::move(task), root)).handle;
+  lock.unlock();
+  post(core, handle);
+}
+
+auto CoreRuntime::own(Task<> task, std::list<std::coroutine_handle<>>::iterator root) -> Task<>
+{
+  co_await std::move(task);
+  auto lock = std::lock_guard(mRootsMutex);
+  mRoots.erase(root);
+}
+
+auto CoreRuntime::post(std::size_t core, std::coroutine_handle<> handle) -> void
+{
+  auto& target = *mCores[core];
+  auto lock = std::unique_lock(target.mutex);
+  auto wasEmpty = target.inbox.empty();
+  target.inbox.push_back(handle);
+  lock.unlock();
+  if (wasEmpty) { // a non-empty inbox is already being woken
+    auto r = target.wake.notify();
+    assert(r);
+  }
+}
+
+auto CoreRuntime::run(std::size_t core, int cpu) -> void
+{
+  tCurrent = {this, core};
+  if (cpu >= 0) {
+    auto set = cpu_set_t {};
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set); // best effort, e.g. under a cgroup CPU limit
+  }
+  auto& self = *mCores[core];
+  self.running = true;
+  detail::Detach(drain(core)).handle.resume();
+  BusyPoll(*self.reactor, mBusyPoll).run([&] { return !self.running; }); // until the inbox saw the stop
+}
+
+auto CoreRuntime::drain(std::size_t core) -> Task<>
+{
+  auto& self = *mCores[core];
+  auto batch = std::vector<std::coroutine_handle<>>();
+  while (!mStopping.load(std::memory_order_acquire)) {
+    co_await self.wake.ready();
+    self.wake.take();
+    {
+      auto lock = std::lock_guard(self.mutex);
+      batch.swap(self.inbox);
+    }
+    for (auto handle : batch) {
+      handle.resume();
+    }
+    batch.clear();
+  }
+  self.running = false;
+}
+} // namespace async
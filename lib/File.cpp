@@ -0,0 +1,122 @@
+#include <Async/File.hpp>
+
+#include <sys/stat.h>
+
+namespace async {
+auto File::Open(Reactor& reactor, std::filesystem::path path, int flags, mode_t mode, BlockingPool& pool)
+    -> Task<StdResult<File>>
+{
+  auto fd = StdResult<int>();
+  if (auto r = co_await pool.run(reactor, [&] { fd = SysCall(::open, path.c_str(), flags | O_CLOEXEC, mode); }); !r) {
+    co_return make_unexpected(r.error());
+  } else if (!fd) {
+    co_return make_unexpected(fd.error());
+  }
+  co_return File(reactor, fd.value(), pool);
+}
+
+File& File::operator=(File&& other) noexcept
+{
+  if (this != &other) {
+    if (mFd != impl::INVALID_FD) {
+      ::close(mFd);
+    }
+    mReactor = other.mReactor;
+    mPool = other.mPool;
+    mFd = std::exchange(other.mFd, impl::INVALID_FD);
+  }
+  return *this;
+}
+
+File::~File()
+{
+  if (mFd != impl::INVALID_FD) {
+    ::close(mFd);
+  }
+}
+
+auto File::read(std::span<std::byte> data, off_t offset) -> Task<StdResult<size_t>>
+{
+  assert(mFd != impl::INVALID_FD);
+  auto result = StdResult<size_t>(0);
+  auto job = [&, fd = mFd] {
+    auto done = size_t(0);
+    while (done < data.size()) {
+      auto n = SysCall(::pread, fd, data.data() + done, data.size() - done, offset + off_t(done));
+      if (!n) {
+        if (n.error() == std::errc::interrupted) {
+          continue;
+        }
+        result = make_unexpected(n.error());
+        return;
+      } else if (n.value() == 0) {
+        break;
+      }
+      done += size_t(n.value());
+    }
+    result = done;
+  };
+  if (auto r = co_await mPool->run(*mReactor, job); !r) {
+    co_return make_unexpected(r.error());
+  }
+  co_return result;
+}
+
+auto File::write(std::span<std::byte const> data, off_t offset) -> Task<StdResult<size_t>>
+{
+  assert(mFd != impl::INVALID_FD);
+  auto result = StdResult<size_t>(0);
+  auto job = [&, fd = mFd] {
+    auto done = size_t(0);
+    while (done < data.size()) {
+      auto n = SysCall(::pwrite, fd, data.data() + done, data.size() - done, offset + off_t(done));
+      if (!n) {
+        if (n.error() == std::errc::interrupted) {
+          continue;
+        }
+        result = make_unexpected(n.error());
+        return;
+      }
+      done += size_t(n.value());
+    }
+    result = done;
+  };
+  if (auto r = co_await mPool->run(*mReactor, job); !r) {
+    co_return make_unexpected(r.error());
+  }
+  co_return result;
+}
+
+auto File::fsync() -> Task<StdResult<void>>
+{
+  assert(mFd != impl::INVALID_FD);
+  auto result = StdResult<int>();
+  if (auto r = co_await mPool->run(*mReactor, [&, fd = mFd] { result = SysCall(::fsync, fd); }); !r) {
+    co_return make_unexpected(r.error());
+  } else if (!result) {
+    co_return make_unexpected(result.error());
+  }
+  co_return StdResult<void> {};
+}
+
+auto File::fdatasync() -> Task<StdResult<void>>
+{
+  assert(mFd != impl::INVALID_FD);
+  auto result = StdResult<int>();
+  if (auto r = co_await mPool->run(*mReactor, [&, fd = mFd] { result = SysCall(::fdatasync, fd); }); !r) {
+    co_return make_unexpected(r.error());
+  } else if (!result) {
+    co_return make_unexpected(result.error());
+  }
+  co_return StdResult<void> {};
+}
+
+auto File::size() const -> StdResult<off_t>
+{
+  struct stat st;
+  if (auto r = SysCall(::fstat, mFd, &st); !r) {
+    return make_unexpected(r.error());
+  }
+  return st.st_size;
+}
+} // namespace async
@@ -0,0 +1,114 @@
+#include <Async/IoScheduler.hpp>
+
+namespace async {
+auto IoScheduler::Create(Reactor& reactor, IoSchedulerOptions options) -> StdResult<std::unique_ptr<IoScheduler>>
+{
+  auto wake = EventFd::Create(reactor);
+  if (!wake) {
+    return make_unexpected(wake.error());
+  }
+  for (auto& weight : options.weights) {
+    weight = std::max<std::uint32_t>(weight, 1);
+  }
+  options.budget = std::max<std::size_t>(options.budget, 1);
+  auto scheduler = std::unique_ptr<IoScheduler>(new IoScheduler(options, std::move(wake).value()));
+  scheduler->mCredit = options.weights;
+  scheduler->mDispatcher = scheduler->dispatch();
+  scheduler->mDispatcher.handle.resume(); // runs up to its first wait on the eventfd
+  return scheduler;
+}
+
+IoScheduler::~IoScheduler()
+{
+  // still registered for the eventfd until mWake is destroyed after this, but this thread cannot poll in between
+  if (mDispatcher.handle) {
+    mDispatcher.handle.destroy();
+  }
+}
+
+auto IoScheduler::stats(IoClass ioClass) const -> IoClassStats
+{
+  auto lock = std::lock_guard(mMutex);
+  return mStats[std::size_t(ioClass)];
+}
+
+auto IoScheduler::queued(IoClass ioClass) const -> std::size_t
+{
+  auto lock = std::lock_guard(mMutex);
+  return mQueues[std::size_t(ioClass)].size();
+}
+
+auto IoScheduler::enqueue(IoClass ioClass, std::coroutine_handle<> handle) -> void
+{
+  auto lock = std::unique_lock(mMutex);
+  mQueues[std::size_t(ioClass)].push_back({handle, Clock::now()});
+  if (!std::exchange(mArmed, true)) {
+    lock.unlock();
+    auto r = mWake.notify();
+    assert(r);
+  }
+}
+
+auto IoScheduler::next() -> std::coroutine_handle<>
+{
+  auto lock = std::lock_guard(mMutex);
+  auto take = [&](std::size_t i) {
+    auto entry = mQueues[i].front();
+    mQueues[i].pop_front();
+    auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - entry.queued);
+    auto& stats = mStats[i];
+    stats.resumed++;
+    stats.totalDelay += delay;
+    stats.maxDelay = std::max(stats.maxDelay, delay);
+    return entry.handle;
+  };
+  if (mOptions.policy == IoSchedulerOptions::Policy::Strict) {
+    for (std::size_t i = 0; i < IoClassCount; i++) {
+      if (!mQueues[i].empty()) {
+        return take(i);
+      }
+    }
+    return {};
+  }
+  // a new round starts once every waiting class used up its credit
+  for (int round = 0; round < 2; round++) {
+    for (std::size_t i = 0; i < IoClassCount; i++) {
+      if (!mQueues[i].empty() && mCredit[i] != 0) {
+        mCredit[i]--;
+        return take(i);
+      }
+    }
+    mCredit = mOptions.weights;
+  }
+  return {};
+}
+
+auto IoScheduler::dispatch() -> Dispatcher
+{
+  while (true) {
+    co_await mWake.ready();
+    mWake.take();
+    {
+      auto lock = std::lock_guard(mMutex);
+      mArmed = false;
+    }
+    for (std::size_t i = 0; i < mOptions.budget; i++) {
+      auto handle = next();
+      if (!handle) {
+        break;
+      }
+      handle.resume();
+    }
+    auto lock = std::unique_lock(mMutex);
+    auto pending = false;
+    for (auto& queue : mQueues) {
+      pending = pending || !queue.empty();
+    }
+    if (pending && !std::exchange(mArmed, true)) { // go on after the reactor reported what became ready meanwhile
+      lock.unlock();
+      auto r = mWake.notify();
+      assert(r);
+    }
+  }
+}
+} // namespace async
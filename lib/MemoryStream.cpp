@@ -0,0 +1,66 @@
+#include <Async/MemoryStream.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace async {
+namespace detail {
+ByteRing::ByteRing(std::size_t capacity)
+    : mData(std::make_unique<std::byte[]>(std::bit_ceil(capacity))), mMask(std::bit_ceil(capacity) - 1)
+{
+}
+
+auto ByteRing::write(std::span<std::byte const> data) -> std::size_t
+{
+  auto tail = mTail.load(std::memory_order_relaxed);
+  auto head = mHead.load(std::memory_order_acquire);
+  auto n = std::min(data.size(), capacity() - (tail - head));
+  auto offset = tail & mMask;
+  auto first = std::min(n, capacity() - offset);
+  std::memcpy(mData.get() + offset, data.data(), first);
+  std::memcpy(mData.get(), data.data() + first, n - first);
+  mTail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+auto ByteRing::read(std::span<std::byte> data) -> std::size_t
+{
+  auto head = mHead.load(std::memory_order_relaxed);
+  auto tail = mTail.load(std::memory_order_acquire);
+  auto n = std::min(data.size(), tail - head);
+  auto offset = head & mMask;
+  auto first = std::min(n, capacity() - offset);
+  std::memcpy(data.data(), mData.get() + offset, first);
+  std::memcpy(data.data() + first, mData.get(), n - first);
+  mHead.store(head + n, std::memory_order_release);
+  return n;
+}
+} // namespace detail
+
+auto MemoryStream::Pair(Reactor& first, Reactor& second, std::size_t capacity)
+    -> StdResult<std::pair<MemoryStream, MemoryStream>>
+{
+  // channel(a, b) carries bytes from the end on reactor `a` to the end on reactor `b`
+  auto channel = [capacity](Reactor& a, Reactor& b) -> StdResult<std::shared_ptr<detail::MemoryChannel>> {
+    auto readerWake = EventFd::Create(b);
+    if (!readerWake) {
+      return make_unexpected(readerWake.error());
+    }
+    auto writerWake = EventFd::Create(a);
+    if (!writerWake) {
+      return make_unexpected(writerWake.error());
+    }
+    return std::make_shared<detail::MemoryChannel>(capacity, std::move(readerWake).value(),
+                                                   std::move(writerWake).value());
+  };
+  auto forward = channel(first, second);
+  if (!forward) {
+    return make_unexpected(forward.error());
+  }
+  auto backward = channel(second, first);
+  if (!backward) {
+    return make_unexpected(backward.error());
+  }
+  return std::pair {MemoryStream(backward.value(), forward.value()), MemoryStream(forward.value(), backward.value())};
+}
+} // namespace async
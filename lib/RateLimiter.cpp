@@ -0,0 +1,131 @@
+#include <Async/RateLimiter.hpp>
+
+#include <unordered_map>
+
+namespace async {
+namespace detail {
+struct TokenBucket {
+  mutable std::mutex mutex;
+  std::uint64_t rate;
+  std::uint64_t burst;
+  double tokens;
+  RateLimiter::Clock::time_point last = RateLimiter::Clock::now();
+
+  auto refill(RateLimiter::Clock::time_point now) -> void
+  {
+    if (now > last) {
+      auto elapsed = std::chrono::duration<double>(now - last).count();
+      tokens = std::min(double(burst), tokens + elapsed * double(rate));
+      last = now;
+    }
+  }
+};
+} // namespace detail
+
+namespace {
+constexpr std::uint64_t MinBurst = 16 << 10;
+constexpr std::size_t MinGrant = 16 << 10;
+
+auto DefaultBurst(std::uint64_t rate, std::uint64_t burst) -> std::uint64_t
+{
+  return burst != 0 ? burst : std::max(rate / 10, MinBurst);
+}
+
+struct Groups {
+  std::mutex mutex;
+  std::unordered_map<std::string, RateLimiter> limiters;
+};
+auto GetGroups() -> Groups&
+{
+  static auto groups = Groups {};
+  return groups;
+}
+} // namespace
+
+auto RateLimiter::Create(std::uint64_t bytesPerSecond, std::uint64_t burst) -> RateLimiter
+{
+  auto bucket = std::make_shared<detail::TokenBucket>();
+  bucket->rate = bytesPerSecond;
+  bucket->burst = DefaultBurst(bytesPerSecond, burst);
+  bucket->tokens = double(bucket->burst); // start full so new connections are not throttled right away
+  return RateLimiter(std::move(bucket));
+}
+
+auto RateLimiter::Group(std::string const& name, std::uint64_t bytesPerSecond, std::uint64_t burst) -> RateLimiter
+{
+  auto& groups = GetGroups();
+  auto lock = std::lock_guard(groups.mutex);
+  if (auto it = groups.limiters.find(name); it != groups.limiters.end()) {
+    it->second.setRate(bytesPerSecond, burst);
+    return it->second;
+  }
+  return groups.limiters.emplace(name, Create(bytesPerSecond, burst)).first->second;
+}
+
+auto RateLimiter::FindGroup(std::string const& name) -> std::optional<RateLimiter>
+{
+  auto& groups = GetGroups();
+  auto lock = std::lock_guard(groups.mutex);
+  if (auto it = groups.limiters.find(name); it != groups.limiters.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+auto RateLimiter::setRate(std::uint64_t bytesPerSecond, std::uint64_t burst) -> void
+{
+  assert(mBucket);
+  auto lock = std::lock_guard(mBucket->mutex);
+  mBucket->refill(Clock::now());
+  mBucket->rate = bytesPerSecond;
+  mBucket->burst = DefaultBurst(bytesPerSecond, burst);
+  mBucket->tokens = std::min(mBucket->tokens, double(mBucket->burst));
+}
+
+auto RateLimiter::rate() const -> std::uint64_t
+{
+  if (!mBucket) {
+    return 0;
+  }
+  auto lock = std::lock_guard(mBucket->mutex);
+  return mBucket->rate;
+}
+
+auto RateLimiter::burst() const -> std::uint64_t
+{
+  if (!mBucket) {
+    return 0;
+  }
+  auto lock = std::lock_guard(mBucket->mutex);
+  return mBucket->burst;
+}
+
+auto RateLimiter::take(std::size_t want, Clock::time_point now) -> Grant
+{
+  if (!mBucket) {
+    return {want, {}};
+  }
+  auto lock = std::lock_guard(mBucket->mutex);
+  if (mBucket->rate == 0) {
+    return {want, {}};
+  }
+  mBucket->refill(now);
+  auto needed = double(std::min({want, MinGrant, std::size_t(mBucket->burst)}));
+  if (mBucket->tokens >= needed) {
+    auto bytes = std::min(want, std::size_t(mBucket->tokens));
+    mBucket->tokens -= double(bytes);
+    return {bytes, {}};
+  }
+  auto wait = std::chrono::duration<double>((needed - mBucket->tokens) / double(mBucket->rate));
+  return {0, std::chrono::ceil<Clock::duration>(wait)};
+}
+
+auto RateLimiter::refund(std::size_t bytes) -> void
+{
+  if (!mBucket || bytes == 0) {
+    return;
+  }
+  auto lock = std::lock_guard(mBucket->mutex);
+  mBucket->tokens = std::min(double(mBucket->burst), mBucket->tokens + double(bytes));
+}
+} // namespace async
@@ -0,0 +1,619 @@
+#include <Async/Resolver.hpp>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <openssl/rand.h>
+#include <sstream>
+
+namespace async {
+namespace {
+constexpr std::uint16_t TypeA = 1;
+constexpr std::uint16_t TypeSoa = 6;
+constexpr std::uint16_t ClassIn = 1;
+constexpr std::uint16_t FlagResponse = 0x8000;
+constexpr std::uint16_t FlagTruncated = 0x0200;
+constexpr std::uint16_t FlagRecursionDesired = 0x0100;
+constexpr std::size_t UdpMessageSize = 512;
+
+auto Read16(std::span<std::byte const> msg, std::size_t pos) -> std::uint16_t
+{
+  return std::uint16_t(std::to_integer<std::uint16_t>(msg[pos]) << 8 | std::to_integer<std::uint16_t>(msg[pos + 1]));
+}
+auto Read32(std::span<std::byte const> msg, std::size_t pos) -> std::uint32_t
+{
+  return std::uint32_t(Read16(msg, pos)) << 16 | Read16(msg, pos + 2);
+}
+auto Write16(std::vector<std::byte>& out, std::uint16_t value) -> void
+{
+  out.push_back(std::byte(value >> 8));
+  out.push_back(std::byte(value & 0xff));
+}
+
+// Returns the position after the (possibly compressed) name starting at `pos`, or 0 if it runs past the message.
+auto SkipName(std::span<std::byte const> msg, std::size_t pos) -> std::size_t
+{
+  while (pos < msg.size()) {
+    auto len = std::to_integer<std::uint8_t>(msg[pos]);
+    if (len == 0) {
+      return pos + 1;
+    } else if ((len & 0xc0) == 0xc0) {
+      return pos + 2 <= msg.size() ? pos + 2 : 0;
+    } else if (len & 0xc0) {
+      return 0;
+    }
+    pos += 1 + len;
+  }
+  return 0;
+}
+
+auto ToLower(std::string_view name) -> std::string
+{
+  auto result = std::string(name);
+  std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+auto ParseIpv4(std::string_view text) -> std::optional<Ipv4Addr>
+{
+  char buf[INET_ADDRSTRLEN];
+  if (text.size() >= sizeof(buf)) {
+    return std::nullopt;
+  }
+  std::memcpy(buf, text.data(), text.size());
+  buf[text.size()] = '\0';
+  auto addr = in_addr {};
+  if (::inet_pton(AF_INET, buf, &addr) != 1) {
+    return std::nullopt;
+  }
+  auto result = Ipv4Addr {};
+  std::memcpy(result.addr, &addr, sizeof(result.addr));
+  return result;
+}
+
+// IDs come from the CSPRNG: a predictable sequence would let an off-path attacker forge answers (RFC 5452).
+auto NextQueryId() -> StdResult<std::uint16_t>
+{
+  auto id = std::uint16_t {};
+  if (::RAND_bytes(reinterpret_cast<unsigned char*>(&id), sizeof(id)) != 1) {
+    return make_unexpected(std::errc::io_error);
+  }
+  return id;
+}
+
+auto EqualIgnoreCase(std::byte a, std::byte b) -> bool
+{
+  return std::tolower(std::to_integer<unsigned char>(a)) == std::tolower(std::to_integer<unsigned char>(b));
+}
+} // namespace
+
+auto dns::BuildQuery(std::uint16_t id, std::string_view name, std::vector<std::byte>& out) -> StdResult<void>
+{
+  if (name.empty() || name.size() > 253) {
+    return make_unexpected(std::errc::invalid_argument);
+  }
+  Write16(out, id);
+  Write16(out, FlagRecursionDesired);
+  Write16(out, 1); // question
+  Write16(out, 0);
+  Write16(out, 0);
+  Write16(out, 0);
+  while (!name.empty()) {
+    auto label = name.substr(0, name.find('.'));
+    if (label.empty() || label.size() > 63) {
+      return make_unexpected(std::errc::invalid_argument);
+    }
+    out.push_back(std::byte(label.size()));
+    for (auto c : label) {
+      out.push_back(std::byte(c));
+    }
+    name.remove_prefix(std::min(name.size(), label.size() + 1));
+  }
+  out.push_back(std::byte {0});
+  Write16(out, TypeA);
+  Write16(out, ClassIn);
+  return {};
+}
+
+auto dns::ParseResponse(std::span<std::byte const> msg, std::span<std::byte const> query, Answer& answer)
+    -> StdResult<void>
+{
+  auto const malformed = make_unexpected(std::errc::bad_message);
+  if (msg.size() < 12 || query.size() < 12 || Read16(msg, 0) != Read16(query, 0) || !(Read16(msg, 2) & FlagResponse)) {
+    return malformed;
+  }
+  // the question comes back as it was asked, up to the case of its letters, which servers may change
+  auto question = query.subspan(12);
+  if (Read16(msg, 4) != 1 || msg.size() < 12 + question.size() ||
+      !std::equal(question.begin(), question.end(), msg.begin() + 12, EqualIgnoreCase)) {
+    return malformed;
+  }
+  auto flags = Read16(msg, 2);
+  answer.addrs.clear();
+  answer.ttl = 0;
+  answer.rcode = flags & 0x0f;
+  answer.truncated = flags & FlagTruncated;
+  if (answer.truncated) {
+    return {};
+  }
+  auto answers = Read16(msg, 6);
+  auto authorities = Read16(msg, 8);
+  auto pos = 12 + question.size();
+  auto minTtl = std::numeric_limits<std::uint32_t>::max();
+  for (auto i = 0; i < answers; i++) {
+    if (pos = SkipName(msg, pos); pos == 0 || pos + 10 > msg.size()) {
+      return malformed;
+    }
+    auto type = Read16(msg, pos);
+    auto klass = Read16(msg, pos + 2);
+    auto ttl = Read32(msg, pos + 4);
+    auto length = Read16(msg, pos + 8);
+    pos += 10;
+    if (pos + length > msg.size()) {
+      return malformed;
+    }
+    minTtl = std::min(minTtl, ttl);
+    if (type == TypeA && klass == ClassIn && length == 4) {
+      auto addr = Ipv4Addr {};
+      std::memcpy(addr.addr, msg.data() + pos, 4);
+      answer.addrs.push_back(addr);
+    }
+    pos += length;
+  }
+  if (!answer.addrs.empty()) {
+    answer.ttl = minTtl;
+    return {};
+  }
+  // negative answer: cache it for min(SOA TTL, SOA MINIMUM) as RFC 2308 says
+  for (auto i = 0; i < authorities; i++) {
+    if (pos = SkipName(msg, pos); pos == 0 || pos + 10 > msg.size()) {
+      return malformed;
+    }
+    auto type = Read16(msg, pos);
+    auto ttl = Read32(msg, pos + 4);
+    auto length = Read16(msg, pos + 8);
+    pos += 10;
+    if (pos + length > msg.size()) {
+      return malformed;
+    }
+    if (type == TypeSoa) {
+      auto p = SkipName(msg, pos);
+      p = p == 0 ? 0 : SkipName(msg, p);
+      if (p == 0 || p + 20 > pos + length) {
+        return malformed;
+      }
+      answer.ttl = std::min(ttl, Read32(msg, p + 16));
+      break;
+    }
+    pos += length;
+  }
+  return {};
+}
+
+auto ResolverOptions::FromResolvConf(std::filesystem::path const& path) -> ResolverOptions
+{
+  auto options = ResolverOptions {};
+  auto file = std::ifstream(path);
+  auto line = std::string();
+  while (std::getline(file, line)) {
+    line = line.substr(0, line.find_first_of("#;"));
+    auto words = std::istringstream(line);
+    auto keyword = std::string();
+    words >> keyword;
+    if (keyword == "nameserver") {
+      auto value = std::string();
+      words >> value;
+      if (auto addr = ParseIpv4(value); addr) {
+        options.nameservers.push_back(SocketAddrV4 {*addr, 53});
+      }
+    } else if (keyword == "options") {
+      for (auto option = std::string(); words >> option;) {
+        if (option.starts_with("timeout:")) {
+          options.timeout = std::chrono::seconds(std::max(1, std::atoi(option.c_str() + 8)));
+        } else if (option.starts_with("attempts:")) {
+          options.attempts = std::max(1, std::atoi(option.c_str() + 9));
+        }
+      }
+    }
+  }
+  if (options.nameservers.empty()) {
+    options.nameservers.push_back(SocketAddrV4::Localhost(53));
+  }
+  return options;
+}
+
+// The deadline of one attempt on `socket`. Once it passed, the dispatcher marks it expired and shuts the socket down,
+// which makes it readable and writable, so the attempt wakes from whatever it waits for and sees expired().
+class Resolver::Deadline {
+public:
+  explicit Deadline(Resolver& resolver) : mResolver(resolver) {}
+  Deadline(Deadline const&) = delete;
+  Deadline& operator=(Deadline const&) = delete;
+  ~Deadline()
+  {
+    auto lock = std::lock_guard(mResolver.mMutex);
+    if (mEntry != mResolver.mDeadlines.end()) {
+      mResolver.mDeadlines.erase(mEntry);
+    }
+  }
+
+  auto arm(impl::fd_t socket, std::chrono::milliseconds timeout) -> StdResult<void>
+  {
+    auto lock = std::lock_guard(mResolver.mMutex);
+    if (auto r = mResolver.startDispatcher(); !r) {
+      return r;
+    }
+    auto when = Clock::now() + timeout;
+    mSocket = socket;
+    mEntry = mResolver.mDeadlines.emplace(when, this);
+    mResolver.armBy(when);
+    return {};
+  }
+  auto expired() const -> bool
+  {
+    auto lock = std::lock_guard(mResolver.mMutex);
+    return mExpired;
+  }
+
+private:
+  friend class Resolver;
+
+  Resolver& mResolver;
+  impl::fd_t mSocket = impl::INVALID_FD;
+  std::multimap<Clock::time_point, Deadline*>::iterator mEntry = mResolver.mDeadlines.end();
+  bool mExpired = false;
+};
+
+Resolver::Resolver(Reactor& reactor, ResolverOptions options) : mReactor(reactor), mOptions(std::move(options))
+{
+  loadHosts();
+}
+
+Resolver::~Resolver()
+{
+  // still registered for the timer until mTimer is destroyed after this, but no lookup is left to poll for it
+  if (mDispatcher.handle) {
+    mDispatcher.handle.destroy();
+  }
+}
+
+auto Resolver::startDispatcher() -> StdResult<void>
+{
+  if (mDispatcher.handle) {
+    return {};
+  }
+  auto timer = TimerFd::Create(mReactor);
+  if (!timer) {
+    return make_unexpected(timer.error());
+  }
+  mTimer = std::move(timer).value();
+  mDispatcher = dispatch();
+  mDispatcher.handle.resume(); // runs up to its first wait on the timer, without taking the lock
+  return {};
+}
+
+auto Resolver::armBy(Clock::time_point when) -> void
+{
+  if (when < mArmedBy) {
+    mArmedBy = when;
+    auto r = mTimer.set(when - Clock::now()); // a deadline already passed expires right away
+    assert(r);
+  }
+}
+
+auto Resolver::dispatch() -> Dispatcher
+{
+  while (true) {
+    co_await mTimer.wait(); // a wakeup without an expiration only finds nothing to do
+    auto joined = std::vector<std::coroutine_handle<>>();
+    {
+      auto lock = std::lock_guard(mMutex);
+      auto now = Clock::now();
+      mArmedBy = Clock::time_point::max();
+      joined.swap(mJoined);
+      while (!mDeadlines.empty() && mDeadlines.begin()->first <= now) {
+        auto deadline = mDeadlines.begin()->second;
+        deadline->mExpired = true;
+        deadline->mEntry = mDeadlines.end();
+        ::shutdown(deadline->mSocket, SHUT_RDWR); // the attempt closes it only after dropping its deadline
+        mDeadlines.erase(mDeadlines.begin());
+      }
+      if (!mDeadlines.empty()) {
+        armBy(mDeadlines.begin()->first);
+      }
+    }
+    for (auto handle : joined) {
+      handle.resume();
+    }
+  }
+}
+
+auto Resolver::loadHosts() -> void
+{
+  auto file = std::ifstream(mOptions.hostsFile);
+  auto line = std::string();
+  while (std::getline(file, line)) {
+    auto words = std::istringstream(line.substr(0, line.find('#')));
+    auto address = std::string();
+    words >> address;
+    auto addr = ParseIpv4(address);
+    if (!addr) {
+      continue; // IPv6 entries are skipped, sockets are IPv4 only
+    }
+    for (auto name = std::string(); words >> name;) {
+      mHosts.try_emplace(ToLower(name), *addr);
+    }
+  }
+}
+
+auto Resolver::clearCache() -> void
+{
+  auto lock = std::lock_guard(mMutex);
+  mCache.clear();
+}
+
+auto Resolver::lookupCached(std::string const& key) -> std::optional<StdResult<std::vector<Ipv4Addr>>>
+{
+  if (auto it = mCache.find(key); it != mCache.end()) {
+    if (it->second.expiry > Clock::now()) {
+      if (it->second.addrs.empty()) {
+        return make_unexpected(std::errc::no_such_device_or_address);
+      }
+      return it->second.addrs;
+    }
+    mCache.erase(it);
+  }
+  return std::nullopt;
+}
+
+auto Resolver::store(std::string const& key, StdResult<dns::Answer> const& answer) -> StdResult<std::vector<Ipv4Addr>>
+{
+  if (!answer) {
+    return make_unexpected(answer.error()); // transport failures are not cached
+  }
+  auto ttl = std::chrono::seconds(answer->ttl);
+  if (answer->addrs.empty() && ttl.count() == 0) {
+    ttl = mOptions.negativeTtl;
+  }
+  ttl = std::min(ttl, mOptions.maxTtl);
+  if (ttl.count() > 0) {
+    if (mCache.size() >= mOptions.maxCacheEntries) {
+      auto now = Clock::now();
+      std::erase_if(mCache, [now](auto const& entry) { return entry.second.expiry <= now; });
+      if (mCache.size() >= mOptions.maxCacheEntries) {
+        mCache.erase(mCache.begin());
+      }
+    }
+    mCache.insert_or_assign(key, CacheEntry {answer->addrs, Clock::now() + ttl});
+  }
+  if (answer->addrs.empty()) {
+    return make_unexpected(std::errc::no_such_device_or_address);
+  }
+  return answer->addrs;
+}
+
+auto Resolver::resolve(std::string_view name) -> Task<StdResult<std::vector<Ipv4Addr>>>
+{
+  if (auto addr = ParseIpv4(name); addr) {
+    co_return std::vector {*addr};
+  }
+  auto key = ToLower(name);
+  if (key.ends_with('.')) {
+    key.pop_back();
+  }
+  if (auto it = mHosts.find(key); it != mHosts.end()) {
+    co_return std::vector {it->second};
+  }
+
+  auto inflight = std::shared_ptr<Inflight>();
+  {
+    auto lock = std::lock_guard(mMutex);
+    if (auto cached = lookupCached(key); cached) {
+      co_return std::move(*cached);
+    }
+    if (auto it = mInflight.find(key); it != mInflight.end()) {
+      inflight = it->second;
+    } else {
+      mInflight.emplace(key, std::make_shared<Inflight>());
+    }
+  }
+  if (inflight) { // somebody is already asking, wait for their answer
+    struct JoinAwaiter {
+      Resolver& self;
+      Inflight& inflight;
+      auto await_ready() noexcept -> bool { return false; }
+      auto await_suspend(std::coroutine_handle<> handle) -> bool
+      {
+        auto lock = std::lock_guard(self.mMutex);
+        if (inflight.result) {
+          return false;
+        }
+        inflight.waiters.push_back(handle);
+        return true;
+      }
+      auto await_resume() -> StdResult<std::vector<Ipv4Addr>> { return *inflight.result; }
+    };
+    co_return co_await JoinAwaiter {*this, *inflight};
+  }
+
+  auto answer = co_await query(key);
+  auto result = StdResult<std::vector<Ipv4Addr>>();
+  auto waiters = std::vector<std::coroutine_handle<>>();
+  {
+    auto lock = std::lock_guard(mMutex);
+    result = store(key, answer);
+    auto node = mInflight.extract(key);
+    node.mapped()->result = result;
+    waiters = std::move(node.mapped()->waiters);
+    // the dispatcher resumes them from the reactor; only if it cannot be started are they resumed from here
+    if (!waiters.empty() && startDispatcher()) {
+      mJoined.insert(mJoined.end(), waiters.begin(), waiters.end());
+      waiters.clear();
+      armBy(Clock::now());
+    }
+  }
+  for (auto waiter : waiters) {
+    waiter.resume();
+  }
+  co_return result;
+}
+
+auto Resolver::query(std::string const& name) -> Task<StdResult<dns::Answer>>
+{
+  auto id = NextQueryId();
+  if (!id) {
+    co_return make_unexpected(id.error());
+  }
+  auto packet = std::vector<std::byte>();
+  if (auto r = dns::BuildQuery(id.value(), name, packet); !r) {
+    co_return make_unexpected(r.error());
+  }
+  auto error = std::errc::timed_out;
+  for (auto attempt = 0; attempt < mOptions.attempts; attempt++) {
+    for (auto const& server : mOptions.nameservers) {
+      auto answer = co_await queryUdp(server, packet);
+      if (answer && answer->truncated) {
+        answer = co_await queryTcp(server, packet);
+      }
+      if (!answer) {
+        error = answer.error();
+      } else if (answer->rcode != dns::RcodeNoError && answer->rcode != dns::RcodeNameError) {
+        error = std::errc::io_error; // SERVFAIL, REFUSED...: try the next server
+      } else {
+        co_return answer;
+      }
+    }
+  }
+  co_return make_unexpected(error);
+}
+
+auto Resolver::queryUdp(SocketAddr const& server, std::span<std::byte const> packet) -> Task<StdResult<dns::Answer>>
+{
+  auto fd = impl::Socket::CreateDatagramNonBlock(server);
+  if (!fd) {
+    co_return make_unexpected(fd.error());
+  }
+  auto socket = Socket::Register(&mReactor, fd.value());
+  if (!socket) {
+    co_return make_unexpected(socket.error());
+  }
+  auto deadline = Deadline(*this); // declared after the socket, so it is dropped before the socket is closed
+  if (auto r = socket->getSocket().connect(server); !r) {
+    co_return make_unexpected(r.error());
+  } else if (auto r = deadline.arm(socket->getSocket().raw(), mOptions.timeout); !r) {
+    co_return make_unexpected(r.error());
+  } else if (auto r = socket->getSocket().sendNonBlock(packet, 0); !r) {
+    co_return make_unexpected(r.error());
+  }
+  auto buf = std::array<std::byte, UdpMessageSize> {};
+  auto answer = dns::Answer {};
+  while (!deadline.expired()) {
+    auto n = socket->getSocket().recvNonBlock(buf, 0);
+    if (!n) {
+      if (detail::WouldBlock(n.error())) {
+        co_await socket->readable();
+        continue;
+      }
+      co_return make_unexpected(n.error()); // e.g. ECONNREFUSED from an ICMP port unreachable
+    }
+    if (dns::ParseResponse(std::span(buf).first(n.value()), packet, answer)) {
+      co_return answer;
+    }
+    // a stray or spoofed datagram, keep waiting for ours
+  }
+  co_return make_unexpected(std::errc::timed_out);
+}
+
+auto Resolver::queryTcp(SocketAddr const& server, std::span<std::byte const> packet) -> Task<StdResult<dns::Answer>>
+{
+  auto socket = Socket::Create(&mReactor, server);
+  if (!socket) {
+    co_return make_unexpected(socket.error());
+  }
+  // one deadline covers connecting, sending the query and receiving the answer
+  auto deadline = Deadline(*this);
+  auto raw = socket->getSocket();
+  if (auto r = deadline.arm(raw.raw(), mOptions.timeout); !r) {
+    co_return make_unexpected(r.error());
+  }
+  if (auto r = raw.connect(server); !r) {
+    if (r.error() != std::errc::operation_in_progress) {
+      co_return make_unexpected(r.error());
+    }
+    co_await socket->writable();
+    if (deadline.expired()) {
+      co_return make_unexpected(std::errc::timed_out);
+    }
+  }
+  if (auto error = raw.getOption<int>(SOL_SOCKET, SO_ERROR); !error) {
+    co_return make_unexpected(error.error());
+  } else if (error.value() != 0) {
+    co_return make_unexpected(std::errc(error.value()));
+  }
+
+  auto request = std::vector<std::byte>();
+  Write16(request, std::uint16_t(packet.size()));
+  request.insert(request.end(), packet.begin(), packet.end());
+  for (auto pending = std::span<std::byte const>(request); !pending.empty();) {
+    auto n = raw.sendNonBlock(pending, MSG_NOSIGNAL);
+    if (n) {
+      pending = pending.subspan(n.value());
+      continue;
+    } else if (!detail::WouldBlock(n.error())) {
+      co_return make_unexpected(n.error());
+    }
+    co_await socket->writable();
+    if (deadline.expired()) {
+      co_return make_unexpected(std::errc::timed_out);
+    }
+  }
+  auto response = std::vector<std::byte>(2);
+  auto filled = std::size_t {0};
+  while (filled < response.size()) {
+    auto n = raw.recvNonBlock(std::span(response).subspan(filled), 0);
+    if (!n) {
+      if (!detail::WouldBlock(n.error())) {
+        co_return make_unexpected(n.error());
+      }
+      co_await socket->readable();
+      if (deadline.expired()) {
+        co_return make_unexpected(std::errc::timed_out);
+      }
+      continue;
+    } else if (n.value() == 0) {
+      co_return make_unexpected(deadline.expired() ? std::errc::timed_out : std::errc::connection_reset);
+    }
+    filled += n.value();
+    if (filled == 2 && response.size() == 2) {
+      response.resize(2 + Read16(response, 0));
+    }
+  }
+  auto answer = dns::Answer {};
+  if (auto r = dns::ParseResponse(std::span(response).subspan(2), packet, answer); !r) {
+    co_return make_unexpected(r.error());
+  }
+  co_return answer;
+}
+
+auto Resolver::connect(std::string_view host, std::uint16_t port) -> Task<StdResult<TcpStream>>
+{
+  auto addrs = co_await resolve(host);
+  if (!addrs) {
+    co_return make_unexpected(addrs.error());
+  }
+  auto error = std::errc::no_such_device_or_address;
+  for (auto addr : addrs.value()) {
+    auto target = SocketAddr(SocketAddrV4 {addr, port});
+    auto stream = co_await TcpStream::Connect(mReactor, target);
+    if (stream) {
+      co_return std::move(stream).value();
+    }
+    error = stream.error();
+  }
+  co_return make_unexpected(error);
+}
+} // namespace async
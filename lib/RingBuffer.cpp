@@ -0,0 +1,72 @@
+#include <Async/RingBuffer.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace async {
+namespace {
+constexpr std::size_t HugePageSize = 2 << 20;
+} // namespace
+
+auto RingBuffer::Create(std::size_t capacity, RingBufferOptions options) -> StdResult<RingBuffer>
+{
+  if (options.hugePages) {
+    if (auto ring = Map(std::bit_ceil(std::max(capacity, HugePageSize)), HugePageSize, true); ring) {
+      return ring;
+    }
+    // none reserved (vm.nr_hugepages) or none left: normal pages do
+  }
+  auto pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+  return Map(std::bit_ceil(std::max(capacity, pageSize)), pageSize, false);
+}
+
+auto RingBuffer::Map(std::size_t size, std::size_t pageSize, bool hugePages) -> StdResult<RingBuffer>
+{
+  auto flags = MFD_CLOEXEC | (hugePages ? MFD_HUGETLB | MFD_HUGE_2MB : 0U);
+  auto fd = SysCall(::memfd_create, "async-ring", flags);
+  if (!fd) {
+    return make_unexpected(fd.error());
+  }
+  struct FdGuard {
+    int fd;
+    ~FdGuard() { ::close(fd); } // the mappings keep the memory alive
+  } guard {fd.value()};
+  if (auto r = SysCall(::ftruncate, fd.value(), off_t(size)); !r) {
+    return make_unexpected(r.error());
+  }
+  // reserve address space for both views first, so nothing else can land between them, with room to align it
+  auto ring = RingBuffer();
+  ring.mReserved = 2 * size + pageSize;
+  ring.mReservation = ::mmap(nullptr, ring.mReserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ring.mReservation == MAP_FAILED) {
+    ring.mReservation = nullptr;
+    return make_unexpected(std::errc(errno));
+  }
+  auto address = (reinterpret_cast<std::uintptr_t>(ring.mReservation) + pageSize - 1) & ~(pageSize - 1);
+  ring.mData = reinterpret_cast<std::byte*>(address);
+  ring.mMask = size - 1;
+  ring.mHugePages = hugePages;
+  for (auto view : {ring.mData, ring.mData + size}) {
+    if (::mmap(view, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd.value(), 0) == MAP_FAILED) {
+      return make_unexpected(std::errc(errno)); // ring unmaps the reservation
+    }
+  }
+  return ring;
+}
+
+auto RingBuffer::reset() -> void
+{
+  if (mReservation != nullptr) {
+    ::munmap(mReservation, mReserved);
+  }
+  mReservation = nullptr;
+  mReserved = 0;
+  mData = nullptr;
+  mMask = 0;
+  mHead = mTail = 0;
+  mHugePages = false;
+}
+} // namespace async
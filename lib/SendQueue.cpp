@@ -0,0 +1,123 @@
+#include <Async/Detached.hpp>
+#include <Async/SendQueue.hpp>
+
+namespace async {
+namespace {
+struct Message {
+  Message* next;
+  std::vector<std::byte> data;
+};
+
+auto DeleteAll(Message* message) -> void
+{
+  while (message != nullptr) {
+    delete std::exchange(message, message->next);
+  }
+}
+} // namespace
+
+struct SendQueue::State {
+  explicit State(Socket& stream) : stream(stream) {}
+  State(State const&) = delete;
+  ~State()
+  {
+    DeleteAll(pending);
+    DeleteAll(queue.takeAll());
+  }
+
+  // Writes as the writer until `own` was sent, or until the queue runs dry when `own` is null.
+  static auto Drain(std::shared_ptr<State> self, Message* own) -> Task<StdResult<void>>;
+  // The drain that takes over from a sender whose message is out.
+  static auto Continue(std::shared_ptr<State> self) -> Task<>;
+
+  Socket& stream;
+  detail::MpscList<Message> queue;
+  std::atomic<bool> draining {false};
+  std::atomic<int> error {0};
+  // taken off `queue` and not fully sent yet, only touched by the writer
+  Message* pending = nullptr;
+  Message** tail = &pending;
+  std::size_t offset = 0; // bytes of `pending` already sent
+};
+
+SendQueue::SendQueue(Socket& stream) : mState(std::make_shared<State>(stream)) {}
+
+auto SendQueue::send(std::vector<std::byte> message) -> Task<StdResult<void>>
+{
+  auto& state = *mState;
+  if (auto error = state.error.load(std::memory_order_acquire); error != 0) {
+    co_return make_unexpected(std::errc(error));
+  }
+  auto own = new Message {nullptr, std::move(message)};
+  state.queue.push(own);
+  std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the writer's fence before it rechecks the queue
+  if (state.draining.exchange(true, std::memory_order_acquire)) {
+    // a writer that failed since the check above left `draining` set for good, and nobody will send the message
+    if (auto error = state.error.load(std::memory_order_acquire); error != 0) {
+      co_return make_unexpected(std::errc(error));
+    }
+    co_return StdResult<void> {}; // the current writer picks it up
+  }
+  co_return co_await State::Drain(mState, own);
+}
+
+auto SendQueue::State::Continue(std::shared_ptr<State> self) -> Task<>
+{
+  co_await self->stream.writable(); // lets the sender that handed over return first
+  co_await Drain(std::move(self), nullptr); // an error is kept in `error` for the next send
+}
+
+auto SendQueue::State::Drain(std::shared_ptr<State> self, Message* own) -> Task<StdResult<void>>
+{
+  auto& s = *self;
+  auto ownSent = false;
+  while (true) {
+    for (*s.tail = s.queue.takeAll(); *s.tail != nullptr;) {
+      s.tail = &(*s.tail)->next;
+    }
+    if (s.pending == nullptr) {
+      s.draining.store(false, std::memory_order_release);
+      // a message pushed after takeAll but before the store would otherwise wait for the next sender. Without the
+      // fence the load below may be ordered before the store, and both sides would leave the message to the other.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (s.queue.empty() || s.draining.exchange(true, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    if (ownSent) {
+      detail::Detach(Continue(std::move(self))).handle.resume();
+      break;
+    }
+
+    iovec iov[MaxBatch];
+    auto count = std::size_t(0);
+    for (auto m = s.pending; m != nullptr && count < MaxBatch; m = m->next, count++) {
+      auto skip = count == 0 ? s.offset : 0;
+      iov[count] = iovec {m->data.data() + skip, m->data.size() - skip};
+    }
+    auto n = co_await s.stream.sendv(std::span(iov, count));
+    if (!n) {
+      if (detail::WouldBlock(n.error())) {
+        continue;
+      }
+      // leave `draining` set so nobody writes after the failure, the state frees what is still queued
+      s.error.store(int(n.error()), std::memory_order_release);
+      co_return make_unexpected(n.error());
+    }
+    auto sent = std::size_t(n.value());
+    while (s.pending != nullptr && sent >= s.pending->data.size() - s.offset) {
+      sent -= s.pending->data.size() - s.offset;
+      s.offset = 0;
+      ownSent = ownSent || s.pending == own;
+      delete std::exchange(s.pending, s.pending->next);
+    }
+    if (s.pending == nullptr) {
+      s.tail = &s.pending;
+    } else {
+      s.offset += sent;
+    }
+  }
+  co_return StdResult<void> {};
+}
+} // namespace async
@@ -0,0 +1,185 @@
+#include <Async/Detached.hpp>
+#include <Async/WriteQueue.hpp>
+
+#include <coroutine>
+#include <mutex>
+#include <vector>
+
+namespace async {
+namespace {
+auto ResumeAll(std::vector<std::coroutine_handle<>> handles) -> void
+{
+  for (auto handle : handles) {
+    handle.resume();
+  }
+}
+} // namespace
+
+struct WriteQueue::State {
+  State(Socket& stream, WatermarkOptions options) : stream(stream), options(options) {}
+  State(State const&) = delete;
+
+  // Sends the queue until it is empty, or only its first batch when `handOff` is set, passing the rest to DrainRest().
+  static auto Drain(std::shared_ptr<State> self, bool handOff) -> Task<StdResult<void>>;
+  static auto DrainRest(std::shared_ptr<State> self) -> Task<>;
+  auto fail(std::errc error) -> void;
+
+  Socket& stream;
+  WatermarkOptions options;
+  std::mutex mutex;
+  std::vector<std::byte> pending;
+  std::vector<std::byte> sending; // the batch in flight, swapped with `pending` so both keep their capacity
+  std::size_t queued = 0;
+  bool draining = false;
+  std::optional<std::errc> error;
+  std::vector<std::coroutine_handle<>> writers;  // suspended above the high watermark
+  std::vector<std::coroutine_handle<>> flushers; // suspended in flush()
+};
+
+WriteQueue::WriteQueue(Socket& stream, WatermarkOptions options)
+    : mState(std::make_shared<State>(stream, options))
+{
+  assert(options.lowWatermark <= options.highWatermark);
+  if (options.notSentLowat) {
+    auto socketOptions = SocketOptions {};
+    socketOptions.notSentLowat = options.notSentLowat;
+    stream.setOptions(socketOptions); // best effort, unix sockets have no such option
+  }
+}
+
+auto WriteQueue::queued() const -> std::size_t
+{
+  auto lock = std::lock_guard(mState->mutex);
+  return mState->queued;
+}
+
+auto WriteQueue::write(std::span<std::byte const> data) -> Task<StdResult<void>>
+{
+  struct AdmitAwaiter {
+    State& s;
+    bool waited = false;
+    auto await_ready() noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      auto lock = std::lock_guard(s.mutex);
+      if (s.error || s.queued < s.options.highWatermark) {
+        return false;
+      }
+      s.writers.push_back(handle);
+      waited = true;
+      return true;
+    }
+    auto await_resume() noexcept -> bool { return waited; }
+  };
+  auto& s = *mState;
+  // a writer resumed at the low watermark checks again: those resumed before it may have filled the queue already
+  while (co_await AdmitAwaiter {s}) {
+  }
+
+  auto lock = std::unique_lock(s.mutex);
+  if (s.error) {
+    co_return make_unexpected(*s.error);
+  }
+  s.pending.insert(s.pending.end(), data.begin(), data.end());
+  s.queued += data.size();
+  if (s.draining) {
+    co_return StdResult<void> {};
+  }
+  s.draining = true;
+  lock.unlock();
+  co_return co_await State::Drain(mState, true);
+}
+
+auto WriteQueue::State::Drain(std::shared_ptr<State> self, bool handOff) -> Task<StdResult<void>>
+{
+  auto& s = *self;
+  // messages queued while a batch is in flight collect in `pending` for the next one
+  auto lock = std::unique_lock(s.mutex);
+  for (auto batches = 0; !s.pending.empty(); batches++) {
+    if (handOff && batches != 0) {
+      lock.unlock();
+      detail::Detach(DrainRest(std::move(self))).handle.resume();
+      co_return StdResult<void> {};
+    }
+    s.sending.swap(s.pending);
+    lock.unlock();
+    for (std::size_t sent = 0; sent < s.sending.size();) {
+      auto n = co_await s.stream.send(std::span(s.sending).subspan(sent));
+      if (!n) {
+        if (detail::WouldBlock(n.error())) {
+          continue;
+        }
+        s.sending.clear();
+        s.fail(n.error());
+        co_return make_unexpected(n.error());
+      }
+      sent += std::size_t(n.value());
+      auto writers = std::vector<std::coroutine_handle<>>();
+      {
+        auto guard = std::lock_guard(s.mutex);
+        s.queued -= std::size_t(n.value());
+        if (s.queued <= s.options.lowWatermark) {
+          writers.swap(s.writers);
+        }
+      }
+      ResumeAll(std::move(writers)); // they append to `pending` and return, this loop picks their data up
+    }
+    s.sending.clear();
+    lock.lock();
+  }
+  s.draining = false;
+  auto flushers = std::exchange(s.flushers, {});
+  lock.unlock();
+  ResumeAll(std::move(flushers));
+  co_return StdResult<void> {};
+}
+
+auto WriteQueue::State::DrainRest(std::shared_ptr<State> self) -> Task<>
+{
+  co_await self->stream.writable(); // lets the writer that handed over return first
+  co_await Drain(std::move(self), false); // an error reaches later writes and flushes through fail()
+}
+
+auto WriteQueue::flush() -> Task<StdResult<void>>
+{
+  struct DrainedAwaiter {
+    State& s;
+    auto await_ready() noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      auto lock = std::lock_guard(s.mutex);
+      if (!s.draining) {
+        return false;
+      }
+      s.flushers.push_back(handle);
+      return true;
+    }
+    auto await_resume() noexcept -> void {}
+  };
+  auto& s = *mState;
+  co_await DrainedAwaiter {s};
+
+  auto lock = std::lock_guard(s.mutex);
+  if (s.error) {
+    co_return make_unexpected(*s.error);
+  }
+  co_return StdResult<void> {};
+}
+
+auto WriteQueue::State::fail(std::errc error) -> void
+{
+  auto parkedWriters = std::vector<std::coroutine_handle<>>();
+  auto parkedFlushers = std::vector<std::coroutine_handle<>>();
+  {
+    auto lock = std::lock_guard(mutex);
+    this->error = error;
+    pending.clear();
+    queued = 0;
+    draining = false;
+    parkedWriters.swap(writers);
+    parkedFlushers.swap(flushers);
+  }
+  ResumeAll(std::move(parkedWriters));
+  ResumeAll(std::move(parkedFlushers));
+}
+} // namespace async
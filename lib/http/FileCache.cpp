@@ -0,0 +1,440 @@
+#include <Async/http/FileCache.hpp>
+
+#include <cctype>
+#include <charconv>
+#include <fcntl.h>
+#include <linux/openat2.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace async::http {
+namespace {
+constexpr auto WatchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+
+auto ContentTypeOf(std::string_view path) -> std::string_view
+{
+  constexpr std::pair<std::string_view, std::string_view> types[] = {
+      {".html", "text/html; charset=utf-8"},
+      {".htm", "text/html; charset=utf-8"},
+      {".css", "text/css; charset=utf-8"},
+      {".js", "text/javascript; charset=utf-8"},
+      {".json", "application/json"},
+      {".txt", "text/plain; charset=utf-8"},
+      {".svg", "image/svg+xml"},
+      {".png", "image/png"},
+      {".jpg", "image/jpeg"},
+      {".jpeg", "image/jpeg"},
+      {".gif", "image/gif"},
+      {".webp", "image/webp"},
+      {".ico", "image/x-icon"},
+      {".wasm", "application/wasm"},
+      {".woff2", "font/woff2"},
+  };
+  for (auto [ext, type] : types) {
+    if (path.ends_with(ext)) {
+      return type;
+    }
+  }
+  return "application/octet-stream";
+}
+
+auto FormatHttpDate(time_t time) -> std::string
+{
+  auto tm = std::tm {};
+  gmtime_r(&time, &tm);
+  char buf[32];
+  auto n = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return std::string(buf, n);
+}
+
+// Whether a segment of the relative `path` names a hidden file or directory.
+auto HasHiddenSegment(std::string_view path) -> bool
+{
+  return path.front() == '.' || path.find("/.") != std::string_view::npos;
+}
+
+auto SameStat(CachedFile const& file, struct stat const& st) -> bool
+{
+  return file.size == st.st_size && file.mtime.tv_sec == st.st_mtim.tv_sec &&
+         file.mtime.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+// Percent-decodes a request target path and rejects anything that could escape the document root. Empty segments are
+// rejected too, so "//etc/passwd" or "/%2Fetc/passwd" never turn into an absolute path.
+auto NormalizeTarget(std::string_view target, std::string& out) -> bool
+{
+  target = target.substr(0, target.find_first_of("?#"));
+  if (target.empty() || target.front() != '/') {
+    return false;
+  }
+  out.clear();
+  for (std::size_t i = 1; i < target.size(); i++) {
+    auto c = target[i];
+    if (c == '%') {
+      // from_chars alone would take a sign, so both digits are checked first
+      auto value = 0;
+      if (i + 2 >= target.size() || !std::isxdigit((unsigned char)target[i + 1]) ||
+          !std::isxdigit((unsigned char)target[i + 2])) {
+        return false;
+      }
+      std::from_chars(&target[i + 1], &target[i + 3], value, 16);
+      c = char(value);
+      i += 2;
+    }
+    if (c == '\0') {
+      return false;
+    }
+    out.push_back(c);
+  }
+  if (out.empty() || out.back() == '/') {
+    out.append("index.html");
+  }
+  for (std::size_t pos = 0; pos <= out.size();) {
+    auto next = out.find('/', pos);
+    auto segment = std::string_view(out).substr(pos, next - pos);
+    if (segment.empty() || segment == ".." || segment == ".") {
+      return false;
+    }
+    if (next == std::string::npos) {
+      break;
+    }
+    pos = next + 1;
+  }
+  return true;
+}
+
+// Opens `path` below the directory `root`. The kernel refuses to resolve outside of it or through symlinks, so a key
+// that slipped past NormalizeTarget still cannot reach other files. Where openat2 is missing (before 5.6) or blocked by
+// a seccomp filter, the path is walked one component at a time with O_NOFOLLOW instead.
+auto OpenBeneath(int root, char const* path) -> StdResult<int>
+{
+  auto how = open_how {.flags = O_RDONLY | O_CLOEXEC, .resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS};
+  auto fd = int(::syscall(SYS_openat2, root, path, &how, sizeof(how)));
+  if (fd != -1) {
+    return fd;
+  } else if (errno != ENOSYS && errno != EPERM) {
+    return make_unexpected(std::errc(errno));
+  }
+  auto rest = std::string_view(path);
+  auto dir = root;
+  while (true) {
+    auto slash = rest.find('/');
+    auto name = std::string(rest.substr(0, slash));
+    auto last = slash == std::string_view::npos;
+    auto next = StdResult<int>(make_unexpected(std::errc::no_such_file_or_directory));
+    if (!name.empty() && name != "." && name != "..") {
+      // O_DIRECTORY fails on a symlink opened with O_PATH | O_NOFOLLOW, so no component can be one
+      next = SysCall(::openat, dir, name.c_str(), O_CLOEXEC | O_NOFOLLOW | (last ? O_RDONLY : O_PATH | O_DIRECTORY));
+    }
+    if (dir != root) {
+      ::close(dir);
+    }
+    if (!next || last) {
+      return next;
+    }
+    dir = next.value();
+    rest.remove_prefix(slash + 1);
+  }
+}
+} // namespace
+
+CachedFile::~CachedFile()
+{
+  if (fd != impl::INVALID_FD) {
+    ::close(fd);
+  }
+}
+
+FileCache::FileCache(std::filesystem::path root, FileCacheOptions options)
+    : mRoot(std::move(root)), mOptions(options), mRootFd(::open(mRoot.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC)),
+      mInotify(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+  assert(mOptions.maxEntries > 0);
+}
+
+FileCache::~FileCache()
+{
+  if (mInotify != -1) {
+    ::close(mInotify);
+  }
+  if (mRootFd != -1) {
+    ::close(mRootFd);
+  }
+}
+
+auto FileCache::size() const -> std::size_t
+{
+  auto lock = std::lock_guard(mMutex);
+  return mLru.size();
+}
+
+auto FileCache::open(std::string_view path) -> StdResult<std::shared_ptr<CachedFile const>>
+{
+  if (path.empty() || path.front() == '/' || mRootFd == -1 || (!mOptions.allowHidden && HasHiddenSegment(path))) {
+    return make_unexpected(std::errc::no_such_file_or_directory);
+  }
+  auto lock = std::lock_guard(mMutex);
+  if (mInotify != -1) {
+    if (auto now = std::chrono::steady_clock::now(); now >= mNextDrain) {
+      drainEvents();
+      mNextDrain = now + mOptions.invalidateInterval;
+    }
+  }
+  if (auto it = mIndex.find(path); it != mIndex.end()) {
+    auto entry = it->second;
+    auto valid = true;
+    if (mInotify == -1) {
+      struct stat st;
+      valid = ::fstat(entry->file->fd, &st) == 0 && st.st_nlink != 0 && SameStat(*entry->file, st);
+    }
+    if (valid) {
+      mLru.splice(mLru.begin(), mLru, entry);
+      return entry->file;
+    }
+    erase(entry);
+  }
+  return load(std::string(path));
+}
+
+auto FileCache::load(std::string const& key) -> StdResult<std::shared_ptr<CachedFile const>>
+{
+  auto full = mRoot / key;
+  // watch before opening so a modification racing with the open still invalidates the entry
+  auto watch = mInotify == -1 ? -1 : ::inotify_add_watch(mInotify, full.c_str(), WatchMask);
+  auto dropWatch = [&] {
+    if (watch != -1 && mWatches.count(watch) == 0) {
+      ::inotify_rm_watch(mInotify, watch);
+    }
+  };
+  auto fd = OpenBeneath(mRootFd, key.c_str());
+  if (!fd) {
+    dropWatch();
+    return make_unexpected(fd.error());
+  }
+  auto file = std::make_shared<CachedFile>();
+  file->fd = fd.value();
+  struct stat st;
+  if (auto r = SysCall(::fstat, file->fd, &st); !r) {
+    dropWatch();
+    return make_unexpected(r.error());
+  } else if (!S_ISREG(st.st_mode)) {
+    dropWatch();
+    return make_unexpected(std::errc::no_such_file_or_directory);
+  }
+  file->size = st.st_size;
+  file->mtime = st.st_mtim;
+  file->contentType = ContentTypeOf(key);
+  file->lastModified = FormatHttpDate(st.st_mtim.tv_sec);
+  char etag[48];
+  auto n = std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"", (unsigned long long)st.st_size,
+                         (unsigned long long)st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec);
+  file->etag.assign(etag, n);
+  ::posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  if (mLru.size() >= mOptions.maxEntries) {
+    erase(std::prev(mLru.end()));
+  }
+  mLru.push_front(Entry {key, file, watch});
+  mIndex.emplace(mLru.front().key, mLru.begin());
+  if (watch != -1) {
+    mWatches.emplace(watch, mLru.begin());
+  }
+  return file;
+}
+
+auto FileCache::drainEvents() -> void
+{
+  alignas(inotify_event) char buf[4096];
+  while (true) {
+    auto n = ::read(mInotify, buf, sizeof(buf));
+    if (n <= 0) {
+      return;
+    }
+    for (auto p = buf; p < buf + n;) {
+      auto event = reinterpret_cast<inotify_event const*>(p);
+      p += sizeof(inotify_event) + event->len;
+      auto [first, last] = mWatches.equal_range(event->wd);
+      if (first == last) {
+        continue;
+      }
+      for (auto it = first; it != last; ++it) {
+        mIndex.erase(it->second->key);
+        mLru.erase(it->second);
+      }
+      mWatches.erase(first, last);
+      if (!(event->mask & IN_IGNORED)) { // IN_IGNORED means the kernel already dropped the watch
+        ::inotify_rm_watch(mInotify, event->wd);
+      }
+    }
+  }
+}
+
+auto FileCache::erase(std::list<Entry>::iterator entry) -> void
+{
+  mIndex.erase(entry->key);
+  if (entry->watch != -1) {
+    auto [first, last] = mWatches.equal_range(entry->watch);
+    auto shared = false;
+    for (auto it = first; it != last;) {
+      if (it->second == entry) {
+        it = mWatches.erase(it);
+      } else {
+        shared = true; // another path names the same inode
+        ++it;
+      }
+    }
+    if (!shared) {
+      ::inotify_rm_watch(mInotify, entry->watch);
+    }
+  }
+  mLru.erase(entry);
+}
+
+auto ParseRange(std::string_view value, off_t size) -> std::optional<ByteRange>
+{
+  if (!value.starts_with("bytes=") || value.find(',') != std::string_view::npos) {
+    return std::nullopt;
+  }
+  value.remove_prefix(6);
+  auto dash = value.find('-');
+  if (dash == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto parse = [](std::string_view s, off_t& out) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return !s.empty() && ec == std::errc {} && ptr == s.data() + s.size();
+  };
+  auto first = off_t {0};
+  auto last = off_t {0};
+  if (dash == 0) { // suffix range: the final N bytes
+    if (!parse(value.substr(1), last)) {
+      return std::nullopt;
+    } else if (last == 0 || size == 0) {
+      return ByteRange {0, 0};
+    }
+    last = std::min(last, size);
+    return ByteRange {size - last, last};
+  }
+  if (!parse(value.substr(0, dash), first)) {
+    return std::nullopt;
+  }
+  if (dash + 1 == value.size()) {
+    last = size - 1;
+  } else if (!parse(value.substr(dash + 1), last) || last < first) {
+    return std::nullopt;
+  }
+  if (first >= size) {
+    return ByteRange {0, 0};
+  }
+  last = std::min(last, size - 1);
+  return ByteRange {first, last - first + 1};
+}
+
+auto ParseHttpDate(std::string_view value) -> std::optional<time_t>
+{
+  // IMF-fixdate, then the obsolete RFC 850 and asctime forms recipients still have to accept
+  constexpr char const* formats[] = {"%a, %d %b %Y %H:%M:%S GMT", "%A, %d-%b-%y %H:%M:%S GMT", "%a %b %e %H:%M:%S %Y"};
+  char buf[64];
+  if (value.size() >= sizeof(buf)) {
+    return std::nullopt;
+  }
+  value.copy(buf, value.size());
+  buf[value.size()] = '\0';
+  for (auto format : formats) {
+    auto tm = std::tm {};
+    if (auto end = ::strptime(buf, format, &tm); end != nullptr && *end == '\0') {
+      return ::timegm(&tm);
+    }
+  }
+  return std::nullopt;
+}
+
+auto NoneMatchHits(std::string_view value, std::string_view etag) -> bool
+{
+  auto opaque = [](std::string_view tag) { return tag.starts_with("W/") ? tag.substr(2) : tag; };
+  auto trimmed = value.substr(std::min(value.find_first_not_of(" \t"), value.size()));
+  trimmed = trimmed.substr(0, trimmed.find_last_not_of(" \t") + 1);
+  if (trimmed == "*") {
+    return true;
+  }
+  etag = opaque(etag);
+  for (std::size_t pos = 0; pos < value.size();) {
+    pos = value.find_first_not_of(" \t,", pos);
+    if (pos == std::string_view::npos) {
+      break;
+    }
+    auto start = pos;
+    if (value.substr(pos).starts_with("W/")) {
+      pos += 2;
+    }
+    auto close = pos < value.size() && value[pos] == '"' ? value.find('"', pos + 1) : std::string_view::npos;
+    if (close == std::string_view::npos) {
+      return false;
+    }
+    if (opaque(value.substr(start, close + 1 - start)) == etag) {
+      return true;
+    }
+    pos = close + 1;
+  }
+  return false;
+}
+
+auto ServeFile(FileCache& cache, Request const& request, ResponseWriter& response) -> void
+{
+  auto head = request.method == "HEAD";
+  if (!head && request.method != "GET") {
+    response.status(405).header("Allow", "GET, HEAD").body({});
+    return;
+  }
+  thread_local auto path = std::string();
+  if (!NormalizeTarget(request.target, path)) {
+    response.status(400).body({});
+    return;
+  }
+  auto opened = cache.open(path);
+  if (!opened) {
+    auto code = opened.error() == std::errc::permission_denied ? 403 : 404;
+    response.status(code).body({});
+    return;
+  }
+  auto const& file = *opened.value();
+  auto inm = request.header("If-None-Match");
+  // If-Modified-Since is ignored when If-None-Match is present or it is not a valid date (RFC 9110 section 13.1.3)
+  auto ims = inm ? std::nullopt : request.header("If-Modified-Since");
+  auto since = ims ? ParseHttpDate(*ims) : std::nullopt;
+  if ((inm && NoneMatchHits(*inm, file.etag)) || (since && file.mtime.tv_sec <= *since)) {
+    response.status(304).header("ETag", file.etag).header("Last-Modified", file.lastModified).finishWithoutBody();
+    return;
+  }
+
+  auto range = ByteRange {0, file.size};
+  if (auto value = request.header("Range"); value) {
+    if (auto r = ParseRange(*value, file.size); r && r->length == 0) {
+      char buf[48];
+      auto n = std::snprintf(buf, sizeof(buf), "bytes */%lld", (long long)file.size);
+      response.status(416).header("Content-Range", {buf, std::size_t(n)}).body({});
+      return;
+    } else if (r) {
+      range = *r;
+      char buf[80];
+      auto n = std::snprintf(buf, sizeof(buf), "bytes %lld-%lld/%lld", (long long)range.first,
+                             (long long)(range.first + range.length - 1), (long long)file.size);
+      response.status(206).header("Content-Range", {buf, std::size_t(n)});
+    }
+  }
+  response.header("Content-Type", file.contentType)
+      .header("Last-Modified", file.lastModified)
+      .header("ETag", file.etag)
+      .header("Accept-Ranges", "bytes");
+  if (head || range.length == 0) {
+    response.finishHead(range.length);
+    return;
+  }
+  if (range.length >= (64 << 10)) {
+    // start readahead of large transfers now so sendfile rarely blocks on the page cache
+    ::posix_fadvise(file.fd, range.first, range.length, POSIX_FADV_WILLNEED);
+  }
+  response.sendfile({opened.value(), file.fd, range.first, std::size_t(range.length)});
+}
+} // namespace async::http
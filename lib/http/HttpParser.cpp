@@ -0,0 +1,305 @@
+#include <Async/http/HttpParser.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define ASYNC_HTTP_X86
+  #include <immintrin.h>
+#endif
+
+namespace async::http {
+namespace detail {
+auto EqualsIgnoreCase(std::string_view a, std::string_view b) -> bool
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return (x | 0x20) == (y | 0x20);
+         });
+}
+
+auto ContainsTokenIgnoreCase(std::string_view list, std::string_view token) -> bool
+{
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto item = list.substr(0, comma);
+    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+      item.remove_suffix(1);
+    }
+    if (EqualsIgnoreCase(item, token)) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+  return false;
+}
+} // namespace detail
+
+namespace {
+using detail::ContainsTokenIgnoreCase;
+using detail::EqualsIgnoreCase;
+
+constexpr auto MakeTokenTable()
+{
+  auto table = std::array<bool, 256> {};
+  for (auto c = '0'; c <= '9'; c++) {
+    table[c] = true;
+  }
+  for (auto c = 'a'; c <= 'z'; c++) {
+    table[c] = true;
+    table[c - 'a' + 'A'] = true;
+  }
+  for (auto c : std::string_view("!#$%&'*+-.^_`|~")) {
+    table[c] = true;
+  }
+  return table;
+}
+constexpr auto TokenTable = MakeTokenTable();
+
+auto IsToken(char c) -> bool { return TokenTable[static_cast<unsigned char>(c)]; }
+
+auto FindScalar(char const* first, char const* last, std::string_view ranges) -> char const*
+{
+  for (; first != last; first++) {
+    auto c = static_cast<unsigned char>(*first);
+    for (std::size_t i = 0; i + 1 < ranges.size(); i += 2) {
+      if (static_cast<unsigned char>(ranges[i]) <= c && c <= static_cast<unsigned char>(ranges[i + 1])) {
+        return first;
+      }
+    }
+  }
+  return last;
+}
+
+#ifdef ASYNC_HTTP_X86
+__attribute__((target("sse4.2"))) auto FindSse42(char const* first, char const* last, std::string_view ranges)
+    -> char const*
+{
+  assert(ranges.size() <= 16);
+  alignas(16) char buf[16] {};
+  std::memcpy(buf, ranges.data(), ranges.size());
+  auto const needle = _mm_load_si128(reinterpret_cast<__m128i const*>(buf));
+  auto const needleLen = int(ranges.size());
+  while (last - first >= 16) {
+    auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+    auto idx = _mm_cmpestri(needle, needleLen, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+    if (idx != 16) {
+      return first + idx;
+    }
+    first += 16;
+  }
+  return FindScalar(first, last, ranges);
+}
+
+__attribute__((target("avx2"))) auto FindAvx2(char const* first, char const* last, std::string_view ranges)
+    -> char const*
+{
+  assert(ranges.size() <= 16);
+  __m256i lo[8], hi[8];
+  auto const count = ranges.size() / 2;
+  for (std::size_t i = 0; i < count; i++) {
+    lo[i] = _mm256_set1_epi8(ranges[2 * i]);
+    hi[i] = _mm256_set1_epi8(ranges[2 * i + 1]);
+  }
+  while (last - first >= 32) {
+    auto chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+    auto hit = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < count; i++) {
+      // unsigned lo <= c <= hi, expressed with max/min since AVX2 has no unsigned byte compare
+      auto geLo = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, lo[i]), chunk);
+      auto leHi = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, hi[i]), chunk);
+      hit = _mm256_or_si256(hit, _mm256_and_si256(geLo, leHi));
+    }
+    if (auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(hit)); mask != 0) {
+      return first + __builtin_ctz(mask);
+    }
+    first += 32;
+  }
+  return FindSse42(first, last, ranges);
+}
+#endif
+
+using FindFn = char const* (*)(char const*, char const*, std::string_view);
+auto SelectFind() -> FindFn
+{
+#ifdef ASYNC_HTTP_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return FindAvx2;
+  } else if (__builtin_cpu_supports("sse4.2")) {
+    return FindSse42;
+  }
+#endif
+  return FindScalar;
+}
+
+// bytes that terminate a request target: CTLs, SP and DEL
+constexpr auto TargetDelims = std::string_view("\x00\x20\x7f\x7f", 4);
+// bytes that terminate a header value: CTLs other than HT, and DEL
+constexpr auto ValueDelims = std::string_view("\x00\x08\x0a\x1f\x7f\x7f", 6);
+
+// Consumes "\r\n" or a bare "\n" at p, returning the position after it or nullptr.
+auto SkipEol(char const* p, char const* end) -> char const*
+{
+  if (p != end && *p == '\r') {
+    p++;
+  }
+  if (p != end && *p == '\n') {
+    return p + 1;
+  }
+  return nullptr;
+}
+
+// Returns the length of the header block including the terminating blank line, or 0 if it is not complete yet.
+auto FindHeadEnd(std::string_view data, std::size_t from) -> std::size_t
+{
+  auto const begin = data.data();
+  auto const end = begin + data.size();
+  auto p = begin + from;
+  while (p < end) {
+    auto nl = static_cast<char const*>(std::memchr(p, '\n', end - p));
+    if (nl == nullptr) {
+      return 0;
+    }
+    auto next = nl + 1;
+    if (next < end && *next == '\n') {
+      return next + 1 - begin;
+    }
+    if (next + 1 < end && next[0] == '\r' && next[1] == '\n') {
+      return next + 2 - begin;
+    }
+    p = next;
+  }
+  return 0;
+}
+} // namespace
+
+auto detail::FindInRanges(char const* first, char const* last, std::string_view ranges) -> char const*
+{
+  static auto const find = SelectFind();
+  return find(first, last, ranges);
+}
+
+auto Request::header(std::string_view name) const -> std::optional<std::string_view>
+{
+  for (auto const& h : headers()) {
+    if (EqualsIgnoreCase(h.name, name)) {
+      return h.value;
+    }
+  }
+  return std::nullopt;
+}
+
+auto RequestParser::parse(std::string_view data, Request& request) -> ParseResult
+{
+  // the terminator may straddle the previous scan boundary
+  auto headLen = FindHeadEnd(data, mScanned > 3 ? mScanned - 3 : 0);
+  if (headLen == 0) {
+    mScanned = data.size();
+    return {data.size() > MaxHeadSize ? ParseStatus::Error : ParseStatus::Incomplete, 0};
+  }
+  mScanned = headLen;
+
+  auto p = data.data();
+  auto const end = data.data() + headLen;
+  auto const error = ParseResult {ParseStatus::Error, 0};
+
+  // request line
+  auto methodBegin = p;
+  while (p != end && IsToken(*p)) {
+    p++;
+  }
+  if (p == methodBegin || p == end || *p != ' ') {
+    return error;
+  }
+  request.method = {methodBegin, std::size_t(p - methodBegin)};
+  auto targetBegin = ++p;
+  p = detail::FindInRanges(p, end, TargetDelims);
+  if (p == targetBegin || p == end || *p != ' ') {
+    return error;
+  }
+  request.target = {targetBegin, std::size_t(p - targetBegin)};
+  p++;
+  if (end - p < 8 || std::memcmp(p, "HTTP/1.", 7) != 0 || (p[7] != '0' && p[7] != '1')) {
+    return error;
+  }
+  request.minorVersion = p[7] - '0';
+  if (p = SkipEol(p + 8, end); p == nullptr) {
+    return error;
+  }
+
+  // header fields
+  request.headerCount = 0;
+  while (true) {
+    if (auto q = SkipEol(p, end); q != nullptr) {
+      p = q;
+      break;
+    }
+    if (request.headerCount == Request::MaxHeaders) {
+      return error;
+    }
+    auto nameBegin = p;
+    while (p != end && IsToken(*p)) {
+      p++;
+    }
+    if (p == nameBegin || p == end || *p != ':') {
+      return error;
+    }
+    auto name = std::string_view(nameBegin, p - nameBegin);
+    p++;
+    while (p != end && (*p == ' ' || *p == '\t')) {
+      p++;
+    }
+    auto valueBegin = p;
+    p = detail::FindInRanges(p, end, ValueDelims);
+    auto valueEnd = p;
+    while (valueEnd != valueBegin && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+      valueEnd--;
+    }
+    if (p = SkipEol(p, end); p == nullptr) {
+      return error;
+    }
+    request.headerStorage[request.headerCount++] = {name, {valueBegin, std::size_t(valueEnd - valueBegin)}};
+  }
+  assert(p == end);
+
+  request.keepAlive = request.minorVersion == 1;
+  request.contentLength = 0;
+  auto hasLength = false;
+  for (auto const& h : request.headers()) {
+    if (EqualsIgnoreCase(h.name, "content-length")) {
+      auto length = request.contentLength;
+      auto [ptr, ec] = std::from_chars(h.value.data(), h.value.data() + h.value.size(), length);
+      if (ec != std::errc {} || ptr != h.value.data() + h.value.size() || length > MaxBodySize) {
+        return error;
+      } else if (hasLength && length != request.contentLength) {
+        return error; // conflicting lengths would let a proxy and this server split the stream differently
+      }
+      request.contentLength = length;
+      hasLength = true;
+    } else if (EqualsIgnoreCase(h.name, "transfer-encoding")) {
+      return error; // chunked request bodies are not supported
+    } else if (EqualsIgnoreCase(h.name, "connection")) {
+      if (ContainsTokenIgnoreCase(h.value, "close")) {
+        request.keepAlive = false;
+      } else if (ContainsTokenIgnoreCase(h.value, "keep-alive")) {
+        request.keepAlive = true;
+      }
+    }
+  }
+
+  if (data.size() - headLen < request.contentLength) {
+    return {ParseStatus::Incomplete, 0};
+  }
+  request.body = data.substr(headLen, request.contentLength);
+  mScanned = 0;
+  return {ParseStatus::Complete, headLen + request.contentLength};
+}
+} // namespace async::http
@@ -0,0 +1,350 @@
+#include <Async/http/WebSocket.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define ASYNC_WS_X86
+  #include <immintrin.h>
+#endif
+
+namespace async::http::ws {
+namespace {
+constexpr auto Guid = std::string_view("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+
+// `key` starts at the mask byte for data[0]
+auto MaskScalar(std::byte* data, std::size_t size, std::array<std::byte, 4> key) -> void
+{
+  auto i = std::size_t {0};
+  if (size >= 8) {
+    std::byte pattern[8];
+    for (std::size_t j = 0; j < 8; j++) {
+      pattern[j] = key[j % 4];
+    }
+    auto word = std::uint64_t {};
+    std::memcpy(&word, pattern, 8);
+    for (; i + 8 <= size; i += 8) {
+      auto chunk = std::uint64_t {};
+      std::memcpy(&chunk, data + i, 8);
+      chunk ^= word;
+      std::memcpy(data + i, &chunk, 8);
+    }
+  }
+  for (; i < size; i++) {
+    data[i] ^= key[i % 4];
+  }
+}
+
+#ifdef ASYNC_WS_X86
+__attribute__((target("sse2"))) auto MaskSse2(std::byte* data, std::size_t size, std::array<std::byte, 4> key)
+    -> void
+{
+  auto word = std::int32_t {};
+  std::memcpy(&word, key.data(), 4);
+  auto const pattern = _mm_set1_epi32(word);
+  auto i = std::size_t {0};
+  for (; i + 16 <= size; i += 16) {
+    auto p = reinterpret_cast<__m128i*>(data + i);
+    _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), pattern));
+  }
+  MaskScalar(data + i, size - i, key); // i is a multiple of 4, so the key lines up
+}
+
+__attribute__((target("avx2"))) auto MaskAvx2(std::byte* data, std::size_t size, std::array<std::byte, 4> key)
+    -> void
+{
+  auto word = std::int32_t {};
+  std::memcpy(&word, key.data(), 4);
+  auto const pattern = _mm256_set1_epi32(word);
+  auto i = std::size_t {0};
+  for (; i + 64 <= size; i += 64) {
+    auto p = reinterpret_cast<__m256i*>(data + i);
+    auto a = _mm256_xor_si256(_mm256_loadu_si256(p), pattern);
+    auto b = _mm256_xor_si256(_mm256_loadu_si256(p + 1), pattern);
+    _mm256_storeu_si256(p, a);
+    _mm256_storeu_si256(p + 1, b);
+  }
+  for (; i + 32 <= size; i += 32) {
+    auto p = reinterpret_cast<__m256i*>(data + i);
+    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), pattern));
+  }
+  MaskSse2(data + i, size - i, key);
+}
+#endif
+
+using MaskFn = void (*)(std::byte*, std::size_t, std::array<std::byte, 4>);
+auto SelectMask() -> MaskFn
+{
+#ifdef ASYNC_WS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return MaskAvx2;
+  } else if (__builtin_cpu_supports("sse2")) {
+    return MaskSse2;
+  }
+#endif
+  return MaskScalar;
+}
+
+auto Base64(std::span<unsigned char const> data) -> std::string
+{
+  auto out = std::string(4 * ((data.size() + 2) / 3), '\0');
+  EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()), data.data(), int(data.size()));
+  return out;
+}
+} // namespace
+
+auto EncodeHeader(FrameHeader const& header, std::span<std::byte, MaxHeaderSize> out) -> std::size_t
+{
+  out[0] = std::byte((header.fin ? 0x80 : 0) | std::uint8_t(header.opcode));
+  auto const maskBit = header.masked ? 0x80 : 0;
+  auto size = std::size_t {2};
+  if (header.length < 126) {
+    out[1] = std::byte(maskBit | header.length);
+  } else if (header.length <= 0xffff) {
+    out[1] = std::byte(maskBit | 126);
+    out[2] = std::byte(header.length >> 8);
+    out[3] = std::byte(header.length);
+    size = 4;
+  } else {
+    out[1] = std::byte(maskBit | 127);
+    for (int i = 0; i < 8; i++) {
+      out[2 + i] = std::byte(header.length >> (56 - 8 * i));
+    }
+    size = 10;
+  }
+  if (header.masked) {
+    std::memcpy(out.data() + size, header.mask.data(), 4);
+    size += 4;
+  }
+  return size;
+}
+
+auto DecodeHeader(std::span<std::byte const> data, FrameHeader& header) -> ParseResult
+{
+  constexpr auto incomplete = ParseResult {ParseStatus::Incomplete, 0};
+  constexpr auto error = ParseResult {ParseStatus::Error, 0};
+  if (data.size() < 2) {
+    return incomplete;
+  }
+  auto const b0 = std::uint8_t(data[0]);
+  auto const b1 = std::uint8_t(data[1]);
+  if (b0 & 0x70) { // RSV1-3, no extension is negotiated
+    return error;
+  }
+  header.fin = b0 & 0x80;
+  header.opcode = Opcode(b0 & 0x0f);
+  header.masked = b1 & 0x80;
+  auto const control = (b0 & 0x08) != 0;
+  switch (header.opcode) {
+  case Opcode::Continuation:
+  case Opcode::Text:
+  case Opcode::Binary:
+  case Opcode::Close:
+  case Opcode::Ping:
+  case Opcode::Pong:
+    break;
+  default:
+    return error;
+  }
+  auto size = std::size_t {2};
+  header.length = b1 & 0x7f;
+  if (control && (!header.fin || header.length > MaxControlPayload)) {
+    return error;
+  }
+  if (header.length == 126) {
+    if (data.size() < 4) {
+      return incomplete;
+    }
+    header.length = std::uint64_t(data[2]) << 8 | std::uint64_t(data[3]);
+    size = 4;
+  } else if (header.length == 127) {
+    if (data.size() < 10) {
+      return incomplete;
+    }
+    header.length = 0;
+    for (int i = 0; i < 8; i++) {
+      header.length = header.length << 8 | std::uint64_t(data[2 + i]);
+    }
+    if (header.length >> 63) {
+      return error;
+    }
+    size = 10;
+  }
+  if (header.masked) {
+    if (data.size() < size + 4) {
+      return incomplete;
+    }
+    std::memcpy(header.mask.data(), data.data() + size, 4);
+    size += 4;
+  }
+  return {ParseStatus::Complete, size};
+}
+
+auto ApplyMask(std::span<std::byte> data, std::array<std::byte, 4> mask, std::size_t offset) -> void
+{
+  static auto const apply = SelectMask();
+  auto key = std::array<std::byte, 4> {};
+  for (std::size_t i = 0; i < 4; i++) {
+    key[i] = mask[(offset + i) % 4];
+  }
+  apply(data.data(), data.size(), key);
+}
+
+auto ValidUtf8(std::span<std::byte const> data) -> bool
+{
+  auto p = reinterpret_cast<unsigned char const*>(data.data());
+  auto end = p + data.size();
+  while (p != end) {
+    // ascii runs go 8 bytes at a time
+    while (end - p >= 8) {
+      auto word = std::uint64_t {};
+      std::memcpy(&word, p, 8);
+      if ((word & 0x8080808080808080) != 0) {
+        break;
+      }
+      p += 8;
+    }
+    if (p == end) {
+      break;
+    }
+    auto lead = *p;
+    if (lead < 0x80) {
+      p++;
+      continue;
+    }
+    // the sequence length and the range of the second byte, which rules out overlong forms, surrogates and code
+    // points past U+10FFFF (RFC 3629 section 4)
+    auto size = std::size_t {0};
+    auto low = std::uint8_t {0x80}, high = std::uint8_t {0xbf};
+    if (lead >= 0xc2 && lead <= 0xdf) {
+      size = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+      size = 3;
+      low = lead == 0xe0 ? 0xa0 : 0x80;
+      high = lead == 0xed ? 0x9f : 0xbf;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+      size = 4;
+      low = lead == 0xf0 ? 0x90 : 0x80;
+      high = lead == 0xf4 ? 0x8f : 0xbf;
+    } else {
+      return false;
+    }
+    if (std::size_t(end - p) < size || p[1] < low || p[1] > high) {
+      return false;
+    }
+    for (std::size_t i = 2; i < size; i++) {
+      if ((p[i] & 0xc0) != 0x80) {
+        return false;
+      }
+    }
+    p += size;
+  }
+  return true;
+}
+
+auto ValidCloseCode(std::uint16_t code) -> bool
+{
+  return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) || (code >= 3000 && code <= 4999);
+}
+
+auto AcceptKey(std::string_view key) -> std::string
+{
+  auto input = std::string(key);
+  input.append(Guid);
+  unsigned char digest[SHA_DIGEST_LENGTH];
+  SHA1(reinterpret_cast<unsigned char const*>(input.data()), input.size(), digest);
+  return Base64(digest);
+}
+
+auto UpgradeKey(Request const& request) -> std::optional<std::string_view>
+{
+  auto upgrade = request.header("Upgrade");
+  auto connection = request.header("Connection");
+  auto version = request.header("Sec-WebSocket-Version");
+  auto key = request.header("Sec-WebSocket-Key");
+  if (request.method != "GET" || !upgrade || !detail::ContainsTokenIgnoreCase(*upgrade, "websocket") || !connection ||
+      !detail::ContainsTokenIgnoreCase(*connection, "upgrade") || version != "13" || !key || key->size() != 24) {
+    return std::nullopt;
+  }
+  return key;
+}
+
+auto WriteUpgradeResponse(std::string& out, std::string_view key) -> void
+{
+  out.append("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ")
+      .append(AcceptKey(key))
+      .append("\r\n\r\n");
+}
+
+auto WriteUpgradeRequest(std::string& out, std::string_view host, std::string_view path) -> StdResult<std::string>
+{
+  unsigned char nonce[16];
+  if (::RAND_bytes(nonce, sizeof(nonce)) != 1) {
+    return make_unexpected(std::errc::io_error);
+  }
+  auto key = Base64(nonce);
+  out.append("GET ")
+      .append(path)
+      .append(" HTTP/1.1\r\nHost: ")
+      .append(host)
+      .append("\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: ")
+      .append(key)
+      .append("\r\nSec-WebSocket-Version: 13\r\n\r\n");
+  return AcceptKey(key);
+}
+
+auto ParseUpgradeResponse(std::string_view data, std::string_view accept) -> ParseResult
+{
+  constexpr auto error = ParseResult {ParseStatus::Error, 0};
+  auto end = data.find("\r\n\r\n");
+  if (end == std::string_view::npos) {
+    return {data.size() > RequestParser::MaxHeadSize ? ParseStatus::Error : ParseStatus::Incomplete, 0};
+  }
+  auto head = data.substr(0, end + 2);
+  auto line = head.substr(0, head.find("\r\n"));
+  if (!line.starts_with("HTTP/1.1 101")) {
+    return error;
+  }
+  auto upgraded = false;
+  auto connection = false;
+  auto accepted = false;
+  for (head.remove_prefix(line.size() + 2); !head.empty();) {
+    line = head.substr(0, head.find("\r\n"));
+    head.remove_prefix(line.size() + 2);
+    auto colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      return error;
+    }
+    auto name = line.substr(0, colon);
+    auto value = line.substr(colon + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+      value.remove_suffix(1);
+    }
+    if (detail::EqualsIgnoreCase(name, "upgrade")) {
+      upgraded = detail::ContainsTokenIgnoreCase(value, "websocket");
+    } else if (detail::EqualsIgnoreCase(name, "connection")) {
+      connection = detail::ContainsTokenIgnoreCase(value, "upgrade");
+    } else if (detail::EqualsIgnoreCase(name, "sec-websocket-accept")) {
+      accepted = value == accept;
+    }
+  }
+  if (!upgraded || !connection || !accepted) {
+    return error;
+  }
+  return {ParseStatus::Complete, end + 4};
+}
+
+auto NewMask() -> StdResult<std::array<std::byte, 4>>
+{
+  auto mask = std::array<std::byte, 4> {};
+  if (::RAND_bytes(reinterpret_cast<unsigned char*>(mask.data()), int(mask.size())) != 1) {
+    return make_unexpected(std::errc::io_error);
+  }
+  return mask;
+}
+} // namespace async::http::ws
@@ -1,11 +1,25 @@
 #include <Async/sys/unix/Socket.hpp>
 
+#include <cstddef>
+#include <cstring>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+
+#ifndef SO_PREFER_BUSY_POLL
+  #define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+  #define SO_BUSY_POLL_BUDGET 70
+#endif
+
 namespace async::impl {
 auto Socket::Create(async::SocketAddr const& addr, int ty) -> StdResult<Socket>
 {
   if (addr.isIpv4()) {
     return SysCall(::socket, AF_INET, ty | SOCK_STREAM, 0).map([](auto fd) { return Socket(fd); });
   } else if (addr.isIpv6()) {
+  } else if (addr.isUnix()) {
+    return SysCall(::socket, AF_UNIX, ty | SOCK_STREAM, 0).map([](auto fd) { return Socket(fd); });
   }
   assert(0 && "unimplemented");
   return {};
@@ -14,6 +28,104 @@ auto Socket::CreateNonBlock(async::SocketAddr const& addr) -> StdResult<Socket>
 {
   return Socket::Create(addr, SOCK_NONBLOCK | SOCK_CLOEXEC);
 }
+auto Socket::CreateDatagramNonBlock(async::SocketAddr const& addr) -> StdResult<Socket>
+{
+  if (addr.isIpv4()) {
+    return SysCall(::socket, AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0).map([](auto fd) {
+      return Socket(fd);
+    });
+  }
+  return make_unexpected(std::errc::address_family_not_supported); // SocketAddrToSockAddr only knows IPv4 and unix
+}
+
+auto Socket::applyListenerOptions(SocketOptions const& options) -> StdResult<void>
+{
+  if (options.reusePort) {
+    if (auto r = setOption(SOL_SOCKET, SO_REUSEPORT, 1); !r) {
+      return r;
+    }
+  }
+  if (options.recvBuffer) {
+    if (auto r = setOption(SOL_SOCKET, SO_RCVBUF, *options.recvBuffer); !r) {
+      return r;
+    }
+  }
+  if (options.deferAccept) {
+    if (auto r = setOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, int(options.deferAccept->count())); !r) {
+      return r;
+    }
+  }
+  if (options.fastOpenQueue) {
+    if (auto r = setOption(IPPROTO_TCP, TCP_FASTOPEN, *options.fastOpenQueue); !r) {
+      return r;
+    }
+  }
+  return {};
+}
+
+auto Socket::applyStreamOptions(SocketOptions const& options) -> StdResult<void>
+{
+  auto setIf = [this](auto const& value, int level, int name) -> StdResult<void> {
+    return value ? setOption(level, name, int(*value)) : StdResult<void> {};
+  };
+  if (auto r = setIf(options.noDelay, IPPROTO_TCP, TCP_NODELAY); !r) {
+    return r;
+  } else if (auto r = setIf(options.quickAck, IPPROTO_TCP, TCP_QUICKACK); !r) {
+    return r;
+  } else if (auto r = setIf(options.sendBuffer, SOL_SOCKET, SO_SNDBUF); !r) {
+    return r;
+  } else if (auto r = setIf(options.recvBuffer, SOL_SOCKET, SO_RCVBUF); !r) {
+    return r;
+  } else if (auto r = setIf(options.notSentLowat, IPPROTO_TCP, TCP_NOTSENT_LOWAT); !r) {
+    return r;
+  } else if (auto r = setIf(options.busyPollBudget, SOL_SOCKET, SO_BUSY_POLL_BUDGET); !r) {
+    return r;
+  }
+  if (options.tos) { // before SO_PRIORITY, IP_TOS resets the priority to one derived from the TOS
+    auto domain = getOption<int>(SOL_SOCKET, SO_DOMAIN);
+    if (!domain) {
+      return make_unexpected(domain.error());
+    } else if (domain.value() == AF_INET || domain.value() == AF_INET6) {
+      auto r = domain.value() == AF_INET ? setOption(IPPROTO_IP, IP_TOS, *options.tos)
+                                         : setOption(IPPROTO_IPV6, IPV6_TCLASS, *options.tos);
+      if (!r) {
+        return r;
+      }
+    }
+  }
+  if (auto r = setIf(options.priority, SOL_SOCKET, SO_PRIORITY); !r) {
+    return r;
+  }
+  if (options.busyPoll) {
+    if (auto r = setOption(SOL_SOCKET, SO_BUSY_POLL, int(options.busyPoll->count())); !r) {
+      return r;
+    }
+  }
+  if (options.preferBusyPoll) {
+    if (auto r = setOption(SOL_SOCKET, SO_PREFER_BUSY_POLL, 1); !r) {
+      return r;
+    }
+  }
+  if (options.maxPacingRate) { // 32 bits on older kernels, ~0U disables pacing
+    auto rate = unsigned(std::min<std::uint64_t>(*options.maxPacingRate, ~0U - 1));
+    if (auto r = setOption(SOL_SOCKET, SO_MAX_PACING_RATE, rate); !r && r.error() != std::errc::no_protocol_option) {
+      return r;
+    }
+  }
+  if (options.keepAlive) {
+    auto& keepAlive = *options.keepAlive;
+    if (auto r = setOption(SOL_SOCKET, SO_KEEPALIVE, 1); !r) {
+      return r;
+    } else if (auto r = setOption(IPPROTO_TCP, TCP_KEEPIDLE, int(keepAlive.idle.count())); !r) {
+      return r;
+    } else if (auto r = setOption(IPPROTO_TCP, TCP_KEEPINTVL, int(keepAlive.interval.count())); !r) {
+      return r;
+    } else if (auto r = setOption(IPPROTO_TCP, TCP_KEEPCNT, keepAlive.count); !r) {
+      return r;
+    }
+  }
+  return {};
+}
 
 auto SocketAddrToSockAddr(SocketAddr const& addr, impl::sockaddr_storage* storage, impl::socketlen_t* len)
     -> StdResult<void>
@@ -26,6 +138,20 @@ auto SocketAddrToSockAddr(SocketAddr const& addr, impl::sockaddr_storage* storag
     v4Storage->sin_addr.s_addr = *reinterpret_cast<uint32_t const*>(v4.addr.addr);
     *len = sizeof(sockaddr_in);
     return {};
+  } else if (addr.isUnix()) {
+    auto& un = addr.getUnix();
+    auto unStorage = reinterpret_cast<sockaddr_un*>(storage);
+    unStorage->sun_family = AF_UNIX;
+    if (un.abstract) { // abstract names start with a NUL byte and are not NUL terminated
+      unStorage->sun_path[0] = '\0';
+      std::memcpy(unStorage->sun_path + 1, un.path, un.length);
+      *len = offsetof(sockaddr_un, sun_path) + 1 + un.length;
+    } else {
+      std::memcpy(unStorage->sun_path, un.path, un.length);
+      unStorage->sun_path[un.length] = '\0';
+      *len = offsetof(sockaddr_un, sun_path) + un.length + 1;
+    }
+    return {};
   } else {
     assert(0 && "unimplemented");
     return {};
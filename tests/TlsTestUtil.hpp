@@ -0,0 +1,24 @@
+#pragma once
+#include <Async/TlsContext.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+// Self-signed P-256 certificate for localhost, so the TLS tests and benchmarks need no files.
+inline auto UseSelfSigned(async::TlsContext& ctx) -> bool
+{
+  auto key = EVP_EC_gen("P-256");
+  auto cert = X509_new();
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+  X509_set_pubkey(cert, key);
+  auto name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (unsigned char const*)"localhost", -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  auto ok = X509_sign(cert, key, EVP_sha256()) > 0 && SSL_CTX_use_certificate(ctx.raw(), cert) == 1 &&
+            SSL_CTX_use_PrivateKey(ctx.raw(), key) == 1;
+  X509_free(cert);
+  EVP_PKEY_free(key);
+  return ok;
+}
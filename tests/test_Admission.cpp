@@ -0,0 +1,164 @@
+#include <Async/Executor.hpp>
+#include <Async/TcpListener.hpp>
+#include <Async/TimerFd.hpp>
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+// Blocking client connection; the listener's backlog completes it before accept.
+auto Connect(std::uint16_t port) -> int
+{
+  auto fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  auto addr = sockaddr_in {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  return fd;
+}
+
+auto Sleep(std::chrono::milliseconds duration) -> async::Task<>
+{
+  auto timer = async::TimerFd::Create(RT::GetReactor());
+  co_await timer->sleepFor(duration);
+}
+} // namespace
+
+TEST(AdmissionTest, PausesAtMaxConnections)
+{
+  constexpr static std::uint16_t Port = 39571;
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(Port));
+  ASSERT_TRUE(listener);
+  ASSERT_TRUE(listener->setAdmission({.maxConnections = 2}));
+  auto clients = std::vector<int> {Connect(Port), Connect(Port), Connect(Port)};
+
+  RT::Block([](async::TcpListener& listener) -> async::Task<> {
+    auto first = co_await listener.admit(nullptr);
+    auto second = co_await listener.admit(nullptr);
+    EXPECT_TRUE(first && second);
+    EXPECT_EQ(listener.admission()->active(), 2);
+    auto third = std::optional<async::Admitted<async::TcpStream>>();
+    RT::SpawnDetach([](async::TcpListener& listener, decltype(third)& third) -> async::Task<> {
+      auto admitted = co_await listener.admit(nullptr);
+      third = std::move(admitted).value();
+    }(listener, third));
+    co_await Sleep(20ms);
+    EXPECT_FALSE(third); // paused with the connection waiting in the backlog
+    first->permit.reset();
+    co_await Sleep(20ms);
+    EXPECT_TRUE(third);
+    EXPECT_EQ(listener.admission()->active(), 2);
+  }(*listener));
+  for (auto fd : clients) {
+    ::close(fd);
+  }
+}
+
+TEST(AdmissionTest, ShedsWithReserveFdAtDescriptorLimit)
+{
+  constexpr static std::uint16_t Port = 39572;
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(Port));
+  ASSERT_TRUE(listener);
+  ASSERT_TRUE(listener->setAdmission({.fdHeadroom = 0, .fdRetryDelay = 10ms}));
+  auto clients = std::vector<int> {Connect(Port), Connect(Port)};
+
+  auto timer = async::TimerFd::Create(RT::GetReactor());
+  ASSERT_TRUE(timer);
+  // allow no further descriptor
+  auto saved = ::rlimit {};
+  ::getrlimit(RLIMIT_NOFILE, &saved);
+  auto next = ::dup(0);
+  ::close(next);
+  auto lowered = ::rlimit {rlim_t(next), saved.rlim_max};
+  ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+  RT::Block([](async::TcpListener& listener, async::TimerFd& timer, ::rlimit saved) -> async::Task<> {
+    RT::SpawnDetach([](async::TimerFd& timer, ::rlimit saved) -> async::Task<> {
+      co_await timer.sleepFor(5ms); // after the first accept failed
+      ::setrlimit(RLIMIT_NOFILE, &saved);
+    }(timer, saved));
+    auto admitted = co_await listener.admit(nullptr); // sheds the first client, admits the second
+    EXPECT_TRUE(admitted);
+    EXPECT_EQ(listener.admission()->shed(), 1);
+  }(*listener, *timer, saved));
+  ::setrlimit(RLIMIT_NOFILE, &saved);
+  auto buf = char {};
+  EXPECT_EQ(::recv(clients[0], &buf, 1, 0), 0); // closed, not left hanging
+  for (auto fd : clients) {
+    ::close(fd);
+  }
+}
+
+TEST(AdmissionTest, CoDelShedsWhenSojournStaysHigh)
+{
+  constexpr static std::uint16_t Port = 39573;
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(Port));
+  ASSERT_TRUE(listener);
+  ASSERT_TRUE(listener->setAdmission({.codel = async::CoDelOptions {.target = 1ms, .interval = 20ms}}));
+  auto clients = std::vector<int> {Connect(Port), Connect(Port), Connect(Port), Connect(Port)};
+
+  RT::Block([](async::TcpListener& listener) -> async::Task<> {
+    auto a = co_await listener.admit(nullptr);
+    co_await Sleep(5ms);
+    a->permit.firstByte(); // above target
+    auto b = co_await listener.admit(nullptr);
+    co_await Sleep(25ms);
+    b->permit.firstByte(); // still above a whole interval later
+    auto d = co_await listener.admit(nullptr); // the third connection is shed
+    EXPECT_TRUE(d);
+    EXPECT_EQ(listener.admission()->shed(), 1);
+    d->permit.firstByte(); // right away, below target
+    EXPECT_EQ(listener.admission()->active(), 3);
+  }(*listener));
+  for (auto fd : clients) {
+    ::close(fd);
+  }
+}
+
+TEST(AdmissionTest, PausesWhileOtherDescriptorsFillTheHeadroom)
+{
+  constexpr static std::uint16_t Port = 39614;
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), async::SocketAddrV4::Localhost(Port));
+  ASSERT_TRUE(listener);
+  auto client = Connect(Port);
+
+  auto saved = ::rlimit {};
+  ::getrlimit(RLIMIT_NOFILE, &saved);
+  auto next = ::dup(0);
+  ::close(next);
+  auto lowered = ::rlimit {rlim_t(next + 32), saved.rlim_max};
+  ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+  // the headroom starts 16 descriptors above the lowest free one, and the control itself opens three of them
+  ASSERT_TRUE(listener->setAdmission({.fdHeadroom = 16, .fdRetryDelay = 5ms}));
+  // held elsewhere in the process, as another listener's connections would be: no permit of this control counts them
+  auto others = std::vector<int>();
+  for (int i = 0; i < 13; i++) {
+    others.push_back(::dup(0));
+  }
+
+  RT::Block([](async::TcpListener& listener, std::vector<int>& others) -> async::Task<> {
+    auto admitted = std::optional<async::Admitted<async::TcpStream>>();
+    RT::SpawnDetach([](async::TcpListener& listener, decltype(admitted)& admitted) -> async::Task<> {
+      auto r = co_await listener.admit(nullptr);
+      admitted = std::move(r).value();
+    }(listener, admitted));
+    co_await Sleep(30ms);
+    EXPECT_FALSE(admitted); // paused with no connection admitted by this control
+    EXPECT_EQ(listener.admission()->active(), 0);
+    for (auto fd : std::exchange(others, {})) {
+      ::close(fd);
+    }
+    co_await Sleep(30ms);
+    EXPECT_TRUE(admitted);
+  }(*listener, others));
+  ::setrlimit(RLIMIT_NOFILE, &saved);
+  for (auto fd : others) {
+    ::close(fd);
+  }
+  ::close(client);
+}
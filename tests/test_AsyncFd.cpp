@@ -0,0 +1,88 @@
+#include <Async/EventFd.hpp>
+#include <Async/Executor.hpp>
+#include <Async/SignalFd.hpp>
+#include <Async/TimerFd.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+TEST(AsyncFdTest, EventFdCrossThread)
+{
+  RT::Block([]() -> async::Task<> {
+    auto event = async::EventFd::Create(RT::GetReactor());
+    EXPECT_TRUE(event);
+    if (!event) {
+      co_return;
+    }
+    auto thread = std::thread([&] {
+      std::this_thread::sleep_for(10ms);
+      EXPECT_TRUE(event->notify(3));
+    });
+    auto count = co_await event->wait();
+    thread.join();
+    EXPECT_EQ(count.value(), 3);
+  }());
+}
+
+TEST(AsyncFdTest, TimerFdSleepAndInterval)
+{
+  RT::Block([]() -> async::Task<> {
+    auto timer = async::TimerFd::Create(RT::GetReactor());
+    EXPECT_TRUE(timer);
+    if (!timer) {
+      co_return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(co_await timer->sleepFor(20ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+    EXPECT_TRUE(timer->set(1ms, 1ms));
+    std::this_thread::sleep_for(10ms);
+    auto expirations = co_await timer->wait();
+    EXPECT_GE(expirations.value(), 2);
+    EXPECT_TRUE(timer->cancel());
+
+    // a deadline already passed, even by whole seconds, expires right away
+    EXPECT_TRUE(timer->set(-1500ms));
+    EXPECT_EQ((co_await timer->wait()).value(), 1);
+    EXPECT_TRUE(timer->set(0ns));
+    EXPECT_EQ((co_await timer->wait()).value(), 1);
+  }());
+}
+
+TEST(AsyncFdTest, SignalFd)
+{
+  RT::Block([]() -> async::Task<> {
+    auto signals = async::SignalFd::Create(RT::GetReactor(), {SIGUSR1});
+    EXPECT_TRUE(signals);
+    if (!signals) {
+      co_return;
+    }
+    ::raise(SIGUSR1);
+    auto info = co_await signals->wait();
+    EXPECT_EQ(info.value().ssi_signo, unsigned(SIGUSR1));
+  }());
+}
+
+TEST(AsyncFdTest, Pipe)
+{
+  RT::Block([]() -> async::Task<> {
+    auto pipe = async::Pipe::Create(RT::GetReactor());
+    EXPECT_TRUE(pipe);
+    if (!pipe) {
+      co_return;
+    }
+    auto text = "through the pipe"sv;
+    EXPECT_EQ((co_await pipe->writer.write(std::as_bytes(std::span(text)))).value(), ssize_t(text.size()));
+    co_await pipe->reader.ready(async::Interest::Read);
+    auto buf = std::array<std::byte, 64> {};
+    auto n = co_await pipe->reader.read(buf);
+    EXPECT_EQ(std::string_view((char const*)buf.data(), n.value()), text);
+    pipe->writer = {};
+    EXPECT_EQ((co_await pipe->reader.read(buf)).value(), 0);
+  }());
+}
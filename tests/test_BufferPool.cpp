@@ -0,0 +1,114 @@
+#include <Async/BufferPool.hpp>
+#include <Async/Executor.hpp>
+#include <Async/UnixStream.hpp>
+#include <Async/http/HttpServer.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+TEST(BufferPoolTest, ReusesReturnedBuffers)
+{
+  auto pool = async::BufferPool(4096, 1);
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  EXPECT_EQ(first.size(), 4096);
+  auto* data = first.data();
+  first.release();
+  second = {}; // beyond maxCached, freed
+  EXPECT_EQ(pool.cached(), 1);
+  EXPECT_EQ(pool.acquire().data(), data);
+  EXPECT_EQ(&async::BufferPool::Local(), &async::BufferPool::Local(async::BufferPool::DefaultBufferSize));
+  EXPECT_EQ(async::PooledBuffer(100).size(), 100); // private allocation, not returned anywhere
+}
+
+TEST(BufferPoolTest, ReleaseOnAnotherThreadUsesItsPool)
+{
+  auto& pool = async::BufferPool::Local(4096);
+  auto cached = pool.cached();
+  auto buffer = pool.acquire();
+  auto* data = buffer.data();
+  auto released = std::size_t(0);
+  std::thread([&] {
+    // as a coroutine resumed on another executor thread would
+    buffer.release();
+    released = async::BufferPool::Local(4096).cached();
+    EXPECT_EQ(async::BufferPool::Local(4096).acquire().data(), data);
+  }).join();
+  EXPECT_EQ(released, 1);
+  EXPECT_EQ(pool.cached(), cached);
+}
+
+TEST(BufferPoolTest, AcquireOnAnotherThreadUsesItsPool)
+{
+  auto& pool = async::BufferPool::Local(4096);
+  auto cached = pool.cached();
+  auto acquired = std::size_t(0);
+  std::thread([&] {
+    // as a task that migrated to another core with a reference to its old core's pool would
+    auto& local = async::BufferPool::Local(4096);
+    auto buffer = pool.acquire();
+    acquired = buffer.size();
+    buffer.release();
+    EXPECT_EQ(local.cached(), 1);
+  }).join();
+  EXPECT_EQ(acquired, 4096);
+  EXPECT_EQ(pool.cached(), cached);
+}
+
+TEST(BufferPoolTest, ReadableDoesNoIo)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::UnixStream& writer) -> async::Task<> {
+    co_await writer.writable();
+    co_await writer.send(std::as_bytes(std::span("ping"sv)));
+  }(pair->first));
+
+  RT::Block([](async::UnixStream& reader) -> async::Task<> {
+    co_await reader.readable();
+    auto buffer = async::BufferPool::Local().acquire();
+    auto n = co_await reader.recv(buffer.span());
+    EXPECT_EQ(n.value(), 4);
+  }(pair->second));
+}
+
+TEST(BufferPoolTest, ServeHoldsNoBufferWhileIdle)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& pool = async::BufferPool::Local();
+  auto cached = pool.cached();
+  auto& writeBuffers = async::http::detail::IdleWriteBuffers();
+  writeBuffers.clear();
+  RT::SpawnDetach([](async::UnixStream client, async::BufferPool& pool, std::size_t cached,
+                     std::vector<std::string>& writeBuffers) -> async::Task<> {
+    auto buf = std::array<std::byte, 4096> {};
+    auto writeBuffer = (char const*)nullptr;
+    for (int i = 0; i < 2; i++) {
+      auto request = "GET / HTTP/1.1\r\nHost: x\r\n\r\n"sv;
+      co_await client.send(std::as_bytes(std::span(request)));
+      auto response = std::string();
+      while (!response.ends_with("ok")) {
+        if (auto n = co_await client.recv(buf); n && *n > 0) {
+          response.append(reinterpret_cast<char const*>(buf.data()), std::size_t(*n));
+        }
+      }
+      EXPECT_TRUE(response.starts_with("HTTP/1.1 200"));
+      // the server flushed and went back to waiting, handing its read buffer back and putting its write buffer aside,
+      // the same one every time
+      EXPECT_EQ(pool.cached(), std::max<std::size_t>(cached, 1));
+      EXPECT_EQ(writeBuffers.size(), 1);
+      if (i != 0 && !writeBuffers.empty()) {
+        EXPECT_EQ(writeBuffers[0].data(), writeBuffer);
+      }
+      writeBuffer = writeBuffers.empty() ? nullptr : writeBuffers[0].data();
+    }
+  }(std::move(pair->second), pool, cached, writeBuffers));
+
+  RT::Block(async::http::Serve(std::move(pair->first),
+                               [](async::http::Request const&, async::http::ResponseWriter& res) { res.body("ok"); }));
+}
@@ -0,0 +1,72 @@
+#include <Async/BusyPoll.hpp>
+#include <Async/Detached.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <time.h>
+
+using namespace std::literals;
+
+namespace {
+auto ThreadCpuTime() -> std::chrono::nanoseconds
+{
+  auto ts = timespec {};
+  ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// Waits in recv for a byte a thread writes after `delay`, with the reactor polled by a BusyPoll with `budget`.
+// Returns the CPU time the polling thread used meanwhile.
+auto WaitForByte(std::chrono::nanoseconds budget, std::chrono::milliseconds delay) -> std::chrono::nanoseconds
+{
+  auto reactor = async::Reactor();
+  auto pair = async::UnixStream::Pair(reactor);
+  assert(pair);
+  auto& [reader, writer] = pair.value();
+  auto done = false;
+  async::detail::Detach([](async::UnixStream& reader, bool& done) -> async::Task<> {
+    auto buf = std::array<std::byte, 1> {};
+    auto n = co_await reader.recv(buf);
+    EXPECT_EQ(n.value(), 1);
+    done = true;
+  }(reader, done))
+      .handle.resume();
+  auto peer = std::thread([&writer, delay] {
+    std::this_thread::sleep_for(delay);
+    auto n = ::write(writer.getSocket().raw(), "x", 1);
+    assert(n == 1);
+  });
+  auto start = ThreadCpuTime();
+  async::BusyPoll(reactor, budget).run([&] { return done; });
+  auto used = ThreadCpuTime() - start;
+  peer.join();
+  EXPECT_TRUE(done);
+  return used;
+}
+} // namespace
+
+TEST(BusyPollTest, SpinsThroughShortWaits)
+{
+  // the byte arrives within the budget, so the thread stays on the CPU instead of sleeping in epoll
+  EXPECT_GE(WaitForByte(10s, 50ms), 20ms);
+}
+
+TEST(BusyPollTest, ZeroBudgetSleeps)
+{
+  EXPECT_LT(WaitForByte(0s, 50ms), 20ms);
+}
+
+TEST(BusyPollTest, SleepsOnceTheBudgetIsSpent)
+{
+  EXPECT_LT(WaitForByte(1ms, 100ms), 50ms);
+}
+
+TEST(BusyPollTest, ReturnsWhenDoneWithoutSpinningOn)
+{
+  auto reactor = async::Reactor();
+  auto start = std::chrono::steady_clock::now();
+  auto polls = 0;
+  async::BusyPoll(reactor, 10s).run([&] { return ++polls > 3; });
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
@@ -0,0 +1,124 @@
+#include <Async/Copy.hpp>
+#include <Async/Executor.hpp>
+#include <Async/MemoryStream.hpp>
+#include <Async/SslStream.hpp>
+#include <Async/TcpStream.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+static_assert(async::AsyncReadStream<async::TcpStream> && async::AsyncWriteStream<async::TcpStream>);
+static_assert(async::AsyncReadStream<async::UnixStream> && async::AsyncWriteStream<async::UnixStream>);
+static_assert(async::AsyncReadStream<async::SslStream> && async::AsyncWriteStream<async::SslStream>);
+static_assert(async::AsyncReadStream<async::MemoryStream> && async::AsyncWriteStream<async::MemoryStream>);
+static_assert(!async::AsyncReadStream<async::File>);
+
+namespace {
+auto Pattern(std::size_t size) -> std::vector<std::byte>
+{
+  auto data = std::vector<std::byte>(size);
+  for (std::size_t i = 0; i < size; i++) {
+    data[i] = std::byte(i % 251);
+  }
+  return data;
+}
+
+// Reads `stream` until it ends.
+template <typename Stream>
+auto Drain(Stream& stream) -> async::Task<std::vector<std::byte>>
+{
+  auto out = std::vector<std::byte>();
+  auto buf = std::array<std::byte, 4096> {};
+  while (true) {
+    auto n = co_await stream.recv(buf);
+    if (!n && async::detail::WouldBlock(n.error())) {
+      continue;
+    } else if (!n || *n == 0) {
+      break;
+    }
+    out.insert(out.end(), buf.begin(), buf.begin() + *n);
+  }
+  co_return out;
+}
+} // namespace
+
+TEST(CopyTest, SpliceBetweenSockets)
+{
+  constexpr static auto Total = std::size_t(1) << 20;
+  auto in = async::UnixStream::Pair(RT::GetReactor());
+  auto out = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(in && out);
+  RT::SpawnDetach([](async::UnixStream writer) -> async::Task<> {
+    auto data = Pattern(Total);
+    for (auto pending = std::span<std::byte const>(data); !pending.empty();) {
+      if (auto n = co_await writer.send(pending); n) {
+        pending = pending.subspan(std::size_t(*n));
+      }
+    }
+  }(std::move(in->first)));
+  RT::SpawnDetach([](async::UnixStream src, async::UnixStream dst) -> async::Task<> {
+    auto n = co_await async::copy(src, dst);
+    EXPECT_EQ(n.value(), Total);
+  }(std::move(in->second), std::move(out->first)));
+
+  RT::Block([](async::UnixStream reader) -> async::Task<> {
+    EXPECT_EQ(co_await Drain(reader), Pattern(Total));
+  }(std::move(out->second)));
+}
+
+TEST(CopyTest, CopyNStopsAtCount)
+{
+  auto in = async::UnixStream::Pair(RT::GetReactor());
+  auto out = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(in && out);
+  RT::Block([](async::UnixStream writer, async::UnixStream src, async::UnixStream dst) -> async::Task<> {
+    auto data = Pattern(1000);
+    EXPECT_EQ((co_await writer.send(data)).value(), 1000);
+    EXPECT_EQ((co_await async::copyN(src, dst, 600)).value(), 600);
+    auto buf = std::array<std::byte, 1000> {};
+    EXPECT_EQ((co_await src.recv(buf)).value(), 400); // the rest is left in the source
+  }(std::move(in->first), std::move(in->second), std::move(out->first)));
+}
+
+TEST(CopyTest, FileToSocket)
+{
+  auto path = std::filesystem::temp_directory_path() / ("async_copy_test." + std::to_string(::getpid()));
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](std::filesystem::path path, async::UnixStream dst) -> async::Task<> {
+    auto file = co_await async::File::Open(RT::GetReactor(), path, O_RDWR | O_CREAT | O_TRUNC);
+    EXPECT_TRUE(file);
+    if (!file) {
+      co_return;
+    }
+    EXPECT_TRUE(co_await file->write(Pattern(300000), 0));
+    EXPECT_EQ((co_await async::copy(*file, dst)).value(), 300000);
+  }(path, std::move(pair->first)));
+
+  RT::Block([](async::UnixStream reader) -> async::Task<> {
+    EXPECT_EQ(co_await Drain(reader), Pattern(300000));
+  }(std::move(pair->second)));
+  std::filesystem::remove(path);
+}
+
+TEST(CopyTest, BufferedBetweenMemoryAndSocket)
+{
+  constexpr static auto Total = std::size_t(200000);
+  auto memory = async::MemoryStream::Pair(RT::GetReactor(), 4096);
+  auto sockets = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(memory && sockets);
+  RT::SpawnDetach([](async::MemoryStream writer) -> async::Task<> {
+    co_await writer.sendAll(Pattern(Total));
+  }(std::move(memory->first)));
+  RT::SpawnDetach([](async::MemoryStream src, async::UnixStream dst) -> async::Task<> {
+    EXPECT_EQ((co_await async::copy(src, dst)).value(), Total);
+  }(std::move(memory->second), std::move(sockets->first)));
+
+  RT::Block([](async::UnixStream reader) -> async::Task<> {
+    EXPECT_EQ(co_await Drain(reader), Pattern(Total));
+  }(std::move(sockets->second)));
+}
@@ -0,0 +1,188 @@
+#include <Async/CoreRuntime.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <future>
+#include <netinet/in.h>
+#include <set>
+#include <thread>
+
+using namespace std::literals;
+
+TEST(CoreRuntimeTest, SpawnRunsOnCore)
+{
+  auto runtime = async::CoreRuntime::Create({.cores = 2, .pinThreads = false});
+  ASSERT_TRUE(runtime);
+  auto& rt = **runtime;
+  EXPECT_EQ(rt.cores(), 2);
+  EXPECT_FALSE(rt.currentCore());
+  for (std::size_t core = 0; core < rt.cores(); core++) {
+    auto ran = std::promise<std::optional<std::size_t>>();
+    auto future = ran.get_future();
+    rt.spawn(core, [](async::CoreRuntime& rt, std::promise<std::optional<std::size_t>>& ran) -> async::Task<> {
+      ran.set_value(rt.currentCore());
+      co_return;
+    }(rt, ran));
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(future.get(), core);
+  }
+}
+
+TEST(CoreRuntimeTest, MigrateMovesStreamAndTask)
+{
+  auto runtime = async::CoreRuntime::Create({.cores = 2, .pinThreads = false});
+  ASSERT_TRUE(runtime);
+  auto& rt = **runtime;
+  auto pair = async::UnixStream::Pair(rt.reactor(0));
+  ASSERT_TRUE(pair);
+  auto [a, b] = std::move(pair).value();
+
+  struct Outcome {
+    bool migrated = false;
+    std::optional<std::size_t> core;
+    bool onReactor = false;
+    std::string received;
+  };
+  auto done = std::promise<Outcome>();
+  auto future = done.get_future();
+  rt.spawn(0, [](async::CoreRuntime& rt, async::UnixStream a, async::UnixStream b,
+                 std::promise<Outcome>& done) -> async::Task<> {
+    auto outcome = Outcome {};
+    outcome.migrated = bool(co_await rt.migrate(a, 1));
+    outcome.core = rt.currentCore();
+    outcome.onReactor = a.reactor() == &rt.reactor(1);
+    // the peer stays on core 0 and sends from there
+    rt.spawn(0, [](async::UnixStream b) -> async::Task<> {
+      auto n = co_await b.send(std::as_bytes(std::span("ping", 4)));
+      assert(n);
+    }(std::move(b)));
+    auto buf = std::array<char, 16> {};
+    auto n = co_await a.recv(std::as_writable_bytes(std::span(buf)));
+    if (n) {
+      outcome.received.assign(buf.data(), std::size_t(n.value()));
+    }
+    done.set_value(outcome);
+  }(rt, std::move(a), std::move(b), done));
+
+  ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+  auto outcome = future.get();
+  EXPECT_TRUE(outcome.migrated);
+  EXPECT_EQ(outcome.core, 1);
+  EXPECT_TRUE(outcome.onReactor);
+  EXPECT_EQ(outcome.received, "ping");
+}
+
+TEST(CoreRuntimeTest, PlaceKeepsConnectionsWithoutNapiId)
+{
+  // busy-polling cores serve like sleeping ones
+  auto runtime = async::CoreRuntime::Create({.cores = 2, .pinThreads = false, .busyPoll = 100us});
+  ASSERT_TRUE(runtime);
+  auto& rt = **runtime;
+  auto pair = async::UnixStream::Pair(rt.reactor(1));
+  ASSERT_TRUE(pair);
+  auto [a, b] = std::move(pair).value();
+
+  auto done = std::promise<std::pair<bool, std::optional<std::size_t>>>();
+  auto future = done.get_future();
+  rt.spawn(1, [](async::CoreRuntime& rt, async::UnixStream a, async::UnixStream b,
+                 std::promise<std::pair<bool, std::optional<std::size_t>>>& done) -> async::Task<> {
+    // the kernel reports no NIC queue for a local connection, so it stays on the core it was created on
+    auto placed = bool(co_await rt.place(a));
+    auto n = co_await b.send(std::as_bytes(std::span("ping", 4)));
+    assert(n);
+    auto buf = std::array<std::byte, 4> {};
+    auto received = co_await a.recv(buf);
+    done.set_value({placed && received && received.value() == 4, rt.currentCore()});
+  }(rt, std::move(a), std::move(b), done));
+
+  ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+  auto [ok, core] = future.get();
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(core, 1);
+}
+
+TEST(CoreRuntimeTest, ListenServesOnEveryCore)
+{
+  constexpr auto Port = std::uint16_t(39581);
+  constexpr auto Clients = 16;
+  auto runtime = async::CoreRuntime::Create({.cores = 2, .pinThreads = false});
+  ASSERT_TRUE(runtime);
+  auto& rt = **runtime;
+  auto stopping = std::atomic<bool> {false};
+  auto finished = std::atomic<int> {0};
+  auto r = rt.listen(async::SocketAddrV4::Localhost(Port), {}, [&](async::TcpListener listener) -> async::Task<> {
+    while (!stopping.load()) {
+      auto stream = co_await listener.accept(nullptr);
+      if (!stream || stopping.load()) {
+        break;
+      }
+      auto core = static_cast<char>('0' + *rt.currentCore());
+      auto n = co_await stream->send(std::as_bytes(std::span(&core, 1)));
+      assert(n);
+    }
+    finished++;
+  });
+  ASSERT_TRUE(r);
+
+  auto connect = [] {
+    auto fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    auto addr = sockaddr_in {.sin_family = AF_INET, .sin_port = htons(Port), .sin_addr = {htonl(INADDR_LOOPBACK)}};
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      ::close(fd);
+      return -1;
+    }
+    return fd;
+  };
+  auto served = std::multiset<char>();
+  for (int i = 0; i < Clients; i++) {
+    auto fd = connect();
+    ASSERT_GE(fd, 0);
+    auto core = char {};
+    ASSERT_EQ(::read(fd, &core, 1), 1);
+    served.insert(core);
+    ::close(fd);
+  }
+  EXPECT_EQ(served.size(), Clients);
+  EXPECT_EQ(served.count('0') + served.count('1'), Clients);
+
+  // wake every accept loop until all of them returned
+  stopping = true;
+  for (int i = 0; i < 1000 && finished.load() < 2; i++) {
+    ::close(connect());
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(finished.load(), 2);
+}
+
+TEST(CoreRuntimeTest, DestroyingRuntimeClosesSocketsOfSuspendedTasks)
+{
+  auto runtime = async::CoreRuntime::Create({.cores = 2, .pinThreads = false});
+  ASSERT_TRUE(runtime);
+  auto& rt = **runtime;
+  auto pair = async::UnixStream::Pair(rt.reactor(0));
+  ASSERT_TRUE(pair);
+  auto [a, b] = std::move(pair).value();
+  auto peer = b.release(); // outlives the runtime
+
+  auto waiting = std::promise<void>();
+  auto future = waiting.get_future();
+  rt.spawn(0, [](async::CoreRuntime& rt, async::UnixStream a, std::promise<void>& waiting) -> async::Task<> {
+    // waits on core 1 for data that never comes
+    auto migrated = co_await rt.migrate(a, 1);
+    assert(migrated);
+    waiting.set_value();
+    auto buf = std::array<std::byte, 4> {};
+    co_await a.recv(buf);
+    assert(0 && "resumed after the runtime went away");
+  }(rt, std::move(a), waiting));
+  ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+  std::this_thread::sleep_for(10ms); // until the task is suspended in recv
+  // a task queued on a core but not started yet goes too
+  rt.spawn(1, []() -> async::Task<> { co_return; }());
+
+  runtime->reset();
+  auto byte = char {};
+  EXPECT_EQ(::read(peer.raw(), &byte, 1), 0); // the task's end was closed
+  EXPECT_TRUE(peer.close());
+}
@@ -0,0 +1,79 @@
+#include <Async/Executor.hpp>
+#include <Async/File.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+auto TempPath(std::string_view name) -> std::filesystem::path
+{
+  return std::filesystem::temp_directory_path() / (std::string(name) + "." + std::to_string(::getpid()));
+}
+} // namespace
+
+TEST(FileTest, WriteReadSync)
+{
+  auto path = TempPath("async_file_test");
+  RT::Block([](std::filesystem::path path) -> async::Task<> {
+    auto file = co_await async::File::Open(RT::GetReactor(), path, O_RDWR | O_CREAT | O_TRUNC);
+    EXPECT_TRUE(file);
+    if (!file) {
+      co_return;
+    }
+    auto text = "hello positioned world"sv;
+    auto written = co_await file->write(std::as_bytes(std::span(text)), 4);
+    EXPECT_EQ(written.value(), text.size());
+    EXPECT_TRUE(co_await file->fdatasync());
+    EXPECT_EQ(file->size().value(), off_t(4 + text.size()));
+
+    auto buf = std::array<std::byte, 64> {};
+    auto n = co_await file->read(buf, 10);
+    EXPECT_EQ(n.value(), text.size() - 6); // short only at end of file
+    EXPECT_EQ(std::string_view((char const*)buf.data(), n.value()), "positioned world");
+    EXPECT_EQ((co_await file->read(buf, 1000)).value(), 0);
+  }(path));
+  std::filesystem::remove(path);
+}
+
+TEST(FileTest, OpenMissing)
+{
+  RT::Block([]() -> async::Task<> {
+    auto file = co_await async::File::Open(RT::GetReactor(), "/nonexistent/async/file");
+    EXPECT_FALSE(file);
+    EXPECT_EQ(file.error(), std::errc::no_such_file_or_directory);
+  }());
+}
+
+TEST(FileTest, SendfileFromSameFd)
+{
+  auto path = TempPath("async_file_sendfile");
+  auto content = std::string(100000, 'x');
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::UnixStream& writer, std::filesystem::path path,
+                     std::string const& content) -> async::Task<> {
+    auto file = co_await async::File::Open(RT::GetReactor(), path, O_RDWR | O_CREAT | O_TRUNC);
+    EXPECT_TRUE(file);
+    EXPECT_TRUE(co_await file->write(std::as_bytes(std::span(content)), 0));
+    auto sent = co_await writer.sendfileAll(file->raw(), 0, content.size());
+    EXPECT_EQ(sent.value(), content.size());
+  }(pair->first, path, content));
+  auto received = std::string();
+  RT::Block([](async::UnixStream& reader, std::string& received, std::size_t total) -> async::Task<> {
+    auto buf = std::array<char, 8192> {};
+    while (received.size() < total) {
+      auto n = co_await reader.recv(std::as_writable_bytes(std::span(buf)));
+      if (!n || *n == 0) {
+        co_return;
+      }
+      received.append(buf.data(), *n);
+    }
+  }(pair->second, received, content.size()));
+  EXPECT_EQ(received.size(), content.size());
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,206 @@
+#include <Async/http/FileCache.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+using async::http::NoneMatchHits;
+using async::http::ParseHttpDate;
+using async::http::ParseRange;
+
+TEST(FileCacheTest, ParseRange)
+{
+  auto r = ParseRange("bytes=0-99", 1000);
+  ASSERT_TRUE(r);
+  EXPECT_EQ(r->first, 0);
+  EXPECT_EQ(r->length, 100);
+  r = ParseRange("bytes=900-", 1000);
+  ASSERT_TRUE(r);
+  EXPECT_EQ(r->first, 900);
+  EXPECT_EQ(r->length, 100);
+  r = ParseRange("bytes=-10", 1000);
+  ASSERT_TRUE(r);
+  EXPECT_EQ(r->first, 990);
+  EXPECT_EQ(r->length, 10);
+  r = ParseRange("bytes=500-5000", 1000);
+  ASSERT_TRUE(r);
+  EXPECT_EQ(r->length, 500);
+  r = ParseRange("bytes=1000-", 1000);
+  ASSERT_TRUE(r);
+  EXPECT_EQ(r->length, 0); // unsatisfiable
+  EXPECT_FALSE(ParseRange("bytes=5-1", 1000));
+  EXPECT_FALSE(ParseRange("bytes=0-1,5-6", 1000));
+  EXPECT_FALSE(ParseRange("items=0-1", 1000));
+}
+
+TEST(FileCacheTest, ParseHttpDate)
+{
+  // the three forms of the same instant, RFC 9110 section 5.6.7
+  EXPECT_EQ(ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"), 784111777);
+  EXPECT_EQ(ParseHttpDate("Sun Nov  6 08:49:37 1994"), 784111777);
+  EXPECT_FALSE(ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT junk"));
+  EXPECT_FALSE(ParseHttpDate("yesterday"));
+  EXPECT_FALSE(ParseHttpDate(""));
+}
+
+TEST(FileCacheTest, NoneMatchHits)
+{
+  EXPECT_TRUE(NoneMatchHits("\"a-1\"", "\"a-1\""));
+  EXPECT_FALSE(NoneMatchHits("\"a-2\"", "\"a-1\""));
+  // lists, with or without whitespace around the commas
+  EXPECT_TRUE(NoneMatchHits("\"x\", \"a-1\"", "\"a-1\""));
+  EXPECT_TRUE(NoneMatchHits("\"x\",\"y\" ,  \"a-1\"", "\"a-1\""));
+  EXPECT_FALSE(NoneMatchHits("\"x\", \"y\"", "\"a-1\""));
+  // weak comparison ignores W/ on either side
+  EXPECT_TRUE(NoneMatchHits("W/\"a-1\"", "\"a-1\""));
+  EXPECT_TRUE(NoneMatchHits("\"x\", W/\"a-1\"", "\"a-1\""));
+  EXPECT_TRUE(NoneMatchHits("\"a-1\"", "W/\"a-1\""));
+  // a comma inside a tag does not split it
+  EXPECT_TRUE(NoneMatchHits("\"a,1\"", "\"a,1\""));
+  EXPECT_FALSE(NoneMatchHits("\"a,1\"", "\"1\""));
+  EXPECT_TRUE(NoneMatchHits("*", "\"a-1\""));
+  EXPECT_TRUE(NoneMatchHits(" * ", "\"a-1\""));
+  // unquoted or unterminated tags match nothing
+  EXPECT_FALSE(NoneMatchHits("a-1", "\"a-1\""));
+  EXPECT_FALSE(NoneMatchHits("\"a-1", "\"a-1\""));
+  EXPECT_FALSE(NoneMatchHits("", "\"a-1\""));
+}
+
+TEST(FileCacheTest, HitEvictAndInvalidate)
+{
+  auto root = std::filesystem::temp_directory_path() / "asyncio_test_FileCache";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  std::ofstream(root / "a.txt") << "hello";
+  std::ofstream(root / "b.txt") << "world";
+
+  auto cache = async::http::FileCache(root, {.maxEntries = 1, .invalidateInterval = std::chrono::milliseconds(0)});
+  auto a = cache.open("a.txt");
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a.value()->size, 5);
+  EXPECT_EQ(a.value()->contentType, "text/plain; charset=utf-8");
+  EXPECT_EQ(cache.open("a.txt").value(), a.value());
+
+  auto b = cache.open("b.txt");
+  ASSERT_TRUE(b);
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_NE(cache.open("a.txt").value(), a.value()); // evicted and reopened
+
+  auto a2 = cache.open("a.txt").value();
+  std::ofstream(root / "a.txt", std::ios::app) << " again";
+  auto a3 = cache.open("a.txt");
+  ASSERT_TRUE(a3);
+  EXPECT_NE(a3.value(), a2);
+  EXPECT_EQ(a3.value()->size, 11);
+
+  EXPECT_FALSE(cache.open("missing.txt"));
+  std::filesystem::remove_all(root);
+}
+
+namespace {
+// Serves `head`, a request head without the final empty line, from `cache`. Returns the response head.
+auto Serve(async::http::FileCache& cache, std::string head) -> std::string
+{
+  head += "\r\n";
+  auto parser = async::http::RequestParser {};
+  auto request = async::http::Request {};
+  auto r = parser.parse(head, request);
+  assert(r.status == async::http::ParseStatus::Complete);
+  auto out = std::string();
+  auto writer = async::http::ResponseWriter(out, request.keepAlive);
+  async::http::ServeFile(cache, request, writer);
+  writer.finish();
+  return out;
+}
+} // namespace
+
+TEST(FileCacheTest, NotModifiedHasNoContentLength)
+{
+  auto root = std::filesystem::temp_directory_path() / "asyncio_test_FileCache304";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  std::ofstream(root / "a.txt") << "hello";
+  auto cache = async::http::FileCache(root);
+  auto file = cache.open("a.txt");
+  ASSERT_TRUE(file);
+
+  auto ok = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\n");
+  EXPECT_TRUE(ok.starts_with("HTTP/1.1 200 ")) << ok;
+  EXPECT_NE(ok.find("Content-Length: 5\r\n"), std::string::npos) << ok;
+
+  auto etag = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-None-Match: " + file.value()->etag + "\r\n");
+  EXPECT_TRUE(etag.starts_with("HTTP/1.1 304 ")) << etag;
+  EXPECT_EQ(etag.find("Content-Length"), std::string::npos) << etag;
+  EXPECT_NE(etag.find("ETag: " + file.value()->etag + "\r\n"), std::string::npos) << etag;
+  EXPECT_TRUE(etag.ends_with("\r\n\r\n")) << etag;
+  for (auto inm : {"\"other\", W/" + file.value()->etag, "W/" + file.value()->etag, std::string("*")}) {
+    auto hit = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-None-Match: " + inm + "\r\n");
+    EXPECT_TRUE(hit.starts_with("HTTP/1.1 304 ")) << inm << "\n" << hit;
+  }
+  auto miss = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-None-Match: \"other\", W/\"another\"\r\n");
+  EXPECT_TRUE(miss.starts_with("HTTP/1.1 200 ")) << miss;
+
+  auto date = Serve(cache, "HEAD /a.txt HTTP/1.1\r\nHost: x\r\nConnection: close\r\nIf-Modified-Since: " +
+                               file.value()->lastModified + "\r\n");
+  EXPECT_TRUE(date.starts_with("HTTP/1.1 304 ")) << date;
+  EXPECT_EQ(date.find("Content-Length"), std::string::npos) << date;
+  EXPECT_TRUE(date.ends_with("Connection: close\r\n\r\n")) << date;
+
+  // dates are compared as times, not as strings
+  auto later = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-Modified-Since: Fri, 31 Dec 9999 23:59:59 GMT\r\n");
+  EXPECT_TRUE(later.starts_with("HTTP/1.1 304 ")) << later;
+  auto earlier = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n");
+  EXPECT_TRUE(earlier.starts_with("HTTP/1.1 200 ")) << earlier;
+  auto invalid = Serve(cache, "GET /a.txt HTTP/1.1\r\nHost: x\r\nIf-Modified-Since: tomorrow\r\n");
+  EXPECT_TRUE(invalid.starts_with("HTTP/1.1 200 ")) << invalid;
+  std::filesystem::remove_all(root);
+}
+
+TEST(FileCacheTest, TargetsCannotLeaveTheRoot)
+{
+  auto base = std::filesystem::temp_directory_path() / "asyncio_test_FileCacheRoot";
+  auto root = base / "www";
+  std::filesystem::remove_all(base);
+  std::filesystem::create_directories(root / "a");
+  std::ofstream(root / "a" / "b") << "inside";
+  std::ofstream(base / "secret.txt") << "outside";
+  std::filesystem::create_symlink(base / "secret.txt", root / "link.txt");
+  auto cache = async::http::FileCache(root);
+
+  for (auto target : {"//x", "/%2f..", "/a//b", "/%2Fetc/passwd", "/%2e%2e/secret.txt", "/a%-1", "/a%+1", "/a%1"}) {
+    auto response = Serve(cache, std::string("GET ") + target + " HTTP/1.1\r\nHost: x\r\n");
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 400 ")) << target << ": " << response;
+  }
+  EXPECT_TRUE(Serve(cache, "GET /a/b HTTP/1.1\r\nHost: x\r\n").starts_with("HTTP/1.1 200 "));
+  EXPECT_TRUE(Serve(cache, "GET /link.txt HTTP/1.1\r\nHost: x\r\n").starts_with("HTTP/1.1 404 "));
+
+  // keys handed to the cache directly are confined as well
+  EXPECT_FALSE(cache.open((base / "secret.txt").string()));
+  EXPECT_FALSE(cache.open("../secret.txt"));
+  EXPECT_FALSE(cache.open("link.txt"));
+  std::filesystem::remove_all(base);
+}
+
+TEST(FileCacheTest, HiddenFilesAreNotServed)
+{
+  auto root = std::filesystem::temp_directory_path() / "asyncio_test_FileCacheHidden";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / ".git");
+  std::filesystem::create_directories(root / ".well-known");
+  std::ofstream(root / ".git" / "config") << "[core]";
+  std::ofstream(root / ".env") << "SECRET=1";
+  std::ofstream(root / ".well-known" / "security.txt") << "Contact: x";
+
+  auto cache = async::http::FileCache(root);
+  for (auto target : {"/.git/config", "/.env", "/%2eenv", "/.well-known/security.txt"}) {
+    auto response = Serve(cache, std::string("GET ") + target + " HTTP/1.1\r\nHost: x\r\n");
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 404 ")) << target << ": " << response;
+  }
+  EXPECT_FALSE(cache.open(".env"));
+
+  auto open = async::http::FileCache(root, {.allowHidden = true});
+  EXPECT_TRUE(Serve(open, "GET /.well-known/security.txt HTTP/1.1\r\nHost: x\r\n").starts_with("HTTP/1.1 200 "));
+  EXPECT_TRUE(open.open(".env"));
+  std::filesystem::remove_all(root);
+}
@@ -0,0 +1,181 @@
+#include <Async/Executor.hpp>
+#include <Async/Framed.hpp>
+#include <Async/SslListener.hpp>
+#include <Async/SslStream.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "TlsTestUtil.hpp"
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+auto Frame(std::size_t size, char fill) -> std::string
+{
+  auto payload = std::string(size, fill);
+  auto header = std::string {char(size >> 24), char(size >> 16), char(size >> 8), char(size)};
+  return header + payload;
+}
+
+} // namespace
+
+TEST(FramedTest, FramesStraddlingTheBuffer)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto sizes = std::vector<std::size_t> {0, 10, 50, 3, 200, 64, 1, 1000, 7};
+  auto wire = std::string();
+  for (std::size_t i = 0; i < sizes.size(); i++) {
+    wire += Frame(sizes[i], char('a' + i));
+  }
+  // written in odd pieces so headers and payloads arrive split
+  RT::SpawnDetach([](async::UnixStream stream, std::string wire) -> async::Task<> {
+    for (std::size_t sent = 0; sent < wire.size();) {
+      auto piece = std::string_view(wire).substr(sent, 37);
+      auto n = co_await stream.send(std::as_bytes(std::span(piece)));
+      if (!n) {
+        co_return;
+      }
+      sent += std::size_t(*n);
+    }
+  }(std::move(pair->second), wire));
+
+  RT::Block([](async::UnixStream stream, std::vector<std::size_t> sizes) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream), {.readBufferSize = 64});
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+      auto frame = co_await framed.next();
+      EXPECT_TRUE(frame && *frame);
+      if (!frame || !*frame) {
+        co_return;
+      }
+      auto text = std::string_view(reinterpret_cast<char const*>((*frame)->data()), (*frame)->size());
+      EXPECT_EQ(text, std::string(sizes[i], char('a' + i))) << i;
+    }
+    auto end = co_await framed.next();
+    EXPECT_TRUE(end && !*end);
+  }(std::move(pair->first), sizes));
+}
+
+TEST(FramedTest, MirroredReadBufferWraps)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto sizes = std::vector<std::size_t>();
+  for (std::size_t i = 0; i < 40; i++) {
+    sizes.push_back(i == 30 ? 6000 : 97 * i % 1500); // one frame over the ring's page
+  }
+  auto wire = std::string();
+  for (std::size_t i = 0; i < sizes.size(); i++) {
+    wire += Frame(sizes[i], char('a' + i % 26));
+  }
+  RT::SpawnDetach([](async::UnixStream stream, std::string wire) -> async::Task<> {
+    for (std::size_t sent = 0; sent < wire.size();) {
+      auto piece = std::string_view(wire).substr(sent, 1000);
+      auto n = co_await stream.send(std::as_bytes(std::span(piece)));
+      if (!n) {
+        co_return;
+      }
+      sent += std::size_t(*n);
+    }
+  }(std::move(pair->second), wire));
+
+  RT::Block([](async::UnixStream stream, std::vector<std::size_t> sizes) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream), {.readBufferSize = 4096, .mirroredReadBuffer = true});
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+      auto frame = co_await framed.next();
+      EXPECT_TRUE(frame && *frame);
+      if (!frame || !*frame) {
+        co_return;
+      }
+      auto text = std::string_view(reinterpret_cast<char const*>((*frame)->data()), (*frame)->size());
+      EXPECT_EQ(text, std::string(sizes[i], char('a' + i % 26))) << i;
+    }
+    auto end = co_await framed.next();
+    EXPECT_TRUE(end && !*end);
+  }(std::move(pair->first), sizes));
+}
+
+TEST(FramedTest, BatchedWritesAndLimits)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::UnixStream stream) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream));
+    auto a = "first"sv;
+    auto b = std::string(100000, 'b');
+    std::span<std::byte const> frames[] = {std::as_bytes(std::span(a)), {}, std::as_bytes(std::span(b))};
+    co_await framed.feed(std::as_bytes(std::span("fed"sv)));
+    co_await framed.sendBatch(frames);
+    auto c = std::string(2000, 'c');
+    co_await framed.send(std::as_bytes(std::span(c)));
+  }(std::move(pair->second)));
+
+  RT::Block([](async::UnixStream stream) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream), {.maxFrameSize = 1000});
+    auto expected = {"fed"s, "first"s, ""s};
+    for (auto const& text : expected) {
+      auto frame = co_await framed.next();
+      EXPECT_TRUE(frame && *frame);
+      if (!frame || !*frame) {
+        co_return;
+      }
+      EXPECT_EQ(std::string_view(reinterpret_cast<char const*>((*frame)->data()), (*frame)->size()), text);
+    }
+    auto tooLarge = co_await framed.next();
+    EXPECT_FALSE(tooLarge);
+    EXPECT_EQ(tooLarge.error(), std::errc::message_size);
+  }(std::move(pair->first)));
+}
+
+TEST(FramedTest, TlsCloseNotifyEndsTheStream)
+{
+  auto serverCtx = async::TlsContext::Create();
+  auto clientCtx = async::TlsContext::Create();
+  ASSERT_TRUE(serverCtx && clientCtx);
+  ASSERT_TRUE(UseSelfSigned(*serverCtx));
+  SSL_CTX_set_verify(clientCtx->raw(), SSL_VERIFY_NONE, nullptr);
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(39612));
+  auto listener = async::SslListener::Bind(*serverCtx, RT::GetReactor(), addr);
+  ASSERT_TRUE(listener);
+
+  // the client sends two frames and closes cleanly, both read modes then end the stream between frames. The client
+  // closes its socket only after the server did, a reset would drop the close_notify.
+  for (auto mirrored : {false, true}) {
+    RT::SpawnDetach([](async::SslListener& listener, async::TlsContext& ctx, bool mirrored) -> async::Task<> {
+      auto socket = co_await listener.accept(ctx, nullptr);
+      EXPECT_TRUE(socket);
+      if (!socket) {
+        co_return;
+      }
+      auto framed = async::Framed(async::SslStream(std::move(socket).value()), {.mirroredReadBuffer = mirrored});
+      for (auto size : {5, 300}) {
+        auto frame = co_await framed.next();
+        EXPECT_TRUE(frame && *frame && (*frame)->size() == std::size_t(size)) << mirrored;
+      }
+      auto end = co_await framed.next();
+      EXPECT_TRUE(end && !*end) << mirrored;
+    }(*listener, *serverCtx, mirrored));
+
+    RT::Block([](async::TlsContext& ctx, async::SocketAddr addr) -> async::Task<> {
+      auto stream = co_await async::SslStream::Connect(ctx, RT::GetReactor(), addr);
+      EXPECT_TRUE(stream);
+      if (!stream) {
+        co_return;
+      }
+      auto wire = Frame(5, 'a') + Frame(300, 'b');
+      auto n = co_await stream->sendAll(std::as_bytes(std::span(wire)));
+      EXPECT_EQ(n.value_or(0), wire.size());
+      stream->shutdown();
+      auto buf = std::array<std::byte, 256> {};
+      while (true) {
+        if (auto r = co_await stream->recv(buf); !r && r.error().wait()) {
+          continue;
+        }
+        break;
+      }
+    }(*clientCtx, addr));
+  }
+}
@@ -0,0 +1,93 @@
+#include <Async/http/HttpParser.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace std::literals;
+using async::http::ParseStatus;
+
+TEST(HttpParserTest, RequestLineAndHeaders)
+{
+  auto parser = async::http::RequestParser {};
+  auto req = async::http::Request {};
+  auto data = "GET /index.html?q=1 HTTP/1.1\r\nHost: example.com\r\nAccept:  */*  \r\n\r\n"sv;
+  auto r = parser.parse(data, req);
+  ASSERT_EQ(r.status, ParseStatus::Complete);
+  EXPECT_EQ(r.consumed, data.size());
+  EXPECT_EQ(req.method, "GET");
+  EXPECT_EQ(req.target, "/index.html?q=1");
+  EXPECT_EQ(req.minorVersion, 1);
+  ASSERT_EQ(req.headers().size(), 2);
+  EXPECT_EQ(req.header("host"), "example.com");
+  EXPECT_EQ(req.header("ACCEPT"), "*/*");
+  EXPECT_TRUE(req.keepAlive);
+}
+
+TEST(HttpParserTest, Incremental)
+{
+  auto data = "POST /submit HTTP/1.1\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello"s;
+  auto parser = async::http::RequestParser {};
+  auto req = async::http::Request {};
+  for (std::size_t i = 0; i < data.size(); i++) {
+    EXPECT_EQ(parser.parse(std::string_view(data).substr(0, i), req).status, ParseStatus::Incomplete) << i;
+  }
+  auto r = parser.parse(data, req);
+  ASSERT_EQ(r.status, ParseStatus::Complete);
+  EXPECT_EQ(req.body, "hello");
+  EXPECT_FALSE(req.keepAlive);
+}
+
+TEST(HttpParserTest, Pipelined)
+{
+  auto data = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.0\r\n\r\nGET /c"sv;
+  auto parser = async::http::RequestParser {};
+  auto req = async::http::Request {};
+  auto r = parser.parse(data, req);
+  ASSERT_EQ(r.status, ParseStatus::Complete);
+  EXPECT_EQ(req.target, "/a");
+  data.remove_prefix(r.consumed);
+  r = parser.parse(data, req);
+  ASSERT_EQ(r.status, ParseStatus::Complete);
+  EXPECT_EQ(req.target, "/b");
+  EXPECT_FALSE(req.keepAlive);
+  data.remove_prefix(r.consumed);
+  EXPECT_EQ(parser.parse(data, req).status, ParseStatus::Incomplete);
+}
+
+TEST(HttpParserTest, Malformed)
+{
+  auto req = async::http::Request {};
+  for (auto data : {"GET\r\n\r\n"sv, "GET / HTTP/2.0\r\n\r\n"sv, "GET /\x01 HTTP/1.1\r\n\r\n"sv,
+                    "GET / HTTP/1.1\r\nBad Header: x\r\n\r\n"sv, "GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n"sv}) {
+    auto parser = async::http::RequestParser {};
+    EXPECT_EQ(parser.parse(data, req).status, ParseStatus::Error) << data;
+  }
+}
+
+TEST(HttpParserTest, RepeatedContentLength)
+{
+  auto req = async::http::Request {};
+  auto parser = async::http::RequestParser {};
+  auto conflicting = "POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 5\r\n\r\nabcde"sv;
+  EXPECT_EQ(parser.parse(conflicting, req).status, ParseStatus::Error);
+
+  parser = async::http::RequestParser {};
+  auto repeated = "POST / HTTP/1.1\r\nContent-Length: 3\r\ncontent-length: 3\r\n\r\nabc"sv;
+  auto r = parser.parse(repeated, req);
+  EXPECT_EQ(r.status, ParseStatus::Complete);
+  EXPECT_EQ(r.consumed, repeated.size());
+  EXPECT_EQ(req.body, "abc");
+}
+
+TEST(HttpParserTest, FindInRangesMatchesScalar)
+{
+  auto data = std::string(200, 'a');
+  for (std::size_t i = 0; i < data.size(); i++) {
+    auto copy = data;
+    copy[i] = '\r';
+    auto ranges = "\x00\x08\x0a\x1f\x7f\x7f"sv;
+    EXPECT_EQ(async::http::detail::FindInRanges(copy.data(), copy.data() + copy.size(), ranges), copy.data() + i);
+  }
+  EXPECT_EQ(async::http::detail::FindInRanges(data.data(), data.data() + data.size(), "\x00\x20"sv),
+            data.data() + data.size());
+}
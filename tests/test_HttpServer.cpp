@@ -0,0 +1,219 @@
+#include <Async/Executor.hpp>
+#include <Async/SslListener.hpp>
+#include <Async/SslStream.hpp>
+#include <Async/UnixStream.hpp>
+#include <Async/http/FileCache.hpp>
+#include <Async/http/HttpServer.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "TlsTestUtil.hpp"
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+// Answers every request with its target as the body and records the targets in order.
+struct EchoTarget {
+  std::vector<std::string>& targets;
+  auto operator()(async::http::Request const& req, async::http::ResponseWriter& res) -> void
+  {
+    targets.emplace_back(req.target);
+    res.header("Content-Type", "text/plain").body(req.target);
+  }
+};
+
+// Receives until `done` holds for what arrived so far, or the peer closed.
+template <typename Done>
+auto RecvUntil(async::UnixStream& client, std::string& received, Done done) -> async::Task<bool>
+{
+  auto buf = std::array<std::byte, 4096> {};
+  while (!done(received)) {
+    auto n = co_await client.recv(buf);
+    if (!n && async::detail::WouldBlock(n.error())) {
+      continue;
+    } else if (!n || *n == 0) {
+      co_return false;
+    }
+    received.append(reinterpret_cast<char const*>(buf.data()), std::size_t(*n));
+  }
+  co_return true;
+}
+
+auto Count(std::string_view text, std::string_view what) -> std::size_t
+{
+  auto count = std::size_t(0);
+  for (auto pos = text.find(what); pos != text.npos; pos = text.find(what, pos + what.size())) {
+    count++;
+  }
+  return count;
+}
+} // namespace
+
+TEST(HttpServerTest, PipelinedRequestsShareOneConnection)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto targets = std::vector<std::string>();
+  RT::SpawnDetach(async::http::Serve(std::move(pair->first), EchoTarget {targets}));
+
+  auto pipelined = std::string();
+  auto closing = std::string();
+  auto closed = false;
+  RT::Block([](async::UnixStream& client, std::string& pipelined, std::string& closing,
+               bool& closed) -> async::Task<> {
+    // both requests in one write, so the server finds the second already buffered behind the first
+    auto requests = "GET /a HTTP/1.1\r\nHost: x\r\n\r\nGET /b HTTP/1.1\r\nHost: x\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(requests))));
+    EXPECT_TRUE(co_await RecvUntil(client, pipelined, [](auto& r) { return r.ends_with("/b"); }));
+
+    // the connection is still open for a third request, which asks to close it
+    auto last = "GET /c HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(last))));
+    closed = !co_await RecvUntil(client, closing, [](auto&) { return false; });
+  }(pair->second, pipelined, closing, closed));
+
+  EXPECT_EQ(targets, (std::vector<std::string> {"/a", "/b", "/c"}));
+  EXPECT_EQ(Count(pipelined, "HTTP/1.1 200 OK\r\n"), 2);
+  EXPECT_LT(pipelined.find("\r\n\r\n/a"), pipelined.find("\r\n\r\n/b")); // answered in order
+  EXPECT_EQ(pipelined.find("Connection: close"), std::string::npos);
+  EXPECT_TRUE(closed);
+  EXPECT_TRUE(closing.starts_with("HTTP/1.1 200 OK\r\n"));
+  EXPECT_NE(closing.find("Connection: close\r\n"), std::string::npos);
+  EXPECT_TRUE(closing.ends_with("\r\n\r\n/c"));
+}
+
+TEST(HttpServerTest, ConnectionCloseEndsTheLoop)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto targets = std::vector<std::string>();
+  RT::SpawnDetach(async::http::Serve(std::move(pair->first), EchoTarget {targets}));
+
+  auto received = std::string();
+  RT::Block([](async::UnixStream& client, std::string& received) -> async::Task<> {
+    // the request pipelined behind the close must not be answered
+    auto requests = "GET /a HTTP/1.1\r\nConnection: close\r\n\r\nGET /b HTTP/1.1\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(requests))));
+    EXPECT_FALSE(co_await RecvUntil(client, received, [](auto&) { return false; }));
+  }(pair->second, received));
+
+  EXPECT_EQ(targets, std::vector<std::string> {"/a"});
+  EXPECT_EQ(Count(received, "HTTP/1.1 "), 1);
+  EXPECT_NE(received.find("Connection: close\r\n"), std::string::npos);
+}
+
+TEST(HttpServerTest, Http10EndsTheLoop)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto targets = std::vector<std::string>();
+  RT::SpawnDetach(async::http::Serve(std::move(pair->first), EchoTarget {targets}));
+
+  auto received = std::string();
+  RT::Block([](async::UnixStream& client, std::string& received) -> async::Task<> {
+    // HTTP/1.0 closes after one response unless it asks for keep-alive
+    auto requests = "GET /a HTTP/1.0\r\n\r\nGET /b HTTP/1.0\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(requests))));
+    EXPECT_FALSE(co_await RecvUntil(client, received, [](auto&) { return false; }));
+  }(pair->second, received));
+
+  EXPECT_EQ(targets, std::vector<std::string> {"/a"});
+  EXPECT_EQ(Count(received, "HTTP/1.1 "), 1);
+  EXPECT_NE(received.find("Connection: close\r\n"), std::string::npos);
+  EXPECT_TRUE(received.ends_with("\r\n\r\n/a"));
+}
+
+TEST(HttpServerTest, Http10KeepAliveIsAnnounced)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto targets = std::vector<std::string>();
+  RT::SpawnDetach(async::http::Serve(std::move(pair->first), EchoTarget {targets}));
+
+  auto received = std::string();
+  RT::Block([](async::UnixStream& client, std::string& received) -> async::Task<> {
+    // a 1.0 client keeps the connection only if the response says so, then sends the next request on it
+    auto first = "GET /a HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(first))));
+    EXPECT_TRUE(co_await RecvUntil(client, received, [](auto& r) { return r.ends_with("/a"); }));
+    auto second = "GET /b HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"sv;
+    EXPECT_TRUE(co_await client.send(std::as_bytes(std::span(second))));
+    EXPECT_TRUE(co_await RecvUntil(client, received, [](auto& r) { return r.ends_with("/b"); }));
+  }(pair->second, received));
+
+  EXPECT_EQ(targets, (std::vector<std::string> {"/a", "/b"}));
+  EXPECT_EQ(Count(received, "HTTP/1.1 200 OK\r\n"), 2);
+  EXPECT_EQ(Count(received, "Connection: keep-alive\r\n"), 2);
+  EXPECT_EQ(received.find("Connection: close"), std::string::npos);
+}
+
+TEST(HttpServerTest, FileBodyOverTlsWithoutKtls)
+{
+  constexpr auto Size = std::size_t(200 << 10);
+  auto root = std::filesystem::temp_directory_path() / "asyncio_test_HttpServerTls";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  auto content = std::string(Size, '\0');
+  for (std::size_t i = 0; i < Size; i++) {
+    content[i] = char('a' + i % 26);
+  }
+  std::ofstream(root / "big.bin", std::ios::binary) << content;
+  auto cache = async::http::FileCache(root);
+
+  auto serverCtx = async::TlsContext::Create();
+  auto clientCtx = async::TlsContext::Create();
+  ASSERT_TRUE(serverCtx && clientCtx);
+  ASSERT_TRUE(UseSelfSigned(*serverCtx));
+  SSL_CTX_set_verify(clientCtx->raw(), SSL_VERIFY_NONE, nullptr);
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(39613));
+  auto listener = async::SslListener::Bind(*serverCtx, RT::GetReactor(), addr);
+  ASSERT_TRUE(listener);
+
+  RT::SpawnDetach([](async::SslListener& listener, async::TlsContext& ctx,
+                     async::http::FileCache& cache) -> async::Task<> {
+    auto socket = co_await listener.accept(ctx, nullptr);
+    if (!socket) {
+      ADD_FAILURE() << "accept failed";
+      co_return;
+    }
+    auto stream = async::SslStream(std::move(socket).value());
+    // no kernel TLS was asked for, so SSL_sendfile would fail and the body has to go through the write buffer
+    EXPECT_FALSE(stream.ktlsSend());
+    co_await async::http::Serve(std::move(stream), [&cache](auto const& req, auto& res) {
+      async::http::ServeFile(cache, req, res);
+    });
+  }(*listener, *serverCtx, cache));
+
+  auto received = std::string();
+  RT::Block([](async::TlsContext& ctx, async::SocketAddr addr, std::string& received) -> async::Task<> {
+    auto stream = co_await async::SslStream::Connect(ctx, RT::GetReactor(), addr);
+    if (!stream) {
+      ADD_FAILURE() << "connect failed";
+      co_return;
+    }
+    auto request = "GET /big.bin HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n"sv;
+    EXPECT_TRUE(co_await stream->sendAll(std::as_bytes(std::span(request))));
+    auto buf = std::array<std::byte, 16384> {};
+    while (true) {
+      auto n = co_await stream->recv(buf);
+      if (!n && n.error().wait()) {
+        continue;
+      } else if (!n || *n == 0) {
+        break;
+      }
+      received.append(reinterpret_cast<char const*>(buf.data()), *n);
+    }
+  }(*clientCtx, addr, received));
+
+  EXPECT_TRUE(received.starts_with("HTTP/1.1 200 OK\r\n")) << received.substr(0, 200);
+  EXPECT_NE(received.find("Content-Length: " + std::to_string(Size) + "\r\n"), std::string::npos);
+  auto body = received.find("\r\n\r\n");
+  ASSERT_NE(body, std::string::npos);
+  EXPECT_EQ(received.size() - body - 4, Size);
+  EXPECT_TRUE(received.substr(body + 4) == content);
+  std::filesystem::remove_all(root);
+}
@@ -0,0 +1,133 @@
+#include <Async/Executor.hpp>
+#include <Async/IoScheduler.hpp>
+#include <Async/TimerFd.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+// Makes a connection per entry of `classes` wait in recv, then writes to all of them at once, in that order, so one
+// poll reports them together. Collects the order the reads completed in.
+auto Resumptions(async::IoScheduler& scheduler, std::vector<async::IoClass> const& classes,
+                 std::vector<std::size_t>& order) -> void
+{
+  auto& reactor = RT::GetReactor();
+  auto readers = std::vector<async::Prioritized<async::UnixStream>>();
+  auto peers = std::vector<async::UnixStream>();
+  for (auto ioClass : classes) {
+    auto pair = async::UnixStream::Pair(reactor);
+    ASSERT_TRUE(pair);
+    auto reader = async::Prioritized<async::UnixStream>::Create(scheduler, std::move(pair->first), ioClass);
+    ASSERT_TRUE(reader);
+    readers.push_back(std::move(reader).value());
+    peers.push_back(std::move(pair->second));
+  }
+  auto timer = async::TimerFd::Create(reactor);
+  ASSERT_TRUE(timer);
+
+  auto read = [](async::Prioritized<async::UnixStream>& reader, std::size_t i,
+                 std::vector<std::size_t>& order) -> async::Task<> {
+    auto buf = std::array<std::byte, 1> {};
+    auto n = co_await reader.recv(buf);
+    assert(n);
+    order.push_back(i);
+  };
+  for (std::size_t i = 0; i + 1 < readers.size(); i++) {
+    RT::SpawnDetach(read(readers[i], i, order));
+  }
+  RT::SpawnDetach([](async::TimerFd& timer, std::vector<async::UnixStream>& peers) -> async::Task<> {
+    auto r = co_await timer.sleepFor(10ms);
+    assert(r);
+    for (auto& peer : peers) {
+      auto n = ::write(peer.getSocket().raw(), "x", 1);
+      assert(n == 1);
+    }
+  }(timer.value(), peers));
+  RT::Block(read(readers.back(), readers.size() - 1, order));
+  // the rest was resumed by the same dispatch
+}
+} // namespace
+
+TEST(IoSchedulerTest, StrictResumesControlFirst)
+{
+  auto scheduler = async::IoScheduler::Create(RT::GetReactor());
+  ASSERT_TRUE(scheduler);
+  using enum async::IoClass;
+  auto order = std::vector<std::size_t>();
+  ASSERT_NO_FATAL_FAILURE(Resumptions(**scheduler, {Bulk, Bulk, Bulk, Interactive, Bulk, Bulk, Control}, order));
+  EXPECT_EQ(order, (std::vector<std::size_t> {6, 3, 0, 1, 2, 4, 5}));
+
+  auto control = (*scheduler)->stats(Control);
+  auto bulk = (*scheduler)->stats(Bulk);
+  EXPECT_EQ(control.resumed, 1);
+  EXPECT_EQ(bulk.resumed, 5);
+  EXPECT_GT(bulk.maxDelay, 0ns);
+  EXPECT_LE(control.maxDelay, bulk.maxDelay);
+  EXPECT_EQ((*scheduler)->queued(Bulk), 0);
+}
+
+TEST(IoSchedulerTest, WeightedInterleavesClasses)
+{
+  auto options = async::IoSchedulerOptions {};
+  options.policy = async::IoSchedulerOptions::Policy::Weighted;
+  options.weights = {2, 1, 1};
+  auto scheduler = async::IoScheduler::Create(RT::GetReactor(), options);
+  ASSERT_TRUE(scheduler);
+  using enum async::IoClass;
+  auto order = std::vector<std::size_t>();
+  ASSERT_NO_FATAL_FAILURE(Resumptions(**scheduler, {Bulk, Bulk, Bulk, Control, Control, Control, Control}, order));
+  EXPECT_EQ(order, (std::vector<std::size_t> {3, 4, 0, 5, 6, 1, 2}));
+}
+
+TEST(IoSchedulerTest, ImmediateOperationsYield)
+{
+  struct Bound {
+    std::size_t ops;
+    std::size_t bytes;
+    std::size_t readSize;
+    std::uint64_t queued; // of 6 reads
+  };
+  // every 4 operations, then every 10 bytes, that complete without waiting
+  for (auto bound : {Bound {4, 0, 1, 1}, Bound {0, 10, 4, 2}}) {
+    auto options = async::IoSchedulerOptions {};
+    options.immediateOps = bound.ops;
+    options.immediateBytes = bound.bytes;
+    auto scheduler = async::IoScheduler::Create(RT::GetReactor(), options);
+    ASSERT_TRUE(scheduler);
+    auto pair = async::UnixStream::Pair(RT::GetReactor());
+    ASSERT_TRUE(pair);
+    auto reader = async::Prioritized<async::UnixStream>::Create(**scheduler, std::move(pair->first),
+                                                                async::IoClass::Bulk);
+    ASSERT_TRUE(reader);
+    ASSERT_EQ(::write(pair->second.getSocket().raw(), "0123456789abcdefghijklmn", 24), 24);
+
+    auto received = std::size_t {0};
+    RT::Block([](async::Prioritized<async::UnixStream>& reader, std::size_t size,
+                 std::size_t& received) -> async::Task<> {
+      auto buf = std::array<std::byte, 4> {};
+      for (auto i = 0; i < 6; i++) {
+        auto n = co_await reader.recv(std::span(buf).first(size));
+        received += n ? std::size_t(*n) : 0;
+      }
+    }(*reader, bound.readSize, received));
+    EXPECT_EQ(received, 6 * bound.readSize);
+    // the data was there all along, so only the bounds queued the reads
+    EXPECT_EQ((*scheduler)->stats(async::IoClass::Bulk).resumed, bound.queued);
+  }
+}
+
+TEST(IoSchedulerTest, ClassMarksPackets)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto scheduler = async::IoScheduler::Create(RT::GetReactor());
+  ASSERT_TRUE(scheduler);
+  auto stream = async::Prioritized<async::UnixStream>::Create(**scheduler, std::move(pair->first),
+                                                              async::IoClass::Control);
+  ASSERT_TRUE(stream);
+  EXPECT_EQ(stream->stream().getSocket().getOption<int>(SOL_SOCKET, SO_PRIORITY).value(), 6);
+  ASSERT_TRUE(stream->setClass(async::IoClass::Bulk));
+  EXPECT_EQ(stream->stream().getSocket().getOption<int>(SOL_SOCKET, SO_PRIORITY).value(), 2);
+}
@@ -0,0 +1,180 @@
+#include <Async/Executor.hpp>
+#include <Async/Framed.hpp>
+#include <Async/MemoryStream.hpp>
+#include <Async/TlsOver.hpp>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <thread>
+
+#include "TlsTestUtil.hpp"
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+} // namespace
+
+TEST(MemoryStreamTest, RingWrapsAround)
+{
+  auto ring = async::detail::ByteRing(10); // rounded up to 16
+  EXPECT_EQ(ring.capacity(), 16);
+  auto in = std::vector<std::byte>(40);
+  std::iota(reinterpret_cast<unsigned char*>(in.data()), reinterpret_cast<unsigned char*>(in.data()) + 40, 0);
+  auto out = std::vector<std::byte>();
+  auto buf = std::array<std::byte, 7> {};
+  for (std::size_t written = 0; out.size() < in.size();) {
+    written += ring.write(std::span(in).subspan(written, std::min<std::size_t>(11, in.size() - written)));
+    auto n = ring.read(buf);
+    out.insert(out.end(), buf.begin(), buf.begin() + n);
+  }
+  EXPECT_EQ(out, in);
+}
+
+TEST(MemoryStreamTest, RingAcrossThreads)
+{
+  constexpr auto Total = std::size_t(1) << 20;
+  auto ring = async::detail::ByteRing(4096);
+  auto producer = std::thread([&] {
+    auto chunk = std::array<std::byte, 1000> {};
+    for (std::size_t sent = 0; sent < Total;) {
+      auto n = std::min(chunk.size(), Total - sent);
+      for (std::size_t i = 0; i < n; i++) {
+        chunk[i] = std::byte((sent + i) % 251);
+      }
+      for (std::size_t done = 0; done < n;) {
+        if (auto w = ring.write(std::span(chunk).subspan(done, n - done)); w != 0) {
+          done += w;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      sent += n;
+    }
+  });
+  auto ok = true;
+  auto buf = std::array<std::byte, 777> {};
+  for (std::size_t received = 0; received < Total;) {
+    auto n = ring.read(buf);
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      ok = ok && buf[i] == std::byte((received + i) % 251);
+    }
+    received += n;
+  }
+  producer.join();
+  EXPECT_TRUE(ok);
+}
+
+TEST(MemoryStreamTest, TransferWithBackpressureAndEof)
+{
+  constexpr static auto Total = std::size_t(1) << 20;
+  auto pair = async::MemoryStream::Pair(RT::GetReactor(), 4096);
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::MemoryStream stream) -> async::Task<> {
+    auto data = std::vector<std::byte>(Total);
+    for (std::size_t i = 0; i < Total; i++) {
+      data[i] = std::byte(i % 253);
+    }
+    co_await stream.sendAll(data);
+  }(std::move(pair->first)));
+
+  RT::Block([](async::MemoryStream stream) -> async::Task<> {
+    auto buf = std::array<std::byte, 3000> {};
+    auto received = std::size_t {0};
+    auto ok = true;
+    while (true) {
+      auto n = co_await stream.recv(buf);
+      if (!n && n.error() == std::errc::operation_would_block) {
+        continue;
+      }
+      EXPECT_TRUE(n);
+      if (!n || *n == 0) {
+        break;
+      }
+      for (ssize_t i = 0; i < *n; i++) {
+        ok = ok && buf[i] == std::byte((received + i) % 253);
+      }
+      received += std::size_t(*n);
+    }
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(received, Total);
+    EXPECT_EQ((co_await stream.send(buf)).error(), std::errc::broken_pipe);
+  }(std::move(pair->second)));
+}
+
+TEST(MemoryStreamTest, FramedOverMemory)
+{
+  auto pair = async::MemoryStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::MemoryStream stream) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream));
+    for (auto text : {"one"sv, "two"sv, "three"sv}) {
+      co_await framed.send(std::as_bytes(std::span(text)));
+    }
+  }(std::move(pair->first)));
+
+  RT::Block([](async::MemoryStream stream) -> async::Task<> {
+    auto framed = async::Framed(std::move(stream));
+    for (auto text : {"one"sv, "two"sv, "three"sv}) {
+      auto frame = co_await framed.next();
+      EXPECT_TRUE(frame && *frame);
+      if (!frame || !*frame) {
+        co_return;
+      }
+      EXPECT_EQ(std::string_view(reinterpret_cast<char const*>((*frame)->data()), (*frame)->size()), text);
+    }
+    auto end = co_await framed.next();
+    EXPECT_TRUE(end && !*end);
+  }(std::move(pair->second)));
+}
+
+TEST(MemoryStreamTest, TlsOverMemory)
+{
+  auto serverCtx = async::TlsContext::Create();
+  auto clientCtx = async::TlsContext::Create();
+  ASSERT_TRUE(serverCtx && clientCtx);
+  ASSERT_TRUE(UseSelfSigned(*serverCtx));
+  SSL_CTX_set_verify(clientCtx->raw(), SSL_VERIFY_NONE, nullptr);
+  // a small ring, so records larger than it have to wait for the peer to make room
+  auto pair = async::MemoryStream::Pair(RT::GetReactor(), 4096);
+  ASSERT_TRUE(pair);
+
+  // the server echoes one message and closes the TLS session
+  RT::SpawnDetach([](async::TlsContext& ctx, async::MemoryStream stream) -> async::Task<> {
+    auto tls = co_await async::TlsOver<async::MemoryStream>::Accept(ctx, std::move(stream));
+    EXPECT_TRUE(tls);
+    if (!tls) {
+      co_return;
+    }
+    auto buf = std::array<std::byte, 256> {};
+    auto n = co_await tls->recv(buf);
+    EXPECT_TRUE(n && *n > 0);
+    EXPECT_TRUE(co_await tls->sendAll(std::span(buf).first(std::size_t(n.value_or(0)))));
+    EXPECT_TRUE(co_await tls->shutdown());
+  }(*serverCtx, std::move(pair->first)));
+
+  RT::Block([](async::TlsContext& ctx, async::MemoryStream stream) -> async::Task<> {
+    auto tls = co_await async::TlsOver<async::MemoryStream>::Connect(ctx, std::move(stream));
+    EXPECT_TRUE(tls);
+    if (!tls) {
+      co_return;
+    }
+    EXPECT_NE(SSL_get_current_cipher(tls->ssl()), nullptr);
+    auto message = "over memory, not a socket"sv;
+    EXPECT_TRUE(co_await tls->sendAll(std::as_bytes(std::span(message))));
+    auto received = std::string();
+    auto buf = std::array<std::byte, 256> {};
+    while (true) {
+      auto n = co_await tls->recv(buf);
+      EXPECT_TRUE(n);
+      if (!n || *n == 0) { // 0 after the server's close_notify
+        break;
+      }
+      received.append(reinterpret_cast<char const*>(buf.data()), std::size_t(*n));
+    }
+    EXPECT_EQ(received, message);
+  }(*clientCtx, std::move(pair->second)));
+}
@@ -0,0 +1,67 @@
+#include <Async/Executor.hpp>
+#include <Async/RateLimiter.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+TEST(RateLimiterTest, BucketRefillsAtRate)
+{
+  auto limiter = async::RateLimiter::Create(100000, 20000);
+  auto now = async::RateLimiter::Clock::now();
+  EXPECT_EQ(limiter.take(50000, now).bytes, 20000); // starts with a full burst
+  auto empty = limiter.take(50000, now);
+  EXPECT_EQ(empty.bytes, 0);
+  EXPECT_NEAR(std::chrono::duration<double>(empty.wait).count(), 0.16384, 0.001); // until 16KB refilled
+  EXPECT_EQ(limiter.take(50000, now + 100ms).bytes, 0); // 10KB refilled, held back for 16KB
+  EXPECT_EQ(limiter.take(50000, now + 170ms).bytes, 17000);
+  limiter.refund(4000);
+  EXPECT_EQ(limiter.take(4000, now + 170ms).bytes, 4000);
+  EXPECT_EQ(limiter.take(50000, now + 10s).bytes, 20000); // never more than the burst
+}
+
+TEST(RateLimiterTest, GroupsAreShared)
+{
+  auto group = async::RateLimiter::Group("test-group", 1000);
+  EXPECT_EQ(async::RateLimiter::FindGroup("test-group")->rate(), 1000);
+  async::RateLimiter::Group("test-group", 2000);
+  EXPECT_EQ(group.rate(), 2000);
+  EXPECT_FALSE(async::RateLimiter::FindGroup("no-such-group"));
+  EXPECT_EQ(async::RateLimiter().take(123).bytes, 123); // default constructed limiters do not limit
+}
+
+TEST(RateLimiterTest, SendSuspendsUntilRefilled)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto shared = async::RateLimiter::Create(1 << 20, 64 << 10); // 1MB/s, 64KB burst
+  auto limited = async::RateLimited<async::UnixStream>::Create(
+      RT::GetReactor(), std::move(pair->first), {async::RateLimiter::Create(0), shared});
+  ASSERT_TRUE(limited);
+  auto elapsed = std::chrono::steady_clock::duration {};
+  RT::SpawnDetach([](async::RateLimited<async::UnixStream> stream, auto& elapsed) -> async::Task<> {
+    auto data = std::vector<std::byte>(32 << 10);
+    auto start = std::chrono::steady_clock::now();
+    auto sent = std::size_t {0};
+    while (sent < (320 << 10)) { // the burst plus 256KB at 1MB/s
+      auto n = co_await stream.send(data);
+      if (n) {
+        sent += std::size_t(*n);
+      }
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+  }(std::move(limited).value(), elapsed));
+
+  RT::Block([](async::UnixStream reader) -> async::Task<> {
+    auto buf = std::array<std::byte, 65536> {};
+    while (true) {
+      auto n = co_await reader.recv(buf);
+      if (n && *n == 0) {
+        break;
+      }
+    }
+  }(std::move(pair->second)));
+  EXPECT_GE(elapsed, 230ms);
+  EXPECT_LE(elapsed, 1s);
+}
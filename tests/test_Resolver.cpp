@@ -0,0 +1,191 @@
+#include <Async/Executor.hpp>
+#include <Async/Resolver.hpp>
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <sys/socket.h>
+#include <thread>
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+namespace {
+// Minimal authoritative server on 127.0.0.1: "a.test" has two A records with a 60s TTL, everything else is NXDOMAIN
+// with a 5s SOA minimum. Each answer is delayed a little so concurrent lookups overlap. A `truncated` server marks every
+// answer as truncated, so clients retry over TCP.
+class StubDnsServer {
+public:
+  explicit StubDnsServer(bool truncated = false) : mTruncated(truncated)
+  {
+    mFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    auto addr = sockaddr_in {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(mFd, (sockaddr*)&addr, sizeof(addr));
+    auto len = socklen_t(sizeof(addr));
+    ::getsockname(mFd, (sockaddr*)&addr, &len);
+    mPort = ntohs(addr.sin_port);
+    mThread = std::thread([this] { run(); });
+  }
+  ~StubDnsServer()
+  {
+    ::shutdown(mFd, SHUT_RDWR);
+    ::close(mFd);
+    mThread.join();
+  }
+  auto port() const -> uint16_t { return mPort; }
+  std::atomic<int> queries {0};
+
+private:
+  auto run() -> void
+  {
+    while (true) {
+      unsigned char buf[512];
+      auto peer = sockaddr_in {};
+      auto len = socklen_t(sizeof(peer));
+      auto n = ::recvfrom(mFd, buf, sizeof(buf), 0, (sockaddr*)&peer, &len);
+      if (n <= 12) {
+        return;
+      }
+      queries++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      auto out = std::vector<unsigned char>(buf, buf + n);
+      auto found = std::string_view((char*)buf + 12, n - 12).starts_with("\x01" "a\x04test");
+      out[2] = mTruncated ? 0x83 : 0x81;
+      out[3] = found ? 0x80 : 0x83;
+      if (found) {
+        out[7] = 2;
+        for (unsigned char last : {1, 2}) {
+          unsigned char rr[] = {0xc0, 12, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 10, 0, 0, last};
+          out.insert(out.end(), std::begin(rr), std::end(rr));
+        }
+      } else {
+        out[9] = 1;
+        unsigned char soa[] = {0xc0, 12, 0, 6, 0, 1, 0, 0, 0, 100, 0, 22, 0, 0, 0,    0, 0, 0,
+                               1,    0,  0, 0, 0, 0, 0, 0, 0, 0,   0, 0,  0, 0, 0, 0, 0, 5};
+        out.insert(out.end(), std::begin(soa), std::end(soa));
+      }
+      ::sendto(mFd, out.data(), out.size(), 0, (sockaddr*)&peer, len);
+    }
+  }
+  bool mTruncated;
+  int mFd;
+  uint16_t mPort;
+  std::thread mThread;
+};
+} // namespace
+
+TEST(ResolverTest, BuildAndParse)
+{
+  auto packet = std::vector<std::byte>();
+  ASSERT_TRUE(async::dns::BuildQuery(0x1234, "www.example.com", packet));
+  EXPECT_EQ(packet.size(), 12 + 17 + 4);
+  EXPECT_FALSE(async::dns::BuildQuery(1, "bad..name", packet));
+  auto answer = async::dns::Answer {};
+  packet.clear();
+  ASSERT_TRUE(async::dns::BuildQuery(0x1234, "www.example.com", packet));
+  EXPECT_FALSE(async::dns::ParseResponse(packet, packet, answer)); // not a response
+
+  // an empty answer to the query, with the question echoed back
+  auto response = packet;
+  response[2] |= std::byte(0x80);
+  EXPECT_TRUE(async::dns::ParseResponse(response, packet, answer));
+  EXPECT_TRUE(answer.addrs.empty());
+
+  auto other = response;
+  other[1] ^= std::byte(1);
+  EXPECT_FALSE(async::dns::ParseResponse(other, packet, answer)); // another ID
+  other = response;
+  other[13] = std::byte('v'); // "vww.example.com"
+  EXPECT_FALSE(async::dns::ParseResponse(other, packet, answer));
+  other = response;
+  other[other.size() - 3] = std::byte(28); // AAAA instead of A
+  EXPECT_FALSE(async::dns::ParseResponse(other, packet, answer));
+  other = response;
+  other[13] = std::byte('W'); // servers may change the case of the name
+  EXPECT_TRUE(async::dns::ParseResponse(other, packet, answer));
+}
+
+TEST(ResolverTest, StubServer)
+{
+  auto server = StubDnsServer();
+  auto options = async::ResolverOptions {};
+  options.nameservers = {async::SocketAddrV4::Localhost(server.port())};
+  options.hostsFile = "/nonexistent";
+  options.timeout = std::chrono::milliseconds(500);
+  RT::Init();
+  auto resolver = async::Resolver(RT::GetReactor(), options);
+
+  RT::Block([](async::Resolver& resolver, StubDnsServer& server) -> async::Task<> {
+    auto numeric = co_await resolver.resolve("127.0.0.1");
+    EXPECT_TRUE(numeric && numeric->size() == 1);
+
+    auto results = std::vector<async::StdResult<std::vector<async::Ipv4Addr>>>(3);
+    auto done = 0;
+    for (auto& result : results) {
+      RT::SpawnDetach([](async::Resolver& resolver, auto& result, int& done) -> async::Task<> {
+        result = co_await resolver.resolve("A.test.");
+        done++;
+      }(resolver, result, done));
+    }
+    auto first = co_await resolver.resolve("a.test");
+    EXPECT_TRUE(first && first->size() == 2);
+    EXPECT_EQ(server.queries, 1); // concurrent lookups were coalesced
+
+    auto missing = co_await resolver.resolve("missing.test");
+    EXPECT_EQ(missing.error(), std::errc::no_such_device_or_address);
+    missing = co_await resolver.resolve("missing.test");
+    EXPECT_FALSE(missing);
+    EXPECT_EQ(server.queries, 2); // negative answer served from the cache
+
+    EXPECT_EQ(done, 3);
+    for (auto& result : results) {
+      EXPECT_TRUE(result && result->size() == 2);
+    }
+  }(resolver, server));
+}
+
+TEST(ResolverTest, TcpFallbackTimesOut)
+{
+  auto server = StubDnsServer(true);
+  // a TCP listener on the same port that accepts connections but never answers
+  auto listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  auto addr = sockaddr_in {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(server.port());
+  ASSERT_EQ(::bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+  ASSERT_EQ(::listen(listener, 4), 0);
+
+  auto options = async::ResolverOptions {};
+  options.nameservers = {async::SocketAddrV4::Localhost(server.port())};
+  options.hostsFile = "/nonexistent";
+  options.timeout = std::chrono::milliseconds(200);
+  options.attempts = 1;
+  RT::Init();
+  auto resolver = async::Resolver(RT::GetReactor(), options);
+
+  auto start = std::chrono::steady_clock::now();
+  RT::Block([](async::Resolver& resolver) -> async::Task<> {
+    auto result = co_await resolver.resolve("a.test");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), std::errc::timed_out);
+  }(resolver));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  ::close(listener);
+}
+
+TEST(ResolverTest, Ipv6NameserverIsUnsupported)
+{
+  auto options = async::ResolverOptions {};
+  options.nameservers = {async::SocketAddrV6 {{{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}}, 53}};
+  options.hostsFile = "/nonexistent";
+  options.attempts = 1;
+  RT::Init();
+  auto resolver = async::Resolver(RT::GetReactor(), options);
+  RT::Block([](async::Resolver& resolver) -> async::Task<> {
+    auto result = co_await resolver.resolve("a.test");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error(), std::errc::address_family_not_supported);
+  }(resolver));
+}
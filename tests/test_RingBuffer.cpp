@@ -0,0 +1,97 @@
+#include <Async/Executor.hpp>
+#include <Async/RingBuffer.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <unistd.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+TEST(RingBufferTest, RoundsCapacityToPages)
+{
+  auto ring = async::RingBuffer::Create(1000);
+  ASSERT_TRUE(ring);
+  auto pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+  EXPECT_EQ(ring->capacity(), pageSize);
+  EXPECT_TRUE(ring->empty());
+  EXPECT_EQ(ring->writable().size(), pageSize);
+
+  auto larger = async::RingBuffer::Create(3 * pageSize);
+  ASSERT_TRUE(larger);
+  EXPECT_EQ(larger->capacity(), 4 * pageSize);
+}
+
+TEST(RingBufferTest, RegionsStayContiguousAcrossTheEnd)
+{
+  auto ring = async::RingBuffer::Create(4096);
+  ASSERT_TRUE(ring);
+  auto capacity = ring->capacity();
+  // move both positions close to the end
+  ring->commit(capacity - 10);
+  ring->consume(capacity - 10);
+  EXPECT_TRUE(ring->empty());
+
+  auto message = std::string(100, '\0');
+  for (std::size_t i = 0; i < message.size(); i++) {
+    message[i] = char('a' + i % 26);
+  }
+  auto writable = ring->writable();
+  ASSERT_EQ(writable.size(), capacity);
+  std::memcpy(writable.data(), message.data(), message.size());
+  ring->commit(message.size());
+
+  auto readable = ring->readable();
+  ASSERT_EQ(readable.size(), message.size());
+  EXPECT_EQ(std::string(reinterpret_cast<char const*>(readable.data()), readable.size()), message);
+  // the part past the end landed at the start of the buffer
+  auto start = readable.data() + 10 - capacity;
+  EXPECT_EQ(std::memcmp(start, message.data() + 10, 90), 0);
+
+  ring->consume(message.size());
+  ring->commit(capacity);
+  EXPECT_TRUE(ring->full());
+  EXPECT_TRUE(ring->writable().empty());
+}
+
+TEST(RingBufferTest, RecvAndSendWithTheSpans)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto ring = async::RingBuffer::Create(4096);
+  ASSERT_TRUE(ring);
+  RT::Block([](async::UnixStream& a, async::UnixStream& b, async::RingBuffer& ring) -> async::Task<> {
+    auto capacity = ring.capacity();
+    ring.commit(capacity - 3); // the next recv wraps
+    ring.consume(capacity - 3);
+    EXPECT_EQ((co_await a.send(std::as_bytes(std::span("hello world", 11)))).value(), 11);
+    co_await b.readable();
+    auto n = co_await b.recv(ring.writable());
+    EXPECT_EQ(n.value(), 11);
+    ring.commit(std::size_t(n.value()));
+    auto echoed = co_await b.send(ring.readable());
+    EXPECT_EQ(echoed.value(), 11);
+    ring.consume(std::size_t(echoed.value()));
+    auto buf = std::array<char, 16> {};
+    auto back = co_await a.recv(std::as_writable_bytes(std::span(buf)));
+    EXPECT_EQ(std::string(buf.data(), std::size_t(back.value())), "hello world");
+  }(pair->first, pair->second, ring.value()));
+  EXPECT_TRUE(ring->empty());
+}
+
+TEST(RingBufferTest, HugePagesFallBack)
+{
+  // without huge pages reserved on the system this gets normal pages
+  auto ring = async::RingBuffer::Create(4096, {.hugePages = true});
+  ASSERT_TRUE(ring);
+  EXPECT_GE(ring->capacity(), 4096);
+  if (ring->hugePages()) {
+    EXPECT_EQ(ring->capacity(), 2 << 20);
+  }
+  ring->writable()[0] = std::byte {42};
+  ring->commit(1);
+  EXPECT_EQ(ring->readable()[0], std::byte {42});
+
+  auto moved = std::move(ring).value();
+  EXPECT_EQ(moved.size(), 1);
+}
@@ -0,0 +1,262 @@
+#include <Async/Detached.hpp>
+#include <Async/Executor.hpp>
+#include <Async/SendQueue.hpp>
+#include <Async/TimerFd.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <optional>
+#include <thread>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+struct Node {
+  Node* next;
+  int producer;
+  int seq;
+};
+} // namespace
+
+TEST(SendQueueTest, MpscListKeepsPerProducerOrder)
+{
+  constexpr auto Producers = 4;
+  constexpr auto PerProducer = 20000;
+  auto list = async::detail::MpscList<Node> {};
+  auto threads = std::vector<std::thread>();
+  for (int p = 0; p < Producers; p++) {
+    threads.emplace_back([&list, p] {
+      for (int i = 0; i < PerProducer; i++) {
+        list.push(new Node {nullptr, p, i});
+      }
+    });
+  }
+  int next[Producers] = {};
+  auto taken = 0;
+  while (taken < Producers * PerProducer) {
+    for (auto node = list.takeAll(); node != nullptr;) {
+      EXPECT_EQ(node->seq, next[node->producer]++);
+      taken++;
+      delete std::exchange(node, node->next);
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(list.empty());
+}
+
+TEST(SendQueueTest, MessagesStayWhole)
+{
+  constexpr auto Producers = 3;
+  constexpr auto Messages = 200;
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto queue = async::SendQueue(writer);
+
+  for (int p = 0; p < Producers; p++) {
+    RT::SpawnDetach([](async::SendQueue& queue, int p) -> async::Task<> {
+      for (int i = 0; i < Messages; i++) {
+        // [producer][seq][length] header followed by a body of 1..4096 bytes
+        auto length = 1 + (i * 977 + p * 131) % 4096;
+        auto message = std::vector<std::byte>(8 + length, std::byte(p));
+        message[0] = std::byte(p);
+        message[1] = std::byte(i);
+        message[2] = std::byte(i >> 8);
+        message[4] = std::byte(length);
+        message[5] = std::byte(length >> 8);
+        EXPECT_TRUE(co_await queue.send(std::move(message)));
+      }
+    }(queue, p));
+  }
+
+  auto received = std::vector<std::byte>();
+  RT::Block([](async::UnixStream& reader, std::vector<std::byte>& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    auto expected = std::size_t(0);
+    for (int p = 0; p < Producers; p++) {
+      for (int i = 0; i < Messages; i++) {
+        expected += 8 + 1 + (i * 977 + p * 131) % 4096;
+      }
+    }
+    while (received.size() < expected) {
+      auto n = co_await reader.recv(buf);
+      if (!n || *n == 0) {
+        break;
+      }
+      received.insert(received.end(), buf.begin(), buf.begin() + *n);
+    }
+  }(reader, received));
+
+  int next[Producers] = {};
+  for (std::size_t pos = 0; pos + 8 <= received.size();) {
+    auto p = int(received[pos]);
+    auto seq = int(received[pos + 1]) | int(received[pos + 2]) << 8;
+    auto length = std::size_t(received[pos + 4]) | std::size_t(received[pos + 5]) << 8;
+    ASSERT_LT(p, Producers);
+    EXPECT_EQ(seq, next[p]++);
+    ASSERT_LE(pos + 8 + length, received.size());
+    EXPECT_TRUE(std::all_of(&received[pos + 8], &received[pos + 8] + length, [&](auto b) { return int(b) == p; }));
+    pos += 8 + length;
+  }
+  for (int p = 0; p < Producers; p++) {
+    EXPECT_EQ(next[p], Messages);
+  }
+}
+
+TEST(SendQueueTest, WriterReturnsOnceItsMessageIsOut)
+{
+  constexpr auto Large = std::size_t(1) << 20; // more than the socket buffer takes, so the writer has to wait
+  constexpr auto Small = 400;
+  constexpr auto SmallSize = std::size_t(4096);
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto queue = async::SendQueue(writer);
+
+  auto received = std::vector<std::byte>();
+  auto receivedWhenDone = std::optional<std::size_t>();
+  RT::SpawnDetach([](async::SendQueue& queue, std::vector<std::byte>& received,
+                     std::optional<std::size_t>& receivedWhenDone) -> async::Task<> {
+    EXPECT_TRUE(co_await queue.send(std::vector<std::byte>(Large, std::byte(1))));
+    receivedWhenDone = received.size();
+  }(queue, received, receivedWhenDone));
+  // queued behind the large message while the writer waits
+  for (int i = 0; i < Small; i++) {
+    RT::SpawnDetach([](async::SendQueue& queue) -> async::Task<> {
+      EXPECT_TRUE(co_await queue.send(std::vector<std::byte>(SmallSize, std::byte(2))));
+    }(queue));
+  }
+
+  RT::Block([](async::UnixStream& reader, std::vector<std::byte>& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    while (received.size() < Large + Small * SmallSize) {
+      auto n = co_await reader.recv(buf);
+      if (!n || *n == 0) {
+        break;
+      }
+      received.insert(received.end(), buf.begin(), buf.begin() + *n);
+    }
+  }(reader, received));
+
+  EXPECT_EQ(received.size(), Large + Small * SmallSize);
+  // the writer left with at most one batch of the small messages sent, a drain task of the queue wrote the rest
+  ASSERT_TRUE(receivedWhenDone);
+  EXPECT_LE(*receivedWhenDone, Large + async::SendQueue::MaxBatch * SmallSize);
+}
+
+TEST(SendQueueTest, NoMessageLostAcrossThreads)
+{
+  constexpr auto Producers = 4;
+  constexpr auto Messages = 5000;
+  constexpr auto MessageSize = std::size_t(8);
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto timer = async::TimerFd::Create(RT::GetReactor());
+  ASSERT_TRUE(timer);
+  auto queue = async::SendQueue(writer);
+
+  // every producer thread runs its sends itself, so the writer role changes hands between threads all the time
+  auto threads = std::vector<std::thread>();
+  for (int p = 0; p < Producers; p++) {
+    threads.emplace_back([&queue, p] {
+      for (int i = 0; i < Messages; i++) {
+        auto message = std::vector<std::byte>(MessageSize);
+        message[0] = std::byte(p);
+        message[1] = std::byte(i);
+        message[2] = std::byte(i >> 8);
+        async::detail::Detach([](async::SendQueue& queue, std::vector<std::byte> message) -> async::Task<> {
+          EXPECT_TRUE(co_await queue.send(std::move(message)));
+        }(queue, std::move(message)))
+            .handle.resume();
+      }
+    });
+  }
+
+  // reads without waiting on the socket, so a message stuck in the queue shows up as a timeout instead of a hang
+  auto received = std::vector<std::byte>();
+  RT::Block([](async::UnixStream& reader, async::TimerFd& timer, std::vector<std::byte>& received) -> async::Task<> {
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    auto buf = std::array<std::byte, 8192> {};
+    while (received.size() < Producers * Messages * MessageSize && std::chrono::steady_clock::now() < deadline) {
+      auto n = reader.getSocket().recvNonBlock(buf, 0);
+      if (n && *n > 0) {
+        received.insert(received.end(), buf.begin(), buf.begin() + *n);
+      } else {
+        auto r = co_await timer.sleepFor(1ms);
+        assert(r);
+      }
+    }
+    auto r = co_await timer.sleepFor(10ms); // lets the last writer leave its loop
+    assert(r);
+  }(reader, timer.value(), received));
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(received.size(), Producers * Messages * MessageSize);
+  int next[Producers] = {};
+  for (std::size_t pos = 0; pos < received.size(); pos += MessageSize) {
+    auto p = int(received[pos]);
+    ASSERT_LT(p, Producers);
+    EXPECT_EQ(int(received[pos + 1]) | int(received[pos + 2]) << 8, next[p]++);
+  }
+}
+
+TEST(SendQueueTest, DrainFailsWhileOthersSubmit)
+{
+  constexpr auto Producers = 4;
+  constexpr auto Messages = 20000;
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto timer = async::TimerFd::Create(RT::GetReactor());
+  ASSERT_TRUE(timer);
+  auto queue = async::SendQueue(writer);
+
+  // the reader goes away while the producer threads keep submitting, so the writer of the moment fails
+  auto done = std::atomic<int> {0};
+  auto failed = std::atomic<int> {0};
+  auto threads = std::vector<std::thread>();
+  for (int p = 0; p < Producers; p++) {
+    threads.emplace_back([&queue, &done, &failed] {
+      for (int i = 0; i < Messages; i++) {
+        async::detail::Detach([](async::SendQueue& queue, std::atomic<int>& done,
+                                 std::atomic<int>& failed) -> async::Task<> {
+          if (auto r = co_await queue.send(std::vector<std::byte>(64)); !r) {
+            EXPECT_EQ(r.error(), std::errc::broken_pipe);
+            failed++;
+          }
+          done++;
+        }(queue, done, failed))
+            .handle.resume();
+      }
+    });
+  }
+
+  RT::Block([](async::UnixStream& reader, async::TimerFd& timer, std::atomic<int>& done) -> async::Task<> {
+    auto r = co_await timer.sleepFor(5ms);
+    assert(r);
+    ::shutdown(reader.getSocket().raw(), SHUT_RDWR);
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (done < Producers * Messages && std::chrono::steady_clock::now() < deadline) {
+      r = co_await timer.sleepFor(1ms);
+      assert(r);
+    }
+  }(reader, timer.value(), done));
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // every send completed, none was left waiting on a writer that is gone
+  EXPECT_EQ(done, Producers * Messages);
+  EXPECT_GT(failed, 0);
+  RT::Block([](async::SendQueue& queue) -> async::Task<> {
+    auto r = co_await queue.send(std::vector<std::byte>(64));
+    EXPECT_FALSE(r);
+  }(queue));
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 
 TEST(SocketAddrTest, SocketAddrV4)
 {
@@ -21,4 +22,42 @@ TEST(SocketAddrTest, SocketAddrV4)
   EXPECT_NE(r, -1);
   EXPECT_EQ(uint32_t(addr.getIpv4().addr), inet_addr(addrStr));
   EXPECT_EQ(std::string(inet_ntoa({addr2})), std::string(string.data(), 9));
-}
\ No newline at end of file
+}
+TEST(SocketAddrTest, SocketAddrUnix)
+{
+  auto path = async::SocketAddr(async::SocketAddrUnix::Path("/tmp/async.sock").value());
+  EXPECT_TRUE(path.isUnix());
+  EXPECT_EQ(path.toString(), "/tmp/async.sock");
+  auto storage = sockaddr_storage {};
+  auto len = socklen_t {};
+  ASSERT_TRUE(async::impl::SocketAddrToSockAddr(path, &storage, &len));
+  auto un = reinterpret_cast<sockaddr_un const*>(&storage);
+  EXPECT_EQ(un->sun_family, AF_UNIX);
+  EXPECT_STREQ(un->sun_path, "/tmp/async.sock");
+
+  auto abstract = async::SocketAddr(async::SocketAddrUnix::Abstract("async").value());
+  EXPECT_EQ(abstract.toString(), "@async");
+  ASSERT_TRUE(async::impl::SocketAddrToSockAddr(abstract, &storage, &len));
+  EXPECT_EQ(un->sun_path[0], '\0');
+  EXPECT_EQ(std::string_view(un->sun_path + 1, 5), "async");
+  EXPECT_EQ(len, offsetof(sockaddr_un, sun_path) + 6); // no trailing NUL for abstract names
+}
+
+TEST(SocketAddrTest, SocketAddrUnixBounds)
+{
+  using async::SocketAddrUnix;
+  auto longest = std::string(SocketAddrUnix::MaxPath, 'x');
+  EXPECT_TRUE(SocketAddrUnix::Path(longest));
+  EXPECT_EQ(SocketAddrUnix::Path(longest + "x").error(), std::errc::filename_too_long);
+  EXPECT_EQ(SocketAddrUnix::Path("").error(), std::errc::invalid_argument);
+
+  // an abstract name has no terminating NUL, so it may be as long as a path
+  auto abstract = SocketAddrUnix::Abstract(longest);
+  ASSERT_TRUE(abstract);
+  EXPECT_EQ(SocketAddrUnix::Abstract(longest + "x").error(), std::errc::filename_too_long);
+  auto storage = sockaddr_storage {};
+  auto len = socklen_t {};
+  ASSERT_TRUE(async::impl::SocketAddrToSockAddr(async::SocketAddr(*abstract), &storage, &len));
+  EXPECT_EQ(len, sizeof(sockaddr_un));
+  EXPECT_EQ(std::string_view(reinterpret_cast<sockaddr_un const*>(&storage)->sun_path + 1, longest.size()), longest);
+}
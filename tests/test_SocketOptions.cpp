@@ -0,0 +1,65 @@
+#include <Async/sys/SocketOptions.hpp>
+#include <Async/sys/unix/Socket.hpp>
+#include <gtest/gtest.h>
+
+#include <netinet/tcp.h>
+
+using async::impl::Socket;
+
+TEST(SocketOptionsTest, LowLatency)
+{
+  auto socket = Socket::CreateNonBlock(async::SocketAddrV4::Localhost(0));
+  ASSERT_TRUE(socket);
+  ASSERT_TRUE(socket->applyStreamOptions(async::SocketOptions::LowLatency()));
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_NODELAY).value(), 1);
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_NOTSENT_LOWAT).value(), 16 << 10);
+  EXPECT_EQ(socket->getOption<int>(SOL_SOCKET, SO_KEEPALIVE).value(), 0);
+  socket->close();
+}
+
+TEST(SocketOptionsTest, KeepAliveAndBuffers)
+{
+  auto socket = Socket::CreateNonBlock(async::SocketAddrV4::Localhost(0));
+  ASSERT_TRUE(socket);
+  auto options = async::SocketOptions {};
+  options.sendBuffer = 64 << 10;
+  options.keepAlive = async::KeepAlive {std::chrono::seconds(30), std::chrono::seconds(5), 3};
+  ASSERT_TRUE(socket->applyStreamOptions(options));
+  EXPECT_GE(socket->getOption<int>(SOL_SOCKET, SO_SNDBUF).value(), 64 << 10); // the kernel doubles the request
+  EXPECT_EQ(socket->getOption<int>(SOL_SOCKET, SO_KEEPALIVE).value(), 1);
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_KEEPIDLE).value(), 30);
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_KEEPINTVL).value(), 5);
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_KEEPCNT).value(), 3);
+  socket->close();
+}
+
+TEST(SocketOptionsTest, PriorityAndTos)
+{
+  auto socket = Socket::CreateNonBlock(async::SocketAddrV4::Localhost(0));
+  ASSERT_TRUE(socket);
+  auto options = async::SocketOptions {};
+  options.priority = 6;
+  options.tos = 0xb8; // DSCP EF
+  ASSERT_TRUE(socket->applyStreamOptions(options));
+  EXPECT_EQ(socket->getOption<int>(SOL_SOCKET, SO_PRIORITY).value(), 6);
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_IP, IP_TOS).value(), 0xb8);
+  socket->close();
+}
+
+TEST(SocketOptionsTest, ListenerOptions)
+{
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(0));
+  auto socket = Socket::CreateNonBlock(addr);
+  ASSERT_TRUE(socket);
+  auto options = async::SocketOptions {};
+  options.reusePort = true;
+  options.deferAccept = std::chrono::seconds(5);
+  options.fastOpenQueue = 64;
+  ASSERT_TRUE(socket->applyListenerOptions(options));
+  ASSERT_TRUE(socket->bind(addr));
+  ASSERT_TRUE(socket->listen(options.backlog));
+  EXPECT_EQ(socket->getOption<int>(SOL_SOCKET, SO_REUSEPORT).value(), 1);
+  EXPECT_GT(socket->getOption<int>(IPPROTO_TCP, TCP_DEFER_ACCEPT).value(), 0); // rounded to retransmit periods
+  EXPECT_EQ(socket->getOption<int>(IPPROTO_TCP, TCP_FASTOPEN).value(), 64);
+  socket->close();
+}
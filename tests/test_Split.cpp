@@ -0,0 +1,181 @@
+#include <Async/Detached.hpp>
+#include <Async/Executor.hpp>
+#include <Async/SslListener.hpp>
+#include <Async/SslStream.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "TlsTestUtil.hpp"
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+namespace {
+// Echoes `total` bytes over a TLS connection, through the two halves of its server end at the same time: the write
+// half sends from its own task, started on another thread when `crossThread` is set, while the read half receives the
+// echo. The server end is lean-idle, so reads also go through its readiness gate, and the client keeps requesting key
+// updates, so reads also write. Returns the bytes received.
+auto TlsEcho(std::uint16_t port, std::size_t total, bool crossThread) -> std::size_t
+{
+  auto serverCtx = async::TlsContext::Create();
+  auto clientCtx = async::TlsContext::Create();
+  assert(serverCtx && clientCtx);
+  auto ok = UseSelfSigned(*serverCtx);
+  assert(ok);
+  SSL_CTX_set_verify(clientCtx->raw(), SSL_VERIFY_NONE, nullptr);
+  serverCtx->setLeanIdle(true);
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(port));
+  auto listener = async::SslListener::Bind(*serverCtx, RT::GetReactor(), addr);
+  assert(listener);
+
+  auto received = std::size_t(0);
+  RT::SpawnDetach([](async::SslListener& listener, async::TlsContext& ctx, std::size_t total, bool crossThread,
+                     std::size_t& received) -> async::Task<> {
+    auto socket = co_await listener.accept(ctx, nullptr);
+    assert(socket);
+    auto [read, write] = async::SslStream(std::move(socket).value()).split();
+    auto writeAll = [](async::WriteHalf<async::SslStream>& write, std::size_t total) -> async::Task<> {
+      auto chunk = std::vector<std::byte>(16 << 10);
+      for (std::size_t sent = 0; sent < total;) {
+        std::fill(chunk.begin(), chunk.end(), std::byte(sent >> 14));
+        auto n = co_await write.send(std::span(chunk).first(std::min(chunk.size(), total - sent)));
+        if (!n && n.error().wait()) {
+          continue;
+        } else if (!n) {
+          co_return;
+        }
+        sent += *n;
+      }
+    };
+    auto writer = std::thread();
+    if (crossThread) { // runs up to its first wait there, the reactor resumes it on this thread afterwards
+      writer = std::thread([&] { async::detail::Detach(writeAll(write, total)).handle.resume(); });
+    } else {
+      RT::SpawnDetach(writeAll(write, total));
+    }
+    auto buf = std::array<std::byte, 8192> {};
+    while (received < total) {
+      auto n = co_await read.recv(buf);
+      if (!n && n.error().wait()) {
+        continue;
+      } else if (!n || *n == 0) {
+        break;
+      }
+      for (std::size_t i = 0; i < *n; i++) {
+        EXPECT_EQ(buf[i], std::byte((received + i) >> 14));
+      }
+      received += *n;
+    }
+    if (writer.joinable()) {
+      writer.join();
+    }
+  }(*listener, *serverCtx, total, crossThread, received));
+
+  // the client closes only after the server did, a reset would drop what the server did not read yet
+  RT::Block([](async::TlsContext& ctx, async::SocketAddr addr, std::size_t total) -> async::Task<> {
+    auto stream = co_await async::SslStream::Connect(ctx, RT::GetReactor(), addr);
+    assert(stream);
+    auto buf = std::array<std::byte, 8192> {};
+    for (std::size_t echoed = 0; echoed < total;) {
+      auto n = co_await stream->recv(buf);
+      if (!n && n.error().wait()) {
+        continue;
+      } else if (!n || *n == 0 || !co_await stream->sendAll(std::span(buf).first(*n))) {
+        co_return;
+      }
+      if ((echoed + *n) >> 16 != echoed >> 16) {
+        // the server's next SSL_read then has to write its own key update, while its write half is sending
+        SSL_key_update(stream->ssl(), SSL_KEY_UPDATE_REQUESTED);
+      }
+      echoed += *n;
+    }
+    while (true) {
+      if (auto n = co_await stream->recv(buf); !n && n.error().wait()) {
+        continue;
+      }
+      break;
+    }
+  }(*clientCtx, addr, total));
+  return received;
+}
+} // namespace
+
+TEST(SplitTest, ConcurrentReadAndWrite)
+{
+  constexpr auto Total = std::size_t(1) << 20;
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto [read, write] = std::move(pair->first).split();
+  auto& peer = pair->second;
+
+  // the peer echoes everything back, both halves of the split end stay busy at the same time
+  RT::SpawnDetach([](async::UnixStream& peer) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    for (std::size_t echoed = 0; echoed < Total;) {
+      auto n = co_await peer.recv(buf);
+      if (!n || *n == 0) {
+        co_return;
+      }
+      for (ssize_t sent = 0; sent < *n;) {
+        auto m = co_await peer.send(std::span(buf).subspan(sent, *n - sent));
+        if (!m) {
+          co_return;
+        }
+        sent += *m;
+      }
+      echoed += std::size_t(*n);
+    }
+  }(peer));
+  RT::SpawnDetach([](async::WriteHalf<async::UnixStream>& write) -> async::Task<> {
+    auto chunk = std::vector<std::byte>(64 << 10);
+    for (std::size_t sent = 0; sent < Total;) {
+      std::fill(chunk.begin(), chunk.end(), std::byte(sent >> 16));
+      auto n = co_await write.send(std::span(chunk).first(std::min(chunk.size(), Total - sent)));
+      if (!n) {
+        co_return;
+      }
+      sent += std::size_t(*n);
+    }
+  }(write));
+
+  auto received = std::size_t(0);
+  RT::Block([](async::ReadHalf<async::UnixStream>& read, std::size_t& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    while (received < Total) {
+      auto n = co_await read.recv(buf);
+      if (!n || *n == 0) {
+        co_return;
+      }
+      received += std::size_t(*n);
+    }
+  }(read, received));
+  EXPECT_EQ(received, Total);
+
+  auto stream = std::move(read).reunite(std::move(write));
+  ASSERT_TRUE(stream);
+  EXPECT_TRUE(stream->valid());
+}
+
+TEST(SplitTest, ReuniteRejectsForeignHalf)
+{
+  auto first = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(first);
+  auto [read1, write1] = std::move(first->first).split();
+  auto [read2, write2] = std::move(first->second).split();
+  auto r = std::move(read1).reunite(std::move(write2));
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error(), std::errc::invalid_argument);
+}
+
+TEST(SplitTest, TlsConcurrentReadAndWrite)
+{
+  constexpr auto Total = std::size_t(1) << 20;
+  EXPECT_EQ(TlsEcho(39591, Total, false), Total);
+}
+
+TEST(SplitTest, TlsHalvesOnDifferentThreads)
+{
+  constexpr auto Total = std::size_t(1) << 20;
+  EXPECT_EQ(TlsEcho(39592, Total, true), Total);
+}
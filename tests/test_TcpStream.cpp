@@ -0,0 +1,148 @@
+#include <Async/Executor.hpp>
+#include <Async/TcpListener.hpp>
+#include <Async/TcpStream.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <net/if.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+// Whether this process may create network namespaces, tried in a child so the test process stays where it is.
+auto CanUnshareNetwork() -> bool
+{
+  auto pid = ::fork();
+  if (pid == 0) {
+    ::_exit(::unshare(CLONE_NEWNET) == 0 ? 0 : 1);
+  }
+  auto status = 0;
+  return pid > 0 && ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Moves the calling thread into a network namespace of its own, with loopback up and net.ipv4.tcp_fastopen set to
+// `mode` (1: client, 2: server, 3: both), so the test neither depends on nor changes the host's setting.
+auto OwnNetwork(int mode) -> bool
+{
+  if (::unshare(CLONE_NEWNET) != 0) {
+    return false;
+  }
+  auto sysctl = std::ofstream("/proc/sys/net/ipv4/tcp_fastopen");
+  sysctl << mode << std::flush;
+  auto fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  auto ifr = ifreq {};
+  std::strcpy(ifr.ifr_name, "lo");
+  auto up = fd >= 0 && ::ioctl(fd, SIOCGIFFLAGS, &ifr) == 0;
+  ifr.ifr_flags |= IFF_UP;
+  up = up && ::ioctl(fd, SIOCSIFFLAGS, &ifr) == 0;
+  ::close(fd);
+  return sysctl.good() && up;
+}
+
+struct Connection {
+  std::size_t sent = 0;
+  std::string received; // by the server
+  bool synData = false; // the server acknowledged data in the SYN
+};
+
+// Makes `count` connections with ConnectFastOpen, one after the other, each sending "hello" and reading until the
+// server closes. The listener allows Fast Open requests.
+auto FastOpenConnections(std::size_t count) -> std::vector<Connection>
+{
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(39601));
+  auto options = async::SocketOptions {};
+  options.fastOpenQueue = 16;
+  auto listener = async::TcpListener::Bind(RT::GetReactor(), addr, options);
+  assert(listener);
+  auto connections = std::vector<Connection>(count);
+  RT::SpawnDetach([](async::TcpListener& listener, std::vector<Connection>& connections) -> async::Task<> {
+    for (auto& connection : connections) {
+      auto accepted = co_await listener.accept(nullptr);
+      if (!accepted) {
+        co_return;
+      }
+      auto stream = async::TcpStream(std::move(accepted).value());
+      auto buf = std::array<std::byte, 64> {};
+      for (auto n = co_await stream.recv(buf); n && n.value() > 0; n = co_await stream.recv(buf)) {
+        connection.received.append(reinterpret_cast<char const*>(buf.data()), std::size_t(n.value()));
+      }
+    }
+  }(*listener, connections));
+  RT::Block([](async::SocketAddr const& addr, std::vector<Connection>& connections) -> async::Task<> {
+    for (auto& connection : connections) {
+      auto connected = co_await async::TcpStream::ConnectFastOpen(RT::GetReactor(), addr,
+                                                                  std::as_bytes(std::span("hello"sv)));
+      if (!connected) {
+        co_return;
+      }
+      auto& [stream, sent] = *connected;
+      connection.sent = sent;
+      auto r = stream.shutdownWrite();
+      assert(r);
+      auto buf = std::array<std::byte, 1> {};
+      auto eof = co_await stream.recv(buf);
+      assert(eof && eof.value() == 0);
+      auto info = stream.getSocket().getOption<tcp_info>(IPPROTO_TCP, TCP_INFO);
+      connection.synData = info && (info->tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+    }
+  }(addr, connections));
+  return connections;
+}
+
+// Exits with 0 if the connections went as expected, otherwise with 1 after describing the first difference.
+auto ExitWith(std::vector<Connection> const& connections, std::vector<bool> const& synData) -> void
+{
+  for (std::size_t i = 0; i < connections.size(); i++) {
+    auto& c = connections[i];
+    if (c.sent != 5 || c.received != "hello" || c.synData != synData[i]) {
+      std::fprintf(stderr, "connection %zu: sent %zu, received '%s', data in SYN %d\n", i, c.sent, c.received.c_str(),
+                   int(c.synData));
+      std::exit(1);
+    }
+  }
+  std::exit(0);
+}
+} // namespace
+
+TEST(TcpStreamTest, FastOpenUsesCookieOnceCached)
+{
+  if (!CanUnshareNetwork()) {
+    GTEST_SKIP() << "needs CAP_SYS_ADMIN for a network namespace";
+  }
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  // the first connection has no cookie, so ConnectFastOpen sees EINPROGRESS, waits for the handshake and sends
+  // afterwards; the second one sends its data in the SYN
+  EXPECT_EXIT(
+      {
+        if (!OwnNetwork(3)) {
+          std::exit(2);
+        }
+        ExitWith(FastOpenConnections(2), {false, true});
+      },
+      ::testing::ExitedWithCode(0), "");
+}
+
+TEST(TcpStreamTest, FastOpenFallsBackWhenClientDisabled)
+{
+  if (!CanUnshareNetwork()) {
+    GTEST_SKIP() << "needs CAP_SYS_ADMIN for a network namespace";
+  }
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  // with client Fast Open off, sendto(MSG_FASTOPEN) fails with EOPNOTSUPP and ConnectFastOpen connects normally
+  EXPECT_EXIT(
+      {
+        if (!OwnNetwork(2)) {
+          std::exit(2);
+        }
+        ExitWith(FastOpenConnections(2), {false, false});
+      },
+      ::testing::ExitedWithCode(0), "");
+}
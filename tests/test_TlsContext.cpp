@@ -0,0 +1,130 @@
+#include <Async/Executor.hpp>
+#include <Async/SslListener.hpp>
+#include <Async/SslStream.hpp>
+#include <Async/TlsContext.hpp>
+#include <gtest/gtest.h>
+
+#include "TlsTestUtil.hpp"
+
+using namespace std::literals;
+using Clock = async::detail::RecordSizer::Clock;
+using RT = async::Runtime<async::InlineExecutor>;
+
+namespace {
+// Collects the length of every application data record `ssl` writes, as found in the record header.
+auto RecordLengths(SSL* ssl, std::vector<std::size_t>& lengths) -> void
+{
+  SSL_set_msg_callback_arg(ssl, &lengths);
+  SSL_set_msg_callback(ssl, [](int write, int, int type, void const* buf, size_t len, SSL*, void* arg) {
+    auto header = static_cast<unsigned char const*>(buf);
+    if (write && type == SSL3_RT_HEADER && len == SSL3_RT_HEADER_LENGTH && header[0] == SSL3_RT_APPLICATION_DATA) {
+      static_cast<std::vector<std::size_t>*>(arg)->push_back(header[3] << 8 | header[4]);
+    }
+  });
+}
+} // namespace
+
+TEST(TlsRecordSizingTest, GrowsAfterBoostThreshold)
+{
+  auto sizer = async::detail::RecordSizer({.boostAfter = 4096});
+  auto now = Clock::now();
+  EXPECT_EQ(sizer.next(now), 1400);
+  sizer.sent(4000);
+  EXPECT_EQ(sizer.next(now), 1400);
+  sizer.sent(96);
+  EXPECT_EQ(sizer.next(now), std::size_t(SSL3_RT_MAX_PLAIN_LENGTH));
+}
+
+TEST(TlsRecordSizingTest, ShrinksAfterIdle)
+{
+  auto sizer = async::detail::RecordSizer({.boostAfter = 1024, .idleReset = 100ms});
+  auto now = Clock::now();
+  sizer.next(now);
+  sizer.sent(2048);
+  EXPECT_EQ(sizer.next(Clock::now() + 50ms), std::size_t(SSL3_RT_MAX_PLAIN_LENGTH));
+  EXPECT_EQ(sizer.next(Clock::now() + 1s), 1400);
+}
+
+TEST(TlsContextTest, RecordSizingDefaults)
+{
+  auto ctx = async::TlsContext::Create();
+  ASSERT_TRUE(ctx);
+  EXPECT_FALSE(ctx->recordSizing().enabled); // opt-in
+  ctx->setRecordSizing({.enabled = true});
+  EXPECT_TRUE(ctx->recordSizing().enabled);
+}
+
+TEST(TlsContextTest, LeanIdleReleasesBuffers)
+{
+  auto ctx = async::TlsContext::Create();
+  ASSERT_TRUE(ctx);
+  EXPECT_FALSE(ctx->leanIdle());
+  ctx->setLeanIdle(true);
+  EXPECT_TRUE(ctx->leanIdle());
+  EXPECT_TRUE(SSL_CTX_get_mode(ctx->raw()) & SSL_MODE_RELEASE_BUFFERS);
+  ctx->setLeanIdle(false);
+  EXPECT_FALSE(SSL_CTX_get_mode(ctx->raw()) & SSL_MODE_RELEASE_BUFFERS);
+}
+
+TEST(TlsRecordSizingTest, LargeWriteGrowsRecords)
+{
+  constexpr static auto Total = std::size_t(1) << 20;
+  constexpr static auto BoostAfter = std::size_t(64) << 10;
+  auto serverCtx = async::TlsContext::Create();
+  auto clientCtx = async::TlsContext::Create();
+  ASSERT_TRUE(serverCtx && clientCtx);
+  ASSERT_TRUE(UseSelfSigned(*serverCtx));
+  SSL_CTX_set_verify(clientCtx->raw(), SSL_VERIFY_NONE, nullptr);
+  SSL_CTX_set_num_tickets(serverCtx->raw(), 0); // session tickets would go out as application data records too
+  serverCtx->setRecordSizing({.enabled = true, .boostAfter = BoostAfter});
+  auto addr = async::SocketAddr(async::SocketAddrV4::Localhost(39611));
+  auto listener = async::SslListener::Bind(*serverCtx, RT::GetReactor(), addr);
+  ASSERT_TRUE(listener);
+
+  // the server writes everything with a single sendAll, the cold connection starts with small records
+  auto lengths = std::vector<std::size_t>();
+  RT::SpawnDetach([](async::SslListener& listener, async::TlsContext& ctx,
+                     std::vector<std::size_t>& lengths) -> async::Task<> {
+    auto socket = co_await listener.accept(ctx, nullptr);
+    EXPECT_TRUE(socket);
+    if (!socket) {
+      co_return;
+    }
+    RecordLengths(socket->ssl(), lengths);
+    auto data = std::vector<std::byte>(Total);
+    auto n = co_await socket->sendAll(data);
+    EXPECT_EQ(n.value_or(0), Total);
+  }(*listener, *serverCtx, lengths));
+
+  RT::Block([](async::TlsContext& ctx, async::SocketAddr addr) -> async::Task<> {
+    auto stream = co_await async::SslStream::Connect(ctx, RT::GetReactor(), addr);
+    EXPECT_TRUE(stream);
+    auto buf = std::array<std::byte, 16384> {};
+    for (std::size_t received = 0; stream && received < Total;) {
+      auto n = co_await stream->recv(buf);
+      if (!n && n.error().wait()) {
+        continue;
+      } else if (!n || *n == 0) {
+        break;
+      }
+      received += *n;
+    }
+  }(*clientCtx, addr));
+
+  // record headers count the tag and content type of the encrypted record on top of the plaintext
+  constexpr auto Overhead = std::size_t(256);
+  auto small = std::size_t(0);
+  auto large = std::size_t(0);
+  for (auto length : lengths) {
+    if (length <= 1400 + Overhead) {
+      EXPECT_EQ(large, 0) << "records shrank again within the write";
+      small++;
+    } else {
+      EXPECT_GT(length, std::size_t(SSL3_RT_MAX_PLAIN_LENGTH) - Overhead);
+      large++;
+    }
+  }
+  EXPECT_GE(small * 1400, BoostAfter);
+  EXPECT_LT((small - 1) * 1400, BoostAfter);
+  EXPECT_GT(large, 0);
+}
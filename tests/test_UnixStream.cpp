@@ -0,0 +1,190 @@
+#include <Async/Executor.hpp>
+#include <Async/UnixListener.hpp>
+#include <Async/UnixStream.hpp>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+
+namespace {
+struct Pipe {
+  int read = -1;
+  int write = -1;
+
+  Pipe()
+  {
+    int fds[2];
+    auto r = ::pipe2(fds, O_CLOEXEC | O_NONBLOCK);
+    assert(r == 0);
+    read = fds[0];
+    write = fds[1];
+  }
+  ~Pipe()
+  {
+    for (auto fd : {read, write}) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+  }
+};
+
+// Sends "ping" from a stream connected to `addr`, accepted from `listener`, and returns what arrived.
+auto Exchange(async::UnixListener& listener, async::SocketAddr const& addr) -> std::string
+{
+  auto received = std::string();
+  RT::SpawnDetach([](async::UnixListener& listener, std::string& received) -> async::Task<> {
+    auto accepted = co_await listener.accept(nullptr);
+    EXPECT_TRUE(accepted);
+    if (!accepted) {
+      co_return;
+    }
+    auto stream = async::UnixStream(std::move(accepted).value());
+    auto buf = std::array<std::byte, 16> {};
+    while (true) {
+      auto n = co_await stream.recv(buf);
+      if (!n || n.value() == 0) {
+        co_return;
+      }
+      received.append(reinterpret_cast<char const*>(buf.data()), std::size_t(n.value()));
+    }
+  }(listener, received));
+  RT::Block([](async::SocketAddr const& addr) -> async::Task<> {
+    auto stream = co_await async::UnixStream::Connect(RT::GetReactor(), addr);
+    EXPECT_TRUE(stream);
+    if (!stream) {
+      co_return;
+    }
+    auto n = co_await stream->send(std::as_bytes(std::span("ping"sv)));
+    EXPECT_EQ(n.value(), 4);
+    // wait for the accepting side to see the end of the stream
+    EXPECT_TRUE(stream->shutdownWrite());
+    auto buf = std::array<std::byte, 1> {};
+    auto eof = co_await stream->recv(buf);
+    EXPECT_EQ(eof.value(), 0);
+  }(addr));
+  return received;
+}
+} // namespace
+
+TEST(UnixStreamTest, PassedFdIsUsable)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto pipe = Pipe();
+  RT::Block([](async::UnixStream& a, async::UnixStream& b, Pipe& pipe) -> async::Task<> {
+    auto fds = std::array {pipe.write};
+    auto sent = co_await a.sendFds(std::as_bytes(std::span("x"sv)), fds);
+    EXPECT_EQ(sent.value(), 1);
+    // the receiver gets its own descriptor, the sender's copy can go
+    ::close(std::exchange(pipe.write, -1));
+
+    auto buf = std::array<std::byte, 8> {};
+    auto in = std::array<int, 4> {-1, -1, -1, -1};
+    auto received = co_await b.recvFds(buf, in);
+    EXPECT_TRUE(received);
+    if (!received) {
+      co_return;
+    }
+    EXPECT_EQ(received->bytes, 1);
+    EXPECT_EQ(received->fds, 1);
+    EXPECT_FALSE(received->truncated);
+    EXPECT_NE(::fcntl(in[0], F_GETFD) & FD_CLOEXEC, 0);
+    EXPECT_EQ(::write(in[0], "hello", 5), 5);
+    ::close(in[0]);
+    auto out = std::array<char, 8> {};
+    EXPECT_EQ(::read(pipe.read, out.data(), out.size()), 5);
+    EXPECT_EQ(std::string_view(out.data(), 5), "hello");
+    EXPECT_EQ(::read(pipe.read, out.data(), out.size()), 0); // no write end left open
+  }(pair->first, pair->second, pipe));
+}
+
+TEST(UnixStreamTest, ExcessFdsAreClosed)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto pipe = Pipe();
+  RT::Block([](async::UnixStream& a, async::UnixStream& b, Pipe& pipe) -> async::Task<> {
+    // more copies than the receiver has room for: the kernel drops those past the control buffer (MSG_CTRUNC) and
+    // recvFds closes those that fit the buffer but not the span
+    auto fds = std::array {pipe.write, pipe.write, pipe.write, pipe.write};
+    auto sent = co_await a.sendFds(std::as_bytes(std::span("x"sv)), fds);
+    EXPECT_EQ(sent.value(), 1);
+    ::close(std::exchange(pipe.write, -1));
+
+    auto buf = std::array<std::byte, 8> {};
+    auto in = std::array<int, 1> {-1};
+    auto received = co_await b.recvFds(buf, in);
+    EXPECT_TRUE(received);
+    if (!received) {
+      co_return;
+    }
+    EXPECT_EQ(received->bytes, 1);
+    EXPECT_EQ(received->fds, 1);
+    EXPECT_TRUE(received->truncated);
+    ::close(in[0]);
+    // end of file only once every copy of the write end is closed
+    auto out = std::array<char, 1> {};
+    EXPECT_EQ(::read(pipe.read, out.data(), out.size()), 0);
+  }(pair->first, pair->second, pipe));
+}
+
+TEST(UnixStreamTest, ListenerOnPath)
+{
+  auto path = std::filesystem::temp_directory_path() / ("asyncio_test_UnixStream." + std::to_string(::getpid()));
+  std::filesystem::remove(path);
+  auto addr = async::SocketAddr(async::SocketAddrUnix::Path(path.native()).value());
+  auto listener = async::UnixListener::Bind(RT::GetReactor(), addr);
+  ASSERT_TRUE(listener);
+  EXPECT_TRUE(std::filesystem::is_socket(path));
+  EXPECT_EQ(Exchange(*listener, addr), "ping");
+  // the path is taken until it is unlinked
+  EXPECT_EQ(async::UnixListener::Bind(RT::GetReactor(), addr).error(), std::errc::address_in_use);
+  std::filesystem::remove(path);
+}
+
+TEST(UnixStreamTest, ConnectFailsWhileBacklogIsFull)
+{
+  auto name = "asyncio_test_UnixStream.backlog." + std::to_string(::getpid());
+  auto addr = async::SocketAddr(async::SocketAddrUnix::Abstract(name).value());
+  auto options = async::SocketOptions {};
+  options.backlog = 0; // the kernel still queues one connection
+  auto listener = async::UnixListener::Bind(RT::GetReactor(), addr, options);
+  ASSERT_TRUE(listener);
+  RT::Block([](async::SocketAddr const& addr) -> async::Task<> {
+    auto queued = co_await async::UnixStream::Connect(RT::GetReactor(), addr);
+    EXPECT_TRUE(queued);
+    // nothing accepts, so the next one fails instead of waiting for a writability that never comes
+    auto refused = co_await async::UnixStream::Connect(RT::GetReactor(), addr);
+    EXPECT_FALSE(refused);
+    if (!refused) {
+      EXPECT_EQ(refused.error(), std::errc::resource_unavailable_try_again);
+    }
+  }(addr));
+}
+
+TEST(UnixStreamTest, ListenerOnAbstractName)
+{
+  auto name = "asyncio_test_UnixStream." + std::to_string(::getpid());
+  auto addr = async::SocketAddr(async::SocketAddrUnix::Abstract(name).value());
+  auto listener = async::UnixListener::Bind(RT::GetReactor(), addr);
+  ASSERT_TRUE(listener);
+  // nothing shows up in the filesystem
+  EXPECT_FALSE(std::filesystem::exists(std::filesystem::current_path() / name));
+  EXPECT_EQ(Exchange(*listener, addr), "ping");
+
+  // a filesystem path of the same name is a different address
+  auto path = async::SocketAddr(async::SocketAddrUnix::Path(name).value());
+  RT::Block([](async::SocketAddr const& addr) -> async::Task<> {
+    auto stream = co_await async::UnixStream::Connect(RT::GetReactor(), addr);
+    EXPECT_FALSE(stream);
+    if (!stream) {
+      EXPECT_EQ(stream.error(), std::errc::no_such_file_or_directory);
+    }
+  }(path));
+}
@@ -0,0 +1,292 @@
+#include <Async/Executor.hpp>
+#include <Async/UnixStream.hpp>
+#include <Async/http/WebSocket.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using RT = async::Runtime<async::InlineExecutor>;
+using namespace std::literals;
+namespace ws = async::http::ws;
+using async::http::ParseStatus;
+
+TEST(WebSocketTest, AcceptKey)
+{
+  // the example of RFC 6455 section 1.3
+  EXPECT_EQ(ws::AcceptKey("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocketTest, HeaderRoundTrip)
+{
+  for (auto length : {std::uint64_t(0), std::uint64_t(125), std::uint64_t(126), std::uint64_t(65535),
+                      std::uint64_t(65536), std::uint64_t(1) << 40}) {
+    auto in = ws::FrameHeader {false, ws::Opcode::Text, true, {std::byte(1), std::byte(2), std::byte(3)}, length};
+    auto buf = std::array<std::byte, ws::MaxHeaderSize> {};
+    auto size = ws::EncodeHeader(in, buf);
+    for (std::size_t i = 0; i < size; i++) {
+      auto partial = ws::FrameHeader {};
+      EXPECT_EQ(ws::DecodeHeader(std::span(buf).first(i), partial).status, ParseStatus::Incomplete) << length;
+    }
+    auto out = ws::FrameHeader {};
+    auto r = ws::DecodeHeader(buf, out);
+    ASSERT_EQ(r.status, ParseStatus::Complete);
+    EXPECT_EQ(r.consumed, size);
+    EXPECT_EQ(out.length, length);
+    EXPECT_EQ(out.fin, false);
+    EXPECT_EQ(out.opcode, ws::Opcode::Text);
+    EXPECT_EQ(out.mask, in.mask);
+  }
+}
+
+TEST(WebSocketTest, MalformedHeaders)
+{
+  auto header = ws::FrameHeader {};
+  for (auto bytes : {"\xc1\x00"sv, "\x83\x00"sv, "\x09\x00"sv, "\x89\x7e\x00\x7e"sv,
+                     "\x82\x7f\x80\x00\x00\x00\x00\x00\x00\x00"sv}) {
+    EXPECT_EQ(ws::DecodeHeader(std::as_bytes(std::span(bytes)), header).status, ParseStatus::Error);
+  }
+}
+
+TEST(WebSocketTest, MaskMatchesScalar)
+{
+  auto mask = std::array {std::byte(0x12), std::byte(0x34), std::byte(0x56), std::byte(0x78)};
+  for (std::size_t size = 0; size < 200; size += 7) {
+    for (std::size_t offset = 0; offset < 4; offset++) {
+      auto data = std::vector<std::byte>(size);
+      for (std::size_t i = 0; i < size; i++) {
+        data[i] = std::byte(i * 31);
+      }
+      auto expected = data;
+      for (std::size_t i = 0; i < size; i++) {
+        expected[i] ^= mask[(offset + i) % 4];
+      }
+      ws::ApplyMask(std::span(data).subspan(0), mask, offset);
+      EXPECT_EQ(data, expected) << size << " " << offset;
+    }
+  }
+}
+
+TEST(WebSocketTest, EchoOverStream)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  RT::SpawnDetach([](async::UnixStream stream) -> async::Task<> {
+    auto socket = co_await async::http::AcceptWebSocket(std::move(stream));
+    if (!socket) {
+      co_return;
+    }
+    while (true) {
+      auto message = co_await socket->receive();
+      if (!message || message->opcode == ws::Opcode::Close) {
+        co_return;
+      }
+      if (!co_await socket->send(message->data, message->opcode)) {
+        co_return;
+      }
+    }
+  }(std::move(pair->first)));
+
+  RT::Block([](async::UnixStream stream) -> async::Task<> {
+    auto socket = co_await async::http::ConnectWebSocket(std::move(stream), "localhost", "/echo");
+    EXPECT_TRUE(socket);
+    if (!socket) {
+      co_return;
+    }
+    EXPECT_TRUE(co_await socket->sendText("hello"));
+    auto message = co_await socket->receive();
+    EXPECT_EQ(message->opcode, ws::Opcode::Text);
+    EXPECT_EQ(message->text(), "hello");
+
+    // a fragmented message with a ping in between comes back whole, after the pong
+    auto large = std::string(100000, 'x');
+    auto bytes = std::as_bytes(std::span(large));
+    EXPECT_TRUE(co_await socket->send(bytes.first(70000), ws::Opcode::Binary, false));
+    EXPECT_TRUE(co_await socket->ping(std::as_bytes(std::span("p"sv))));
+    EXPECT_TRUE(co_await socket->send(bytes.subspan(70000), ws::Opcode::Continuation, true));
+    message = co_await socket->receive();
+    EXPECT_EQ(message->opcode, ws::Opcode::Binary);
+    EXPECT_EQ(message->text(), large);
+
+    EXPECT_TRUE(co_await socket->close());
+    message = co_await socket->receive();
+    EXPECT_EQ(message->opcode, ws::Opcode::Close);
+  }(std::move(pair->second)));
+}
+
+namespace {
+// A frame as a client sends it, masked.
+auto ClientFrame(ws::Opcode opcode, std::string_view payload, bool fin = true) -> std::string
+{
+  auto header = ws::FrameHeader {fin, opcode, true, {std::byte(7), std::byte(1), std::byte(9), std::byte(4)},
+                                 payload.size()};
+  auto head = std::array<std::byte, ws::MaxHeaderSize> {};
+  auto size = ws::EncodeHeader(header, head);
+  auto frame = std::string(reinterpret_cast<char const*>(head.data()), size);
+  frame += payload;
+  ws::ApplyMask(std::as_writable_bytes(std::span(frame)).subspan(size), header.mask);
+  return frame;
+}
+
+struct Received {
+  std::vector<std::string> texts;
+  std::errc error {};
+  std::uint16_t closeCode = 0; // of the Close frame the server sent, if any
+};
+
+// Writes `frames` to a server-side WebSocket at once and receives until it fails or gets a Close.
+auto Receive(std::string const& frames) -> Received
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  assert(pair);
+  auto peer = std::move(pair->second);
+  auto socket = async::http::WebSocket<async::UnixStream>(std::move(pair->first), ws::Role::Server);
+  for (auto pending = std::string_view(frames); !pending.empty();) {
+    auto n = ::write(peer.getSocket().raw(), pending.data(), pending.size());
+    assert(n > 0);
+    pending.remove_prefix(std::size_t(n));
+  }
+  auto received = Received {};
+  RT::Block([](async::http::WebSocket<async::UnixStream>& socket, Received& received) -> async::Task<> {
+    while (true) {
+      auto message = co_await socket.receive();
+      if (!message) {
+        received.error = message.error();
+        co_return;
+      } else if (message->opcode == ws::Opcode::Close) {
+        co_return;
+      }
+      received.texts.emplace_back(message->text());
+    }
+  }(socket, received));
+
+  auto out = std::array<std::byte, 256> {};
+  auto n = ::read(peer.getSocket().raw(), out.data(), out.size());
+  auto header = ws::FrameHeader {};
+  if (n > 0) {
+    auto r = ws::DecodeHeader(std::span(out).first(std::size_t(n)), header);
+    if (r.status == ParseStatus::Complete && header.opcode == ws::Opcode::Close && header.length >= 2) {
+      received.closeCode = std::uint16_t(std::to_integer<int>(out[r.consumed]) << 8 |
+                                         std::to_integer<int>(out[r.consumed + 1]));
+    }
+  }
+  return received;
+}
+
+auto CloseFrame(std::uint16_t code, std::string_view reason) -> std::string
+{
+  auto payload = std::string {char(code >> 8), char(code & 0xff)};
+  return ClientFrame(ws::Opcode::Close, payload + std::string(reason));
+}
+} // namespace
+
+TEST(WebSocketTest, ValidUtf8)
+{
+  auto valid = [](std::string_view text) { return ws::ValidUtf8(std::as_bytes(std::span(text))); };
+  EXPECT_TRUE(valid(""));
+  EXPECT_TRUE(valid("plain ascii that is longer than one word"));
+  EXPECT_TRUE(valid("\xc2\xa2 \xe2\x82\xac \xed\x9f\xbf \xf0\x90\x8d\x88 \xf4\x8f\xbf\xbf"));
+  EXPECT_FALSE(valid("\x80"));             // continuation without a lead
+  EXPECT_FALSE(valid("\xc0\xaf"));         // overlong '/'
+  EXPECT_FALSE(valid("\xe0\x9f\xbf"));     // overlong three bytes
+  EXPECT_FALSE(valid("\xed\xa0\x80"));     // surrogate
+  EXPECT_FALSE(valid("\xf4\x90\x80\x80")); // past U+10FFFF
+  EXPECT_FALSE(valid("\xf5\x80\x80\x80"));
+  EXPECT_FALSE(valid("abcdefgh\xe2\x82")); // truncated after an ascii run
+  EXPECT_FALSE(valid("\xe2\x28\xa1"));     // bad continuation
+}
+
+TEST(WebSocketTest, InvalidUtf8TextFails)
+{
+  for (auto text : {"\xc0\xaf"sv, "ok \xed\xa0\x80"sv, "\xf4\x90\x80\x80"sv, "\xe2\x82"sv}) {
+    auto received = Receive(ClientFrame(ws::Opcode::Text, text));
+    EXPECT_EQ(received.error, std::errc::illegal_byte_sequence);
+    EXPECT_EQ(received.closeCode, ws::CloseInvalidData);
+  }
+  // binary messages carry anything
+  auto received = Receive(ClientFrame(ws::Opcode::Binary, "\xc0\xaf") + CloseFrame(ws::CloseNormal, ""));
+  EXPECT_EQ(received.texts, std::vector<std::string> {"\xc0\xaf"});
+  EXPECT_EQ(received.error, std::errc {});
+}
+
+TEST(WebSocketTest, FragmentedTextIsValidatedWhole)
+{
+  // the euro sign split across fragments is fine, a fragment ending in a truncated sequence is not
+  auto received = Receive(ClientFrame(ws::Opcode::Text, "1 \xe2", false) +
+                          ClientFrame(ws::Opcode::Continuation, "\x82\xac") + CloseFrame(ws::CloseNormal, "bye"));
+  EXPECT_EQ(received.texts, std::vector<std::string> {"1 \xe2\x82\xac"});
+  EXPECT_EQ(received.error, std::errc {});
+  EXPECT_EQ(received.closeCode, ws::CloseNormal);
+
+  received = Receive(ClientFrame(ws::Opcode::Text, "1 \xe2", false) + ClientFrame(ws::Opcode::Continuation, "\x82"));
+  EXPECT_EQ(received.error, std::errc::illegal_byte_sequence);
+  EXPECT_EQ(received.closeCode, ws::CloseInvalidData);
+}
+
+TEST(WebSocketTest, MalformedCloseFails)
+{
+  auto received = Receive(ClientFrame(ws::Opcode::Close, "\x03"));
+  EXPECT_EQ(received.error, std::errc::protocol_error);
+  EXPECT_EQ(received.closeCode, ws::CloseProtocolError);
+
+  received = Receive(CloseFrame(ws::CloseGoingAway, "\xff"));
+  EXPECT_EQ(received.error, std::errc::illegal_byte_sequence);
+  EXPECT_EQ(received.closeCode, ws::CloseInvalidData);
+
+  // an empty Close is answered with an empty Close
+  received = Receive(ClientFrame(ws::Opcode::Close, ""));
+  EXPECT_EQ(received.error, std::errc {});
+  EXPECT_EQ(received.closeCode, 0);
+}
+
+TEST(WebSocketTest, ReservedCloseCodeFails)
+{
+  for (auto code : {0, 999, 1004, 1005, 1006, 1015, 2000, 2999, 5000}) {
+    auto received = Receive(CloseFrame(std::uint16_t(code), ""));
+    EXPECT_EQ(received.error, std::errc::protocol_error) << code;
+    EXPECT_EQ(received.closeCode, ws::CloseProtocolError) << code;
+  }
+  for (auto code : {1000, 1003, 1007, 1014, 3000, 4999}) {
+    auto received = Receive(CloseFrame(std::uint16_t(code), ""));
+    EXPECT_EQ(received.error, std::errc {}) << code;
+    EXPECT_EQ(received.closeCode, code);
+  }
+}
+
+TEST(WebSocketTest, NoPongAfterOwnClose)
+{
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto peer = std::move(pair->second);
+  auto socket = async::http::WebSocket<async::UnixStream>(std::move(pair->first), ws::Role::Server);
+  auto frames = ClientFrame(ws::Opcode::Ping, "late") + CloseFrame(ws::CloseNormal, "");
+  ASSERT_EQ(::write(peer.getSocket().raw(), frames.data(), frames.size()), ssize_t(frames.size()));
+  RT::Block([](async::http::WebSocket<async::UnixStream>& socket) -> async::Task<> {
+    EXPECT_TRUE(co_await socket.close(ws::CloseGoingAway));
+    auto message = co_await socket.receive();
+    EXPECT_TRUE(message && message->opcode == ws::Opcode::Close);
+  }(socket));
+
+  // our Close and nothing after it: neither a pong nor a second Close
+  auto out = std::array<std::byte, 256> {};
+  auto n = ::read(peer.getSocket().raw(), out.data(), out.size());
+  ASSERT_EQ(n, 4);
+  auto header = ws::FrameHeader {};
+  EXPECT_EQ(ws::DecodeHeader(std::span(out).first(4), header).status, ParseStatus::Complete);
+  EXPECT_EQ(header.opcode, ws::Opcode::Close);
+}
+
+TEST(WebSocketTest, ManyBufferedMessages)
+{
+  // more messages than fit the read buffer at once, so fill() has to move the partial frame at its end
+  auto frames = std::string();
+  auto expected = std::vector<std::string>();
+  for (std::size_t i = 0; i < 1000; i++) {
+    expected.push_back(std::string(i % 97, char('a' + i % 26)));
+    frames += ClientFrame(ws::Opcode::Text, expected.back());
+  }
+  frames += CloseFrame(ws::CloseNormal, "");
+  auto received = Receive(frames);
+  EXPECT_EQ(received.error, std::errc {});
+  EXPECT_EQ(received.texts, expected);
+  EXPECT_EQ(received.closeCode, ws::CloseNormal);
+}
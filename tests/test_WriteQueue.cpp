@@ -0,0 +1,142 @@
+#include <Async/Executor.hpp>
+#include <Async/UnixStream.hpp>
+#include <Async/WriteQueue.hpp>
+#include <gtest/gtest.h>
+
+#include <optional>
+
+using RT = async::Runtime<async::InlineExecutor>;
+
+TEST(WriteQueueTest, BoundedBySlowReader)
+{
+  constexpr auto MessageSize = std::size_t(32 << 10);
+  constexpr auto Messages = 64;
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto queue = async::WriteQueue(writer, {.highWatermark = 128 << 10, .lowWatermark = 32 << 10});
+
+  auto finished = 0;
+  for (int producer = 0; producer < 2; producer++) {
+    RT::SpawnDetach([](async::WriteQueue& queue, int producer, int& finished) -> async::Task<> {
+      auto message = std::vector<std::byte>(MessageSize);
+      for (int i = 0; i < Messages / 2; i++) {
+        std::fill(message.begin(), message.end(), std::byte(producer * Messages / 2 + i));
+        auto r = co_await queue.write(message);
+        EXPECT_TRUE(r);
+      }
+      finished++;
+    }(queue, producer, finished));
+  }
+
+  auto maxQueued = std::size_t(0);
+  auto received = std::vector<std::byte>();
+  RT::Block([](async::UnixStream& reader, async::WriteQueue& queue, std::size_t& maxQueued,
+               std::vector<std::byte>& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 4096> {};
+    while (received.size() < MessageSize * Messages) {
+      maxQueued = std::max(maxQueued, queue.queued());
+      auto n = co_await reader.recv(buf);
+      if (!n || *n == 0) {
+        break;
+      }
+      received.insert(received.end(), buf.begin(), buf.begin() + *n);
+    }
+  }(reader, queue, maxQueued, received));
+
+  EXPECT_EQ(finished, 2);
+  EXPECT_EQ(queue.queued(), 0);
+  EXPECT_LE(maxQueued, (128 << 10) + MessageSize);
+  ASSERT_EQ(received.size(), MessageSize * Messages);
+  for (std::size_t i = 0; i < received.size(); i += MessageSize) { // messages stay whole
+    EXPECT_TRUE(std::all_of(&received[i], &received[i] + MessageSize, [&](auto b) { return b == received[i]; }));
+  }
+}
+
+TEST(WriteQueueTest, WriterReturnsOnceItsBatchIsOut)
+{
+  constexpr auto Large = std::size_t(1) << 20; // more than the socket buffer takes, so the writer has to wait
+  constexpr auto Small = 400;
+  constexpr auto SmallSize = std::size_t(4096);
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto queue = async::WriteQueue(writer, {.highWatermark = 4 << 20, .lowWatermark = 1 << 20});
+
+  auto received = std::vector<std::byte>();
+  auto receivedWhenWritten = std::optional<std::size_t>();
+  auto receivedWhenFlushed = std::optional<std::size_t>();
+  RT::SpawnDetach([](async::WriteQueue& queue, std::vector<std::byte>& received,
+                     std::optional<std::size_t>& receivedWhenWritten,
+                     std::optional<std::size_t>& receivedWhenFlushed) -> async::Task<> {
+    EXPECT_TRUE(co_await queue.write(std::vector<std::byte>(Large, std::byte(1))));
+    receivedWhenWritten = received.size();
+    EXPECT_TRUE(co_await queue.flush());
+    receivedWhenFlushed = received.size();
+  }(queue, received, receivedWhenWritten, receivedWhenFlushed));
+  // queued behind the large message while the writer waits
+  for (int i = 0; i < Small; i++) {
+    RT::SpawnDetach([](async::WriteQueue& queue) -> async::Task<> {
+      EXPECT_TRUE(co_await queue.write(std::vector<std::byte>(SmallSize, std::byte(2))));
+    }(queue));
+  }
+
+  RT::Block([](async::UnixStream& reader, std::vector<std::byte>& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    while (received.size() < Large + Small * SmallSize) {
+      auto n = co_await reader.recv(buf);
+      if (!n || *n == 0) {
+        break;
+      }
+      received.insert(received.end(), buf.begin(), buf.begin() + *n);
+    }
+  }(reader, received));
+
+  EXPECT_EQ(received.size(), Large + Small * SmallSize);
+  // the writer left once the large message was out, the queue's drain task wrote the rest before flush returned
+  ASSERT_TRUE(receivedWhenWritten);
+  EXPECT_LE(*receivedWhenWritten, Large);
+  ASSERT_TRUE(receivedWhenFlushed);
+  EXPECT_GT(*receivedWhenFlushed, *receivedWhenWritten);
+  EXPECT_EQ(queue.queued(), 0);
+}
+
+TEST(WriteQueueTest, DestroyedWhileDraining)
+{
+  constexpr auto Large = std::size_t(1) << 20;
+  constexpr auto Small = 100;
+  constexpr auto SmallSize = std::size_t(4096);
+  auto pair = async::UnixStream::Pair(RT::GetReactor());
+  ASSERT_TRUE(pair);
+  auto& [writer, reader] = pair.value();
+  auto queue = std::optional<async::WriteQueue>();
+  queue.emplace(writer, async::WatermarkOptions {.highWatermark = 4 << 20, .lowWatermark = 1 << 20});
+
+  auto destroyed = false;
+  RT::SpawnDetach([](std::optional<async::WriteQueue>& queue, bool& destroyed) -> async::Task<> {
+    EXPECT_TRUE(co_await queue->write(std::vector<std::byte>(Large, std::byte(1))));
+    // the small messages are still queued for the drain task, which keeps them alive past the queue
+    queue.reset();
+    destroyed = true;
+  }(queue, destroyed));
+  for (int i = 0; i < Small; i++) {
+    RT::SpawnDetach([](async::WriteQueue& queue) -> async::Task<> {
+      EXPECT_TRUE(co_await queue.write(std::vector<std::byte>(SmallSize, std::byte(2))));
+    }(*queue));
+  }
+
+  auto received = std::size_t(0);
+  RT::Block([](async::UnixStream& reader, std::size_t& received) -> async::Task<> {
+    auto buf = std::array<std::byte, 8192> {};
+    while (received < Large + Small * SmallSize) {
+      auto n = co_await reader.recv(buf);
+      if (!n || *n == 0) {
+        break;
+      }
+      received += std::size_t(*n);
+    }
+  }(reader, received));
+
+  EXPECT_TRUE(destroyed);
+  EXPECT_EQ(received, Large + Small * SmallSize);
+}